@@ -9,10 +9,12 @@
 #define LINDORMTSDBCONTESTCPP_TSDBENGINEIMPL_H
 
 #include <unordered_map>
+#include <memory>
 #include <mutex>
 #include "TSDBEngine.hpp"
 #include "db/background.h"
 #include "db/table.h"
+#include "db/manifest.h"
 
 namespace LindormContest {
 
@@ -40,13 +42,34 @@ public:
     ~TSDBEngineImpl() override;
 
 private:
+    using TableMap = std::unordered_map<std::string, Table*>;
+
+    // 要求：持有锁, 回放的表加入 tables 中
+    auto RecoverLogFiles(TableMap &tables) -> int;
+
+    // 回放 manifest_log 中的一条 record
+    void ApplyManifestRecord(TableMap &tables, ManifestRecordType type, const std::string &table_name,
+                             std::string_view body);
+
+    // 写入所有表的元数据快照, 清空 manifest_log
+    void WriteManifestSnapshot(const TableMap &tables);
+
+    // 读取 tables_ 的快照, 不需要加锁
+    auto GetTable(const std::string &table_name) const -> Table*;
+
     std::string db_directory_;
     DBOptions *db_option_{};
 
+    // 记录 flush 与 compaction 产生的元数据变更, 见 Manifest
+    std::unique_ptr<Manifest> manifest_;
+
     std::atomic_bool shutdown_{false};
 
+    // 只用于串行化 tables_ 的修改
     std::mutex mutex_;
-    std::unordered_map<std::string, Table*> tables_;
+    // copy-on-write: 修改时复制一份新的 map 再原子地替换, 读取时原子地取得快照
+    // 表只会增加, 不会删除, Table 对象在析构前一直有效
+    std::shared_ptr<const TableMap> tables_{std::make_shared<const TableMap>()};
 }; // End class TSDBEngineImpl.
 
 }; // End namespace LindormContest.
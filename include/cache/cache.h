@@ -45,6 +45,11 @@ namespace LindormContest {
         // 设置 lru 的容量
         void SetCapacity(uint64_t capacity) { capacity_ = capacity; }
 
+        auto GetUsage() -> uint64_t {
+            std::scoped_lock<std::mutex> lock(mutex_);
+            return usage_;
+        }
+
         // 插入一个新的节点到 lru 中, 返回该节点的指针
         // 如果 key 已经存在, 不会真正写入到 lru
         // deleter 用于释放 value 的内存, 如果为 nullptr, 则使用 free
@@ -97,6 +102,11 @@ namespace LindormContest {
             assert(handle->refs_ > 0);
             handle->refs_--;
             if (handle->refs_ == 0) {
+                // 已经被 Erase 或重复插入的节点不在 table_ 中, 直接释放
+                if (!handle->in_hash_table_) {
+                    delete handle;
+                    return;
+                }
                 LruAppend(&lru_, handle);
             }
 
@@ -109,6 +119,23 @@ namespace LindormContest {
             }
         }
 
+        // 从 lru 中删除 key, 仍被引用的节点在最后一次 Release 时释放
+        auto Erase(uint64_t key) -> void {
+            std::scoped_lock<std::mutex> lock(mutex_);
+            auto it = table_.find(key);
+            if (it == table_.end()) {
+                return;
+            }
+            auto handle = it->second;
+            table_.erase(it);
+            usage_ -= handle->charge_;
+            handle->in_hash_table_ = false;
+            if (handle->refs_ == 0) {
+                LruRemove(handle);
+                delete handle;
+            }
+        }
+
     private:
         // 将 e 从 lru 中移除
         auto LruRemove(CacheHandle<T> *e) -> void {
@@ -160,6 +187,19 @@ namespace LindormContest {
             cache_[Hash(handle->cache_id_)].Release(handle);
         }
 
+        auto Erase(uint64_t key) -> void {
+            cache_[Hash(key)].Erase(key);
+        }
+
+        // 所有分片的计费总和
+        auto GetUsage() -> uint64_t {
+            uint64_t usage = 0;
+            for(auto &cache : cache_) {
+                usage += cache.GetUsage();
+            }
+            return usage;
+        }
+
     private:
         auto Hash(uint64_t key) -> size_t { return hasher_(key) % 16; }
 
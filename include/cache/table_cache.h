@@ -7,6 +7,7 @@
 
 namespace LindormContest {
 
+struct DBOptions;
 
 // 维护 SSTable 资源的 Cache
 class TableCache {
@@ -23,17 +24,39 @@ private:
     };
 
 public:
-    explicit TableCache(size_t max_file_number, Cache<Block> *block_cache = nullptr) : cache_(max_file_number), block_cache_(block_cache) {}
+    // 打开 sstable 时按 options 的 block_cache_, use_mmap_reads_ 与 use_direct_io_ 创建 SSTable
+    TableCache(size_t max_file_number, const DBOptions *options) : options_(options), cache_(max_file_number) {}
 
     void AddSSTable(std::unique_ptr<SSTable> sstable);
 
-    // 为 SSTable 创建一个迭代器
-    auto NewTableIterator(const FileMetaDataPtr& file_meta_data) -> std::unique_ptr<Iterator>;
+    // 为 SSTable 创建一个迭代器, column_mask 为 nullptr 时读取所有列
+    auto NewTableIterator(const FileMetaDataPtr& file_meta_data, const ColumnMask *column_mask = nullptr) -> std::unique_ptr<Iterator>;
+
+    // 只读取可能包含 [lower, upper] 内 key 的 block, 见 SSTable::NewRangeIterator
+    auto NewTableRangeIterator(const FileMetaDataPtr& file_meta_data, const InternalKey &lower, const InternalKey &upper,
+                               const ColumnMask *column_mask = nullptr) -> std::unique_ptr<Iterator>;
+
+    // 批量读取每个 SSTable 中对应 vin 最新一行所在的 block 并放入 block cache, 所有读取一次提交
+    void PrefetchBlocks(const std::vector<std::pair<FileMetaDataPtr, std::vector<Vin>>> &files,
+                        const ColumnMask *column_mask = nullptr);
+
+    // 通过 SSTable 的布隆过滤器判断是否可能包含 vin, 不读取 data block
+    auto MayContain(const FileMetaDataPtr& file_meta_data, const Vin &vin) -> bool;
+
+    // 筛选出 SSTable 可能包含的 vin, 只查找一次 SSTable
+    void FilterVins(const FileMetaDataPtr& file_meta_data, const std::vector<Vin> &vins, std::vector<Vin> *result);
+
+    // 见 SSTable::GetBlockKeys
+    void GetBlockKeys(const FileMetaDataPtr& file_meta_data, std::vector<InternalKey> *keys);
+
+    // 从 TableCache 与 block cache 中删除 sstable, 正在使用的迭代器不受影响
+    // sstable 不在 TableCache 中时不打开文件, 只依靠 LRU 淘汰 block
+    void EvictSSTable(const FileMetaData &file_meta_data);
 
 private:
-    auto FindTable(const FileMetaDataPtr& file_meta_data) -> CacheHandle<SSTable>*;
+    auto FindTable(const FileMetaData &file_meta_data) -> CacheHandle<SSTable>*;
 
-    Cache<Block> *block_cache_;
+    const DBOptions *options_;
 
     std::mutex mutex_;
     Cache<SSTable> cache_;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "struct/ColumnValue.h"
+
+namespace LindormContest {
+
+// 列式 sstable 中 chunk 的编码方式
+enum class CodecType : uint8_t {
+    SNAPPY = 0,             // 通用压缩
+    DELTA_VARINT = 1,       // int: 与前一个值的差值, zigzag + varint
+    GORILLA = 2,            // double: 与前一个值异或, 只保存有效位
+    DICTIONARY_RLE = 3,     // string: 字典 + 游程编码
+    KEY_DELTA = 4,          // key chunk: vin 游程编码, timestamp delta-of-delta
+};
+
+// chunk 的编解码
+// 未编码的 chunk 格式见 sstable/row_group.h, 编码后为 | codec (1) | payload |
+// 每个 chunk 取前 K_SAMPLE_ROWS 行分别用 snappy 和对应类型的专用编码压缩, 选择结果较小的一种
+// key chunk 以 COLUMN_TYPE_UNINITIALIZED 作为 type
+class ColumnCodec {
+public:
+    static constexpr uint32_t K_SAMPLE_ROWS = 256;
+
+    static void EncodeColumnChunk(ColumnType type, const std::string &chunk, std::string *dst);
+
+    static auto DecodeColumnChunk(ColumnType type, const char *data, size_t size, std::string *chunk) -> bool;
+
+    // 解码后 chunk 的长度, 用于预先分配解码的 buffer
+    static auto GetColumnChunkLength(ColumnType type, const char *data, size_t size, size_t *length) -> bool;
+
+    // 解码到长度为 length 的 buffer 中, length 由 GetColumnChunkLength 得到
+    static auto DecodeColumnChunk(ColumnType type, const char *data, size_t size, char *chunk, size_t length) -> bool;
+
+    static void EncodeKeyChunk(const std::string &chunk, std::string *dst);
+
+    static auto DecodeKeyChunk(const char *data, size_t size, std::string *chunk) -> bool;
+
+    static auto GetKeyChunkLength(const char *data, size_t size, size_t *length) -> bool;
+
+    static auto DecodeKeyChunk(const char *data, size_t size, char *chunk, size_t length) -> bool;
+
+    // 使用指定的编码方式, codec 不适用于 type 时返回 false
+    static auto EncodeColumnChunk(ColumnType type, CodecType codec, const std::string &chunk, std::string *dst) -> bool;
+
+    static auto ChooseCodec(ColumnType type, const std::string &chunk) -> CodecType;
+};
+
+}  // namespace LindormContest
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "db/format.h"
+#include "struct/ColumnValue.h"
+
+namespace LindormContest {
+
+using ColumnMask = std::vector<bool>;
+
+// 返回 p 处一个 value 的编码长度
+// value 的编码与 CodingUtil::DecodeRow 一致: int 4 字节, double 8 字节, string | length (4) | data |
+inline auto ColumnValueSize(ColumnType type, const char *p) -> uint32_t {
+    switch(type) {
+        case COLUMN_TYPE_INTEGER:
+            return 4;
+        case COLUMN_TYPE_DOUBLE_FLOAT:
+            return 8;
+        case COLUMN_TYPE_STRING:
+            return 4 + *reinterpret_cast<const uint32_t *>(p);
+        default:
+            return 0;
+    }
+}
+
+// 一列的值, 按类型只使用其中一个数组
+// 第 i 个 string 为 strings_[offsets_[i], offsets_[i + 1])
+struct ColumnVector {
+    ColumnType type_{COLUMN_TYPE_UNINITIALIZED};
+
+    // 未读取的列不保存任何值
+    bool read_{true};
+
+    std::vector<int32_t> ints_;
+    std::vector<double> doubles_;
+    std::string strings_;
+    std::vector<uint32_t> offsets_{0};
+
+    void Clear() {
+        ints_.clear();
+        doubles_.clear();
+        strings_.clear();
+        offsets_.resize(1);
+    }
+
+    // 追加 p 处编码的一个 value
+    void Append(const char *p) {
+        switch(type_) {
+            case COLUMN_TYPE_INTEGER: {
+                int32_t value;
+                std::memcpy(&value, p, sizeof(value));
+                ints_.push_back(value);
+                break;
+            }
+            case COLUMN_TYPE_DOUBLE_FLOAT: {
+                double value;
+                std::memcpy(&value, p, sizeof(value));
+                doubles_.push_back(value);
+                break;
+            }
+            case COLUMN_TYPE_STRING: {
+                strings_.append(p + 4, ColumnValueSize(type_, p) - 4);
+                offsets_.push_back(static_cast<uint32_t>(strings_.size()));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // 追加 count 个连续编码的定长 value
+    void AppendFixed(const char *p, uint32_t count) {
+        if(type_ == COLUMN_TYPE_INTEGER) {
+            auto size = ints_.size();
+            ints_.resize(size + count);
+            std::memcpy(ints_.data() + size, p, count * sizeof(int32_t));
+        } else if(type_ == COLUMN_TYPE_DOUBLE_FLOAT) {
+            auto size = doubles_.size();
+            doubles_.resize(size + count);
+            std::memcpy(doubles_.data() + size, p, count * sizeof(double));
+        }
+    }
+
+    // 追加一个默认值: 0 或空字符串
+    void AppendDefault() {
+        switch(type_) {
+            case COLUMN_TYPE_INTEGER:
+                ints_.push_back(0);
+                break;
+            case COLUMN_TYPE_DOUBLE_FLOAT:
+                doubles_.push_back(0);
+                break;
+            case COLUMN_TYPE_STRING:
+                offsets_.push_back(static_cast<uint32_t>(strings_.size()));
+                break;
+            default:
+                break;
+        }
+    }
+
+    auto GetValue(size_t i) const -> ColumnValue {
+        switch(type_) {
+            case COLUMN_TYPE_INTEGER:
+                return ColumnValue(ints_[i]);
+            case COLUMN_TYPE_DOUBLE_FLOAT:
+                return ColumnValue(doubles_[i]);
+            default:
+                return ColumnValue(strings_.data() + offsets_[i], static_cast<int32_t>(offsets_[i + 1] - offsets_[i]));
+        }
+    }
+};
+
+// 按列存放的一批连续的行, 由 Iterator::NextBatch 填充, 清空后可以重复使用而不重新分配内存
+// 列按 schema 的顺序排列, 只保存 column mask 中需要读取的列
+class ColumnBatch {
+public:
+    explicit ColumnBatch() = default;
+
+    // column_mask 为 nullptr 时读取所有列
+    void Init(const std::vector<ColumnType> &column_types, const ColumnMask *column_mask) {
+        columns_.resize(column_types.size());
+        for(size_t i = 0; i < column_types.size(); i++) {
+            columns_[i].type_ = column_types[i];
+            columns_[i].read_ = column_mask == nullptr || (*column_mask)[i];
+        }
+        Clear();
+    }
+
+    void Clear() {
+        vins_.clear();
+        timestamps_.clear();
+        for(auto &column : columns_) {
+            column.Clear();
+        }
+    }
+
+    auto Size() const -> size_t { return timestamps_.size(); }
+
+    void AppendKey(const InternalKey &key) {
+        vins_.push_back(key.vin_);
+        timestamps_.push_back(key.timestamp_);
+    }
+
+    // 追加一行, value 为按 schema 顺序编码的所有列
+    void AppendRow(const InternalKey &key, const char *value) {
+        AppendKey(key);
+        for(auto &column : columns_) {
+            if(column.read_) {
+                column.Append(value);
+            }
+            value += ColumnValueSize(column.type_, value);
+        }
+    }
+
+    // 将第 i 行转换为 Row, schema 与 Init 时的列类型一致
+    void GetRow(size_t i, const Schema &schema, Row *row) const {
+        row->vin = vins_[i];
+        row->timestamp = timestamps_[i];
+        size_t idx = 0;
+        for(auto &column : schema.columnTypeMap) {
+            if(columns_[idx].read_) {
+                row->columns.emplace(column.first, columns_[idx].GetValue(i));
+            }
+            idx++;
+        }
+    }
+
+    std::vector<Vin> vins_;
+    std::vector<int64_t> timestamps_;
+    std::vector<ColumnVector> columns_;
+};
+
+}  // namespace LindormContest
@@ -10,12 +10,25 @@ namespace LindormContest {
 
 static constexpr uint32_t SSTABLE_BLOCK_CAPACITY = 4096;
 
+// 列式 sstable 一个 row group 未压缩时的最大大小
+#ifdef DEBUG_MODE
+static constexpr uint32_t SSTABLE_ROW_GROUP_CAPACITY = 8 * 1024;
+#else
+static constexpr uint32_t SSTABLE_ROW_GROUP_CAPACITY = 64 * 1024;
+#endif
+
 static constexpr int64_t MAX_TIMESTAMP = INT64_MAX;
 
 
 // sstable
 static constexpr int K_NUM_LEVELS = 7;
 
+// sstable 中 vin 布隆过滤器每个 key 使用的位数, 0 表示不生成过滤器
+static constexpr int K_BLOOM_BITS_PER_KEY = 10;
+
+// block cache 的容量, 单位为字节
+static constexpr uint64_t K_BLOCK_CACHE_SIZE = 256 * 1024 * 1024;
+
 // memtable 的写入缓存区
 #ifdef DEBUG_MODE
 static constexpr int K_MEM_TABLE_SIZE_THRESHOLD = 20 * 1024;
@@ -33,6 +46,45 @@ static constexpr uint64_t MAX_FILE_SIZE = 6 * 1024 * 1024;
 // l0 的压缩触发阈值
 static constexpr int K_L0_COMPACTION_TRIGGER = 4;
 
+// 后台 compaction 线程池的线程数量, 以及一次 compaction 最多拆分的 subcompaction 数量
+static constexpr int K_COMPACTION_THREAD_COUNT = 4;
+static constexpr int K_MAX_SUBCOMPACTIONS = 4;
+
+// 每个 subcompaction 至少处理的输入大小 (压缩后), 约为一个输出文件对应的输入
+#ifdef DEBUG_MODE
+static constexpr uint64_t K_MIN_SUBCOMPACTION_SIZE = 4 * 1024;
+#else
+static constexpr uint64_t K_MIN_SUBCOMPACTION_SIZE = 256 * 1024;
+#endif
+
+// time window compaction 的默认窗口大小, 与时间戳的单位相同 (毫秒)
+static constexpr int64_t K_TIME_WINDOW_SIZE = 60 * 60 * 1000;
+
+// 查询线程池的线程数量, 以及一个查询最多拆分的子任务数量
+static constexpr int K_QUERY_THREAD_COUNT = 4;
+static constexpr int K_MAX_QUERY_PARALLELISM = 4;
+
+// 拆分查询时每个子任务至少查找的 vin 数量 (latest query) 与 memtable/sstable 数量 (范围查询)
+static constexpr size_t K_MIN_QUERY_TASK_VINS = 64;
+static constexpr size_t K_MIN_QUERY_TASK_SOURCES = 2;
+
+// 范围查询时 Iterator::NextBatch 一次读取的最大行数
+static constexpr size_t K_ROW_BATCH_SIZE = 256;
+
+// group commit 时一次合并写入 WAL 的最大写请求数量
+static constexpr int K_MAX_WRITE_GROUP_SIZE = 128;
+
+// 批量异步读取: io_uring 的队列深度, 以及不支持 io_uring 时 pread 线程池的线程数
+static constexpr uint32_t K_ASYNC_IO_QUEUE_DEPTH = 64;
+static constexpr uint32_t K_ASYNC_IO_THREADS = 8;
+
+// O_DIRECT 读写的对齐大小, 以及写 sstable 时的缓冲区大小
+static constexpr size_t K_DIRECT_IO_ALIGNMENT = 4096;
+static constexpr size_t K_FILE_WRITER_BUFFER_SIZE = 1 << 20;
+
+// connect() 与 shutdown() 时 manifest_log 超过该大小则写入新的快照并清空 manifest_log
+static constexpr uint64_t K_MANIFEST_LOG_COMPACTION_SIZE = 4 << 20;
+
 
 
 using block_id_t = uint32_t;
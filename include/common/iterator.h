@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include "common/column_batch.h"
 #include "common/macros.h"
 #include "db/format.h"
 
@@ -13,8 +16,8 @@ public:
     DISALLOW_COPY_AND_MOVE(Iterator);
 
     virtual ~Iterator() {
-        if (deleter_ != nullptr) {
-            (*deleter_)(deleter_arg_, deleter_value_);
+        for(auto &cleanup : cleanups_) {
+            (*cleanup.deleter_)(cleanup.arg_, cleanup.value_);
         }
     }
 
@@ -22,28 +25,47 @@ public:
 
     virtual void Seek(const InternalKey &key) = 0;
 
-    virtual auto GetKey() -> InternalKey = 0;
+    // 返回的 key 与 value 不拥有数据, 在迭代器下一次移动或析构前有效, 需要保留时由调用者复制
+    virtual auto GetKey() -> const InternalKey & = 0;
 
-    virtual auto GetValue() -> std::string = 0;
+    virtual auto GetValue() -> std::string_view = 0;
 
     virtual auto Valid() -> bool = 0;
 
     virtual auto Next() -> void = 0;
 
+    // 从当前位置开始向 batch 追加最多 n 行, 遇到大于 limit 的 key 时停止, limit 为 nullptr 时不限制
+    // 返回追加的行数, 迭代器停在第一个未追加的位置; 默认实现逐行调用 GetKey 与 GetValue
+    virtual auto NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t {
+        size_t count = 0;
+        while(count < n && Valid()) {
+            auto &key = GetKey();
+            if(limit != nullptr && *limit < key) {
+                break;
+            }
+            batch->AppendRow(key, GetValue().data());
+            count++;
+            Next();
+        }
+        return count;
+    }
+
+    // 可以注册多个 deleter, 析构时按注册顺序调用
     void RegisterCleanup(void (*deleter)(void*, void*), void *arg, void *value) {
-        ASSERT(deleter_ == nullptr, "deleter_ is not nullptr");
-        deleter_ = deleter;
-        deleter_arg_ = arg;
-        deleter_value_ = value;
+        ASSERT(deleter != nullptr, "deleter is nullptr");
+        cleanups_.push_back({deleter, arg, value});
     }
 
 private:
-
     // iterator 生命周期结束时，调用 deleter_ 释放资源
-    // iterator 不释放 deleter_value_ 的内存资源
-    void (*deleter_)(void*, void*){nullptr};
-    void *deleter_arg_{nullptr};
-    void *deleter_value_{nullptr};
+    // iterator 不释放 value_ 的内存资源
+    struct Cleanup {
+        void (*deleter_)(void*, void*);
+        void *arg_;
+        void *value_;
+    };
+
+    std::vector<Cleanup> cleanups_;
 };
 
 } // namespace ljdb
\ No newline at end of file
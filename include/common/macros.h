@@ -32,4 +32,12 @@ namespace LindormContest {
 static std::string SSTABLE_NAME = "/ljdb_sstable";
 #define GET_SSTABLE_NAME(file_number) (SSTABLE_NAME + "_" + std::to_string(file_number))
 
+// WAL name
+static std::string LOG_NAME = "/ljdb_wal";
+#define GET_LOG_NAME(file_number) (LOG_NAME + "_" + std::to_string(file_number))
+
+// latest index name
+static std::string LATEST_INDEX_NAME = "/ljdb_latest_index";
+#define GET_LATEST_INDEX_NAME(file_number) (LATEST_INDEX_NAME + "_" + std::to_string(file_number))
+
 } // end namespace ljdb
\ No newline at end of file
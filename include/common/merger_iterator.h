@@ -5,6 +5,8 @@
 
 namespace LindormContest {
 
+// 按 key 归并多个有序迭代器, 多个 children 包含相同的 key 时先返回靠前的 child
+// 调用者按从新到旧的顺序排列 children, 相同 key 的第一个即最新的版本
 auto NewMergingIterator(std::vector<std::unique_ptr<Iterator>> children) -> std::unique_ptr<Iterator>;
 
 }; // namespace ljdb
@@ -5,7 +5,7 @@
 
 namespace LindormContest {
 
-using BlockFunction = std::unique_ptr<Iterator> (*)(void *, const std::string &);
+using BlockFunction = std::unique_ptr<Iterator> (*)(void *, std::string_view);
 
 auto NewTwoLevelIterator(std::unique_ptr<Iterator> index_iter, BlockFunction block_function, void *arg) -> std::unique_ptr<Iterator>;
 
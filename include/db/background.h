@@ -5,9 +5,16 @@
 #include <condition_variable>
 #include <thread>
 #include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+
+#include "common/config.h"
 
 namespace LindormContest {
 
+// 后台任务线程池, 第一次调用 Schedule 时启动 thread_count 个线程
+// Shutdown 后最后一个退出的线程负责释放 BackgroundTask
 class BackgroundTask {
 private:
     struct BackgroundTaskItem {
@@ -18,15 +25,35 @@ private:
                 : function_(function), arg_(arg) {}
     };
 
+    // Run 拆分出的一组子任务, 由调用线程与后台线程一起领取执行
+    struct Batch {
+        const std::function<void(size_t)> *function_;
+        size_t count_;
+
+        // 下一个未领取的子任务与已完成的子任务数量, 由 mutex_ 保护
+        size_t next_{0};
+        size_t done_{0};
+        std::exception_ptr error_{nullptr};
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+    };
+
 public:
 
-    BackgroundTask() = default;
+    explicit BackgroundTask(int thread_count = K_COMPACTION_THREAD_COUNT) : thread_count_(thread_count) {}
 
     void Schedule(void (*function)(void* arg), void* arg);
 
+    // 在后台线程池中执行 function(0) ... function(count - 1), 返回时所有子任务已经完成
+    // 调用线程也领取子任务执行, 在后台线程中调用时不会因线程池繁忙而死锁
+    // 子任务抛出的异常在调用线程中重新抛出
+    void Run(size_t count, const std::function<void(size_t)> &function);
+
+    // 等待队列为空且没有正在执行的任务
     void WaitForEmptyQueue() {
         std::unique_lock<std::mutex> lock(mutex_);
-        while(!background_work_queue_.empty()) {
+        while(!background_work_queue_.empty() || running_count_ > 0) {
             cv_.wait(lock);
         }
     }
@@ -36,14 +63,29 @@ public:
         cv_.notify_all();
     }
 
+    auto GetThreadCount() const -> int { return thread_count_; }
+
 private:
     static void BackgroundThread(BackgroundTask *background_task) {
         background_task->BackgroundThreadMain();
-        delete background_task;
+
+        std::unique_lock<std::mutex> lock(background_task->mutex_);
+        if(--background_task->alive_thread_count_ == 0) {
+            lock.unlock();
+            delete background_task;
+        }
     }
 
     void BackgroundThreadMain();
 
+    // 领取并执行 batch 中的子任务直到全部领取完
+    static void Work(Batch *batch);
+
+    // 后台线程取到的 batch, 子任务已经全部领取时直接返回, batch 的生命周期由 shared_ptr 管理
+    static void BatchWork(void *arg);
+
+    const int thread_count_;
+
     std::mutex mutex_;
     std::condition_variable cv_;
 
@@ -51,7 +93,13 @@ private:
 
     std::queue<BackgroundTaskItem> background_work_queue_;
     bool started_background_thread_{false};
+
+    // 正在执行任务的线程数量
+    int running_count_{0};
+
+    // 尚未退出的线程数量
+    int alive_thread_count_{0};
 };
 
 
-}  // namespace LindormContest
\ No newline at end of file
+}  // namespace LindormContest
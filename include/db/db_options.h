@@ -1,11 +1,23 @@
 #pragma once
 
 #include <atomic>
+#include <string>
+#include <unordered_map>
 #include "background.h"
+#include "query_executor.h"
 #include "cache/table_cache.h"
 
 namespace LindormContest {
 
+class Manifest;
+
+enum CompactionStyle {
+    // L0 合并到 L1, 之后逐层合并
+    LeveledCompaction,
+    // 所有 sstable 位于 L0 并按时间窗口划分, 只合并同一个窗口内的文件, 见 TableMetaData
+    TimeWindowCompaction,
+};
+
 struct DBOptions {
 
     auto NextFileNumber() -> file_number_t {
@@ -17,9 +29,65 @@ struct DBOptions {
 
     BackgroundTask *bg_task_;
 
+    // 为 nullptr 时查询在调用线程上串行执行
+    QueryExecutor *query_executor_{nullptr};
+
+    // 不为 nullptr 时 flush 与 compaction 的结果立即写入 manifest_log, flush 完成后删除对应的 WAL
+    // 为 nullptr 时元数据只能通过 WriteMetaData 持久化, WAL 保留到 EraseLogFile
+    Manifest *manifest_{nullptr};
+
+    // 写入前先写 WAL, 崩溃后 connect() 时回放
+    bool use_wal_{true};
+
+    // 每个写入组提交后执行 fdatasync
+    bool sync_wal_{true};
+
+    // 一个写入组最多合并的写请求数量
+    int max_write_group_size_{K_MAX_WRITE_GROUP_SIZE};
+
+    // 新建表时按 vin 划分的 shard 数量, 已存在的表以 manifest 记录的数量为准
+    uint32_t table_shard_count_{1};
+
+    // latest query 直接读取 vin -> 最新行的索引, 否则逐层查找 memtable 与 sstable
+    // 按有序 vin 向前扫描迭代器, 以及 L1 及以上二分查找文件, 只在逐层查找时生效; 索引按 vin 哈希查找, 与顺序无关
+    bool use_latest_index_{true};
+
+    // 查询 sstable 前先检查 vin 布隆过滤器, 跳过一定不包含 vin 的文件
+    bool use_bloom_filter_{true};
+
+    // TableCache 打开 sstable 时映射整个文件, 只影响之后打开的 sstable, 见 SSTable
+    bool use_mmap_reads_{false};
+
+    // 以 O_DIRECT 读写 sstable, 绕过 page cache, 只由 block cache 缓存数据, 只影响之后创建或打开的 sstable
+    bool use_direct_io_{false};
+
+    // 逐层查找 latest query 时, 先收集所有 sstable 中需要的 block 并一次批量读取
+    bool batch_block_reads_{true};
+
+    CompactionStyle compaction_style_{LeveledCompaction};
+
+    // time window compaction 的窗口大小
+    int64_t time_window_size_{K_TIME_WINDOW_SIZE};
+
+    // 按表名配置的数据保留时长, 单位为毫秒, 与时间戳相同, 未配置的表永久保留
+    // 以表中写入的最大时间戳与当前时间中较小的一个为基准, 早于基准超过保留时长的数据过期, 查询不再返回, 由 compaction 删除
+    std::unordered_map<std::string, int64_t> retention_;
+
+    // 每个 shard 同时执行的 compaction 数量, 同时执行的 compaction 的输入文件互不重叠
+    int max_background_compactions_{K_COMPACTION_THREAD_COUNT};
+
+    // 输入较大的 compaction 按 key 范围拆分为多个 subcompaction 并行执行, 1 表示不拆分
+    // subcompaction 与 compaction 共用 bg_task_ 的线程, 所有 shard 的总并发不超过后台线程数量
+    int max_subcompactions_{K_MAX_SUBCOMPACTIONS};
+
+    // 一个 latest query 的 vin 或一个范围查询的 memtable 与 sstable 最多拆分为多少个子任务并行查找, 1 表示不拆分
+    int max_query_parallelism_{K_MAX_QUERY_PARALLELISM};
+
     std::atomic<int32_t> next_file_number_{0};
 };
 
-auto NewDBOptions() -> DBOptions *;
+// compaction_thread_count 与 query_thread_count 为所有 table 共享的后台线程与查询线程数量
+auto NewDBOptions(int compaction_thread_count = K_COMPACTION_THREAD_COUNT,
+                  int query_thread_count = K_QUERY_THREAD_COUNT) -> DBOptions *;
 
 }  // namespace LindormContest
\ No newline at end of file
@@ -4,19 +4,33 @@
 #include "common/config.h"
 #include "format.h"
 #include "common/iterator.h"
+#include "common/macros.h"
 
 namespace LindormContest {
 
-const constexpr uint32_t FILE_META_DATA_SIZE = INTERNAL_KEY_SIZE * 2 + 2 * sizeof(uint64_t) + sizeof(uint32_t);
+class TableCache;
+
+// | file number (4) | file size (8) | smallest (25) | largest (25) | max timestamp (8) | min timestamp (8) | sequence (4) |
+const constexpr uint32_t FILE_META_DATA_SIZE = INTERNAL_KEY_SIZE * 2 + 3 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
 
 class FileMetaData {
 public:
     explicit FileMetaData() = default;
 
-    explicit FileMetaData(file_number_t file_number, InternalKey smallest, InternalKey largest, uint64_t file_size, int64_t max_timestamp);
+    // sequence 为 0 时与 file_number 相同
+    explicit FileMetaData(file_number_t file_number, InternalKey smallest, InternalKey largest, uint64_t file_size,
+                          int64_t min_timestamp, int64_t max_timestamp, file_number_t sequence = 0);
 
     explicit FileMetaData(const std::string &src);
 
+    // 被标记为过期时, 删除 TableCache 与 block cache 中的缓存并删除文件
+    ~FileMetaData();
+
+    DISALLOW_COPY_AND_MOVE(FileMetaData);
+
+    // compaction 的结果写入 manifest_log 后调用, 最后一个引用释放时删除文件
+    void MarkObsolete(TableCache *table_cache) { obsolete_table_cache_ = table_cache; }
+
     void EncodeTo(std::string* dst) const;
 
     auto GetFileSize() const -> uint64_t { return file_size_; }
@@ -38,17 +52,32 @@ public:
     InternalKey smallest_;
     InternalKey largest_;
 
+    // 文件中所有 key 的时间戳范围
+    int64_t min_timestamp_{INT64_MIN};
     int64_t max_timestamp_;
 
+    // 数据的新旧程度, 重叠的文件中 sequence 更大的数据更新
+    // flush 生成的文件为 memtable 对应的编号, compaction 生成的文件为输入文件中最大的 sequence
+    file_number_t sequence_{};
+
     uint32_t allowed_seeks_{};
+
+    // 是否是正在执行的 compaction 的输入文件, 需要持有 shard 的锁
+    bool being_compacted_{false};
+
+private:
+    TableCache *obsolete_table_cache_{nullptr};
 };
 
 using FileMetaDataPtr = std::shared_ptr<FileMetaData>;
 
 
 
+// 按 sequence 从新到旧排列, 用于 L0 等文件之间存在重叠的情况
+void SortNewestFirst(std::vector<FileMetaDataPtr> *files);
+
 auto NewFileMetaDataIterator(const std::vector<FileMetaDataPtr>& files) -> std::unique_ptr<Iterator>;
 
-auto GetFileIterator(void *arg, const std::string &file_value) -> std::unique_ptr<Iterator>;
+auto GetFileIterator(void *arg, std::string_view file_value) -> std::unique_ptr<Iterator>;
 
 }  // namespace LindormContest
\ No newline at end of file
@@ -56,6 +56,17 @@ struct InternalKey {
     int64_t timestamp_{};
 };
 
+// vin 的哈希值 (FNV-1a), 用于划分 shard
+// shard 的划分会持久化到 manifest, 不能使用与实现相关的 std::hash
+inline auto HashVin(const Vin &vin) -> uint32_t {
+    uint32_t hash = 2166136261U;
+    for(char c : vin.vin) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
 
 
 
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "common/macros.h"
+#include "struct/Vin.h"
+#include "db/format.h"
+
+namespace LindormContest {
+
+// vin -> 最新一行数据的索引, 用于 latest query
+// 按 vin 的哈希值划分为多个分段, 每个分段使用读写锁, 读者之间不会互相阻塞
+class LatestIndex {
+public:
+    LatestIndex() = default;
+
+    DISALLOW_COPY_AND_MOVE(LatestIndex);
+
+    // 时间戳不小于已有记录时覆盖, 时间戳相同时后写入的数据生效
+    void Update(const Vin &vin, int64_t timestamp, std::string_view value);
+
+    // vin 存在时持有读锁调用 read(timestamp, value), value 为编码后的行数据, 只在 read 内有效
+    // vin 不存在时返回 false
+    template <typename ReadFunction>
+    auto Get(const Vin &vin, ReadFunction &&read) const -> bool {
+        auto &stripe = stripes_[GetStripe(vin)];
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex_);
+        auto iter = stripe.map_.find(vin);
+        if(iter == stripe.map_.end()) {
+            return false;
+        }
+        read(iter->second.timestamp_, std::string_view(iter->second.value_));
+        return true;
+    }
+
+    auto Size() const -> size_t;
+
+    // 持久化格式: | count (4) | { vin (17) | timestamp (8) | value size (4) | value } |
+    auto WriteTo(std::ofstream &file) const -> void;
+
+    auto ReadFrom(std::ifstream &file) -> void;
+
+    // 与 WriteTo 格式相同, 用于写入 manifest_log
+    auto EncodeTo(std::string *dst) const -> void;
+
+    // 合并 src 中的记录, 数据损坏时返回 false
+    auto DecodeFrom(std::string_view src) -> bool;
+
+private:
+    static constexpr size_t K_NUM_STRIPES = 16;
+
+    struct Entry {
+        int64_t timestamp_;
+        std::string value_;
+    };
+
+    // 直接以 Vin 为 key, 插入与查找时不需要为 key 分配内存
+    struct VinHasher {
+        auto operator()(const Vin &vin) const -> size_t { return HashVin(vin); }
+    };
+
+    struct Stripe {
+        mutable std::shared_mutex mutex_;
+        std::unordered_map<Vin, Entry, VinHasher> map_;
+    };
+
+    // 高位参与分段, 避免与按低位划分的 shard 相关
+    static auto GetStripe(const Vin &vin) -> size_t;
+
+    Stripe stripes_[K_NUM_STRIPES];
+};
+
+}  // namespace LindormContest
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace LindormContest {
+
+class LogReader {
+public:
+    // 读取整个 WAL 文件, 文件不存在时抛出 IO 异常
+    explicit LogReader(file_number_t log_number);
+
+    explicit LogReader(const std::string &filename);
+
+    DISALLOW_COPY_AND_MOVE(LogReader);
+
+    // 读取下一条 record, 到达文件末尾或遇到损坏的 record 时返回 false
+    auto ReadRecord(std::string_view *record) -> bool;
+
+    // 已经读取的完整 record 的总长度
+    auto GetOffset() const -> size_t { return offset_; }
+
+private:
+    std::string buffer_;
+    size_t offset_{0};
+};
+
+}  // namespace LindormContest
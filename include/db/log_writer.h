@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace LindormContest {
+
+// WAL 文件格式:
+// record : | checksum (4) | length (4) | payload (length) |
+//
+// checksum 为 payload 的 crc32, 崩溃时末尾不完整的 record 会在恢复时被丢弃
+static constexpr uint32_t LOG_RECORD_HEADER_SIZE = 8;
+
+class LogWriter {
+public:
+    explicit LogWriter(file_number_t log_number);
+
+    // 追加到已有的文件末尾, 不存在时创建, 用于 manifest_log
+    explicit LogWriter(const std::string &filename);
+
+    ~LogWriter();
+
+    DISALLOW_COPY_AND_MOVE(LogWriter);
+
+    // 追加一条 record, 不保证落盘
+    auto AddRecord(std::string_view record) -> void;
+
+    // 将已追加的 record 落盘
+    auto Sync() -> void;
+
+    auto GetLogNumber() const -> file_number_t { return log_number_; }
+
+private:
+    file_number_t log_number_;
+    int fd_;
+};
+
+}  // namespace LindormContest
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common/config.h"
+#include "common/macros.h"
+#include "TSDBEngine.hpp"
+#include "db/file_meta_data.h"
+#include "db/log_writer.h"
+
+namespace LindormContest {
+
+// manifest 由两个文件组成:
+// manifest_file : 完整的元数据快照 | generation (4) | next file number (4) | { table } |
+// manifest_log  : 快照之后的变更, record 格式与 WAL 相同, 见 LogWriter
+//
+// manifest_log 的第一条 record 记录对应快照的 generation, 与快照不一致时整个 log 已经过期
+// record : | type (1) | table name size (4) | table name | body |
+enum ManifestRecordType : uint8_t {
+    MANIFEST_LOG_HEADER = 1,    // body : | generation (4) |, 没有 table name
+    MANIFEST_NEW_TABLE = 2,     // body : | shard count (4) | schema |
+    MANIFEST_VERSION_EDIT = 3,  // body : VersionEdit
+    MANIFEST_LATEST_INDEX = 4,  // body : | shard id (4) | index file number (4) |
+};
+
+// latest index 较大, 单独写入 GET_LATEST_INDEX_NAME(index file number), manifest_log 只记录编号
+
+static const std::string MANIFEST_FILE_NAME = "/manifest_file";
+static const std::string MANIFEST_LOG_NAME = "/manifest_log";
+
+// 一次 flush 或 compaction 对一个 shard 的 sstable 集合的修改
+// body : | shard id (4) | next file number (4) | log number (4) |
+//        | deleted count (4) | { level (4) | file number (4) } |
+//        | added count (4) | { level (4) | file meta data } |
+struct VersionEdit {
+    uint32_t shard_id_{0};
+    file_number_t next_file_number_{0};
+
+    // shard 中编号小于 log_number_ 的 WAL 中的数据都已经写入 sstable
+    file_number_t log_number_{0};
+
+    std::vector<std::pair<int32_t, file_number_t>> deleted_files_;
+    std::vector<std::pair<int32_t, FileMetaDataPtr>> added_files_;
+
+    auto EncodeTo(std::string *dst) const -> void;
+
+    auto DecodeFrom(std::string_view src) -> bool;
+};
+
+class Manifest {
+public:
+    Manifest() = default;
+
+    DISALLOW_COPY_AND_MOVE(Manifest);
+
+    // 快照的 generation, 读取 manifest_file 后设置
+    void SetGeneration(uint32_t generation) { generation_ = generation; }
+
+    auto GetGeneration() const -> uint32_t { return generation_; }
+
+    // 按顺序回放 manifest_log 中属于当前快照的 record, 丢弃末尾损坏的部分, 之后可以追加 record
+    // apply 的参数为 record 的类型、表名与 body
+    void Recover(const std::function<void(ManifestRecordType, const std::string &, std::string_view)> &apply);
+
+    // 下述函数追加一条 record 并落盘, 线程安全
+    void LogNewTable(const std::string &table_name, const Schema &schema, uint32_t shard_count);
+
+    void LogEdit(const std::string &table_name, const VersionEdit &edit);
+
+    void LogLatestIndex(const std::string &table_name, uint32_t shard_id, file_number_t index_file_number);
+
+    auto GetLogSize() const -> uint64_t;
+
+    // 写入新的快照并清空 manifest_log, write 负责写入 generation 之后的内容
+    // 要求: 没有并发写入的 record
+    void WriteSnapshot(const std::function<void(std::ofstream &)> &write);
+
+private:
+    void AddRecord(ManifestRecordType type, const std::string &table_name, std::string_view body);
+
+    // 清空 manifest_log 并写入 generation_
+    void ResetLog();
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<LogWriter> log_;
+    uint64_t log_size_{0};
+    uint32_t generation_{0};
+};
+
+}  // namespace LindormContest
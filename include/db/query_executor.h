@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace LindormContest {
+
+// 查询线程池, 由引擎持有, 所有 table 共享
+// 一个查询拆分为多个子任务, 调用线程与线程池中的线程一起领取子任务执行
+// 线程池繁忙时调用线程独自执行所有子任务, 不会等待其他查询
+class QueryExecutor {
+public:
+    explicit QueryExecutor(int thread_count);
+
+    ~QueryExecutor();
+
+    QueryExecutor(const QueryExecutor &) = delete;
+    auto operator=(const QueryExecutor &) -> QueryExecutor & = delete;
+
+    // 执行 function(0) ... function(count - 1), 返回时所有子任务已经完成
+    // 子任务抛出的异常在调用线程中重新抛出
+    void Run(size_t count, const std::function<void(size_t)> &function);
+
+    auto GetThreadCount() const -> int { return static_cast<int>(threads_.size()); }
+
+private:
+    struct Batch {
+        const std::function<void(size_t)> *function_;
+        size_t count_;
+
+        // 下一个未领取的子任务与已完成的子任务数量, 由 mutex_ 保护
+        size_t next_{0};
+        size_t done_{0};
+        std::exception_ptr error_{nullptr};
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+    };
+
+    // 领取并执行 batch 中的子任务直到全部领取完
+    static void Work(Batch *batch);
+
+    void WorkerMain();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // 线程池中的线程在子任务全部领取后才取到 batch 时直接丢弃, batch 的生命周期由 shared_ptr 管理
+    std::queue<std::shared_ptr<Batch>> batches_;
+    bool is_shutting_down_{false};
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace LindormContest
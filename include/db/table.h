@@ -1,64 +1,32 @@
 #pragma once
 
 
-#include <mutex>
-#include <condition_variable>
-#include <shared_mutex>
-#include <utility>
+#include <memory>
+#include <vector>
 #include "common/macros.h"
 #include "TSDBEngine.hpp"
-#include "mem_table/mem_table.h"
-#include "format.h"
-#include "table_meta_data.h"
-#include "background.h"
-#include "compaction.h"
+#include "table_shard.h"
 
 namespace LindormContest {
 
+// 按 vin 的哈希值将写入与查询路由到对应的 TableShard
+// shard 之间互不共享锁, 写入可以在多个 shard 上并行
 class Table {
-private:
-    struct RangeQueryRequest {
-        const Vin vin_;
-        int64_t time_lower_bound_;
-        int64_t time_upper_bound_;
-
-        InternalKey lower_bound_;
-        InternalKey upper_bound_;
-
-        const std::set<std::string> *columns_;
-        std::vector<Row> *result_;
-
-        std::set<int64_t> time_set_;
-
-        RangeQueryRequest(const Vin vin, int64_t time_lower_bound, int64_t time_upper_bound,
-                          const std::set<std::string> *columns, std::vector<Row> *result)
-         : vin_(vin), time_lower_bound_(time_lower_bound), time_upper_bound_(time_upper_bound), columns_(columns),
-         result_(result) {
-            lower_bound_ = InternalKey(vin_, time_upper_bound);
-            upper_bound_ = InternalKey(vin_, time_lower_bound);
-        }
-    };
-
-    struct QueryRequest {
-        const std::vector<Vin> *vins_;
-        std::map<Vin, Row> vin_map_{};
-        std::set<std::string> columns_;
-        std::vector<Row> *result_;
-
-        QueryRequest(const std::vector<Vin> *vins, std::set<std::string> columns, std::vector<Row> *result)
-         : columns_(std::move(columns)), result_(result), vins_(vins) {
-
-        }
-    };
-
 public:
     explicit Table(std::string tableName, Schema schema, DBOptions *options);
+
+    // 使用指定的 shard 数量, 用于恢复 manifest_log 中记录的表
+    explicit Table(std::string tableName, Schema schema, DBOptions *options, uint32_t shard_count);
     ~Table() = default;
 
     DISALLOW_COPY_AND_MOVE(Table);
 
     auto GetTableName() -> std::string { return table_name_; }
 
+    auto GetSchema() const -> const Schema & { return schema_; }
+
+    auto GetShardCount() const -> uint32_t { return static_cast<uint32_t>(shards_.size()); }
+
     auto Upsert(const WriteRequest &wReq) -> int;
 
     auto ExecuteLatestQuery(const LatestQueryRequest &pReadReq, std::vector<Row> &pReadRes) -> int;
@@ -68,57 +36,57 @@ public:
     auto Shutdown() -> int;
 
     // 从文件中读取元数据
-    auto ReadMetaData(std::ifstream &file) -> void;
+    // schedule_compaction 为 false 时需要在恢复完成后调用 ScheduleCompaction
+    auto ReadMetaData(std::ifstream &file, bool schedule_compaction = true) -> void;
 
     // 写入元数据
     auto WriteMetaData(std::ofstream &file) const -> void;
 
-    auto TestGetTableMetaData() -> TableMetaData& { return table_meta_data_; }
+    void ScheduleCompaction();
 
-    void EraseSSTableFile();
+    // 回放 manifest_log, 见 TableShard
+    auto ApplyVersionEdit(const VersionEdit &edit) -> void;
 
-private:
-    // 查询 memtable 内符合时间范围的元素
-    auto MemTableRangeQuery(Table::RangeQueryRequest &req, const std::shared_ptr<MemTable>& memtable) -> void;
+    auto ApplyLatestIndex(uint32_t shard_id, file_number_t index_file_number) -> void;
 
-    void FileTableRangeQuery(const FileMetaDataPtr& fileMetaData, Table::RangeQueryRequest &req);
+    auto RecoverLatestIndex() -> void;
 
-    // 后台线程任务
-    static void BGWork(void* table);
-    void BackgroundCall();
+    // 将每个 shard 的 latest index 写入单独的文件并记录在 manifest_log 中, 要求: 已经调用 Shutdown
+    auto LogLatestIndex() -> void;
+
+    auto TestGetTableMetaData(uint32_t shard_id = 0) -> TableMetaData& {
+        return shards_[shard_id]->TestGetTableMetaData();
+    }
+
+    void EraseSSTableFile();
 
-    // 要求：持有锁
-    void MaybeScheduleCompaction();
+    // 回放 WAL 到 shard_id 对应的 shard
+    auto RecoverLogFile(uint32_t shard_id, file_number_t log_number, LogReader &reader) -> void;
 
-    // 要求：持有锁
-    auto BackgroundCompaction(std::unique_lock<std::mutex> &lock) -> void;
+    // 元数据持久化后删除 WAL
+    void EraseLogFile();
 
-    // 执行 Manual Compaction
-    auto DoManualCompaction(CompactionTask* task) -> bool;
+    auto TestGetLogSyncCount() const -> uint64_t;
 
-    void StartMemTableCompaction(const std::shared_ptr<MemTable> mem);
+    auto TestGetSSTableProbeCount() const -> uint64_t;
 
-    // 执行 Minor Compaction
-    auto CompactMemTable(const std::shared_ptr<MemTable>& mem) -> FileMetaDataPtr;
+    auto TestGetCompactionBytesWritten() const -> uint64_t;
+
+private:
+    void InitShards(uint32_t shard_count);
+
+    auto GetShardId(const Vin &vin) const -> uint32_t {
+        return shards_.size() == 1 ? 0 : HashVin(vin) % static_cast<uint32_t>(shards_.size());
+    }
 
     std::string table_name_{};
     Schema schema_{};
     DBOptions *options_{nullptr};
 
-    TableCache *table_cache_{nullptr};
-
-    std::atomic_bool is_shutting_down_{false};
-
-    // 下述是需要锁保护的变量
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    TableMetaData table_meta_data_;
-    std::shared_ptr<MemTable> mem_;
-    std::vector<std::shared_ptr<MemTable>> imm_;
-    std::queue<const WriteRequest*> write_queue_;   // 写请求队列
+    // 所有 shard 中写入的最大时间戳, 同一张表的 shard 以此为基准计算相同的过期时间
+    std::atomic<int64_t> newest_timestamp_{INT64_MIN};
 
-    // 当前正在压缩的线程数量
-    int32_t compaction_thread_count_{0};
+    std::vector<std::unique_ptr<TableShard>> shards_;
 };
 
-}  // namespace LindormContest
\ No newline at end of file
+}  // namespace LindormContest
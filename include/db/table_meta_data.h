@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <mutex>
 #include <condition_variable>
+#include <limits>
+#include <map>
 
 #include "common/config.h"
 #include "format.h"
@@ -40,6 +42,9 @@ struct CompactionTask {
     // 压缩的目标层数
     int level_;
 
+    // 输出文件所在的层数, leveled compaction 为 level_ + 1, time window compaction 为 0
+    int output_level_;
+
     // 压缩类型
     CompactionType type_;
 
@@ -54,6 +59,9 @@ struct CompactionTask {
 
     // 是否需要删除压缩文件
     bool need_delete_{true};
+
+    // 时间戳小于该值的数据已经过期, 不写入输出文件
+    int64_t expire_timestamp_{INT64_MIN};
 };
 
 class TableMetaData {
@@ -69,15 +77,18 @@ public:
     // 删除 SSTable
     void RemoveFileMetaData(int32_t level, const std::vector<FileMetaDataPtr> &file);
 
+    // 按编号删除 SSTable, 用于回放 manifest_log
+    void RemoveFileMetaData(int32_t level, file_number_t file_number);
+
     // 返回 level 层与 [begin, end] 存在重叠的文件
     void GetOverlappingInputs(int level, const InternalKey* begin, const InternalKey* end, std::vector<FileMetaDataPtr>* inputs);
 
     // 返回 level 层的文件总大小
     auto TotalFileSize(int level) -> uint64_t;
 
-    // 是否存在 sstable file 的压缩计划
+    // 是否存在 sstable file 的压缩计划或可以直接删除的过期文件
     auto ExistCompactionTask() -> bool {
-        return size_compaction_score_ >= 1 || seek_compaction_level_ != -1;
+        return size_compaction_score_ >= 1 || seek_compaction_level_ != -1 || !GetExpiredFiles().empty();
     }
 
     // 确定下一次 Size Compaction 计划
@@ -90,8 +101,27 @@ public:
 
     void ClearCompaction();
 
-    // 生成压缩计划
-    auto GenerateCompactionTask() -> CompactionTask*;
+    // 大于 0 时使用 time window compaction, 所有文件位于 L0, 按 max timestamp 划分为该大小的窗口
+    // 最新的窗口中 sorted run 达到 K_L0_COMPACTION_TRIGGER 时合并, 其它窗口不再写入, 存在多个 sorted run 时合并为一个
+    void SetTimeWindowSize(int64_t time_window_size) { time_window_size_ = time_window_size; }
+
+    auto GetTimeWindow(const FileMetaDataPtr &file) const -> int64_t { return file->max_timestamp_ / time_window_size_; }
+
+    // 时间戳小于 expire_timestamp 的数据已经过期, INT64_MIN 表示永久保留
+    void SetExpireTimestamp(int64_t expire_timestamp) { expire_timestamp_ = expire_timestamp; }
+
+    auto GetExpireTimestamp() const -> int64_t { return expire_timestamp_; }
+
+    // 返回所有数据都已过期且不是 compaction 输入的文件及其所在的层, 这些文件不需要重写, 直接删除
+    auto GetExpiredFiles() const -> std::vector<std::pair<int, FileMetaDataPtr>>;
+
+    // 生成压缩计划, 输入文件被标记为正在压缩, 完成后需要调用 ReleaseCompactionTask
+    // 不存在与正在执行的 compaction 不冲突的计划时返回 nullptr
+    // flushing_sequence 为正在 flush 的 memtable 中最小的 sequence, L0 中更新的文件不作为输入
+    auto GenerateCompactionTask(file_number_t flushing_sequence = std::numeric_limits<file_number_t>::max()) -> CompactionTask*;
+
+    // 清除输入文件的压缩标记
+    void ReleaseCompactionTask(CompactionTask *task);
 
     auto GetEraseFileQueue() -> std::queue<file_number_t>& {
         return erase_file_queue_;
@@ -101,17 +131,38 @@ public:
     std::vector<FileMetaDataPtr> files_[K_NUM_LEVELS];
 
 private:
-    // 需要删除的文件
-    // TODO 使用引用计数将过期文件及时删除
+    // level 层的压缩分数, 大于等于 1 时需要压缩
+    auto CompactionScore(int level) const -> double;
+
+    // 从 level 层的第 start_idx 个文件开始选择输入文件
+    // L0 忽略 start_idx, 从最旧的文件开始按 sequence 连续选择, 不选择 sequence 不小于 flushing_sequence 的文件
+    auto PickCompaction(int level, CompactionType type, size_t start_idx, file_number_t flushing_sequence) -> CompactionTask*;
+
+    // 将 L0 的文件按时间窗口分组, 窗口从旧到新排列
+    auto GetTimeWindows() const -> std::map<int64_t, std::vector<FileMetaDataPtr>>;
+
+    // 窗口中 sequence 小于 flushing_sequence 的文件需要合并时返回这些文件, 否则返回空
+    auto PickTimeWindowInputs(const std::vector<FileMetaDataPtr> &files, bool newest,
+                              file_number_t flushing_sequence) const -> std::vector<FileMetaDataPtr>;
+
+    auto PickTimeWindowCompaction(file_number_t flushing_sequence) -> CompactionTask*;
+
+    // 未使用 manifest 时 compaction 的输入文件, 在 EraseSSTableFile 时删除
+    // 使用 manifest 时输入文件由 FileMetaData::MarkObsolete 在没有引用后删除
     std::queue<file_number_t> erase_file_queue_;
 
     // Size Compaction 的压缩分数
     int size_compaction_level_{-1};
     double size_compaction_score_{-1};
+    double compaction_score_[K_NUM_LEVELS]{};
 
     // Size Compaction 上次压缩结束的位置
     InternalKey size_compaction_pointer_[K_NUM_LEVELS];
 
+    int64_t time_window_size_{0};
+
+    int64_t expire_timestamp_{INT64_MIN};
+
     // Seek Compaction 的压缩信息
     int seek_compaction_level_{-1};
     FileMetaDataPtr seek_compaction_file_{nullptr};
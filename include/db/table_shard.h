@@ -0,0 +1,306 @@
+#pragma once
+
+
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include "common/macros.h"
+#include "TSDBEngine.hpp"
+#include <fstream>
+#include "mem_table/mem_table.h"
+#include "format.h"
+#include "table_meta_data.h"
+#include "background.h"
+#include "compaction.h"
+#include "log_writer.h"
+#include "log_reader.h"
+#include "latest_index.h"
+#include "manifest.h"
+
+namespace LindormContest {
+
+// Table 按 vin 的哈希值划分为多个 TableShard
+// 每个 shard 拥有独立的 memtable、imm、TableMetaData、WAL 与压缩状态
+class TableShard {
+private:
+    struct RangeQueryRequest {
+        const Vin vin_;
+        int64_t time_lower_bound_;
+        int64_t time_upper_bound_;
+
+        InternalKey lower_bound_;
+        InternalKey upper_bound_;
+
+        const std::set<std::string> *columns_;
+        ColumnMask column_mask_;
+        std::vector<Row> *result_;
+
+        std::set<int64_t> time_set_;
+
+        // 在 memtable 与 sstable 之间复用
+        ColumnBatch batch_;
+
+        RangeQueryRequest(const Vin vin, int64_t time_lower_bound, int64_t time_upper_bound,
+                          const std::set<std::string> *columns, std::vector<Row> *result)
+         : vin_(vin), time_lower_bound_(time_lower_bound), time_upper_bound_(time_upper_bound), columns_(columns),
+         result_(result) {
+            lower_bound_ = InternalKey(vin_, time_upper_bound);
+            upper_bound_ = InternalKey(vin_, time_lower_bound);
+        }
+    };
+
+    struct QueryRequest {
+        const std::vector<Vin> *vins_;
+        std::map<Vin, Row> vin_map_{};
+        const std::set<std::string> *columns_;
+        std::vector<Row> *result_;
+
+        QueryRequest(const std::vector<Vin> *vins, const std::set<std::string> *columns, std::vector<Row> *result)
+         : columns_(columns), result_(result), vins_(vins) {
+
+        }
+    };
+
+    // 查询开始时的 memtable 与 sstable, imm 按从新到旧排列, L0 按 SortNewestFirst 排列
+    struct QuerySnapshot {
+        std::shared_ptr<MemTable> mem_;
+        std::vector<std::shared_ptr<MemTable>> imm_;
+        std::vector<FileMetaDataPtr> files_[K_NUM_LEVELS];
+    };
+
+    // 等待写入的请求, 由写入组的 leader 统一写入 WAL 与 memtable
+    struct Writer {
+        const std::vector<const Row*> *rows_;
+        bool done_{false};
+        int result_{0};
+
+        explicit Writer(const std::vector<const Row*> *rows) : rows_(rows) {}
+    };
+
+public:
+    // newest_timestamp 由 Table 持有, 在所有 shard 之间共享
+    explicit TableShard(std::string table_name, Schema schema, uint32_t shard_id, DBOptions *options,
+                        std::atomic<int64_t> *newest_timestamp);
+    ~TableShard() = default;
+
+    DISALLOW_COPY_AND_MOVE(TableShard);
+
+    auto GetShardId() const -> uint32_t { return shard_id_; }
+
+    // 要求：rows 中的 vin 都属于当前 shard
+    auto Upsert(const std::vector<const Row*> &rows) -> int;
+
+    // 要求：vins 都属于当前 shard
+    auto ExecuteLatestQuery(const std::vector<Vin> &vins, const std::set<std::string> &columns,
+                            std::vector<Row> &pReadRes) -> int;
+
+    auto ExecuteTimeRangeQuery(const TimeRangeQueryRequest &trReadReq, std::vector<Row> &trReadRes) -> int;
+
+    auto Shutdown() -> int;
+
+    // 从文件中读取 sstable 元数据与 latest index
+    // schedule_compaction 为 false 时需要在恢复完成后调用 ScheduleCompaction
+    auto ReadMetaData(std::ifstream &file, bool schedule_compaction = true) -> void;
+
+    void ScheduleCompaction();
+
+    // 写入 sstable 元数据与 latest index
+    // | log number (4) | index file number (4) | { file count (4) | { file meta data } } | latest index |
+    auto WriteMetaData(std::ofstream &file) const -> void;
+
+    // 回放 manifest_log 中的 VersionEdit
+    auto ApplyVersionEdit(const VersionEdit &edit) -> void;
+
+    // 回放 manifest_log 中记录的 latest index 文件编号, 文件在 RecoverLatestIndex 时读取
+    auto ApplyLatestIndex(file_number_t index_file_number) -> void;
+
+    // 读取 manifest_log 最后记录的 latest index 文件
+    // latest index 持久化之后生成的 sstable 对应的 WAL 可能已经删除, 从这些 sstable 中恢复 latest index
+    auto RecoverLatestIndex() -> void;
+
+    // 将 latest index 写入单独的文件并在 manifest_log 中记录编号, 之后删除上一个文件, 要求: 已经调用 Shutdown
+    auto LogLatestIndex() -> void;
+
+    auto TestGetTableMetaData() -> TableMetaData& { return table_meta_data_; }
+
+    void EraseSSTableFile();
+
+    // 回放 WAL 到 memtable, 要求: 尚未开始写入
+    auto RecoverLogFile(file_number_t log_number, LogReader &reader) -> void;
+
+    // 元数据持久化后删除 WAL
+    void EraseLogFile();
+
+    // 解析 WAL 的第一条 record, 获取表名、schema 与 shard 编号
+    static auto DecodeLogHeader(std::string_view record, std::string *table_name, Schema *schema,
+                                uint32_t *shard_id) -> bool;
+
+    auto TestGetLogSyncCount() const -> uint64_t { return log_sync_count_.load(std::memory_order_relaxed); }
+
+    // 查询时在 sstable 中 Seek 的次数
+    auto TestGetSSTableProbeCount() const -> uint64_t { return sstable_probe_count_.load(std::memory_order_relaxed); }
+
+    // compaction 写入的 sstable 总大小, 不包括 flush
+    auto TestGetCompactionBytesWritten() const -> uint64_t { return compaction_bytes_written_.load(std::memory_order_relaxed); }
+
+private:
+    // 要求：持有锁
+    // 保证 mem_ 与 log_ 可以写入, mem_ 写满时切换为 imm 并创建新的 WAL
+    void MakeRoomForWrite();
+
+    // 要求：持有锁
+    void NewLogFile();
+
+    // 要求：持有锁
+    // 将 flush / compaction 的结果写入 manifest_log, 并删除不再需要的 WAL
+    // 未使用 manifest 或写入失败时返回 false
+    auto LogVersionEdit(VersionEdit &edit) -> bool;
+
+    // 要求：持有锁
+    // memtable 与 imm 中的数据所在的最小 WAL 编号, 编号更小的 WAL 不再需要
+    auto GetMinLogNumber() const -> file_number_t;
+
+    // 将 WAL 中的一条写入 record 插入到 memtable, 并更新 latest_index_
+    void InsertLogRecord(std::string_view record, MemTable *mem);
+
+    void UpdateNewestTimestamp(int64_t timestamp);
+
+    // 时间戳小于返回值的数据已经过期, 未设置保留时长时返回 INT64_MIN
+    auto GetExpireTimestamp() const -> int64_t;
+
+    // 按 schema 的列顺序标记需要读取的列
+    auto GetColumnMask(const std::set<std::string> &columns) const -> ColumnMask;
+
+    auto GetQuerySnapshot() -> QuerySnapshot;
+
+    // 将 count 个单位的查询拆分为多少个子任务, 每个子任务至少 min_task_size 个单位
+    auto QueryTaskCount(size_t count, size_t min_task_size) const -> size_t;
+
+    // 将有序的 vin 拆分为连续的若干段, 在查询线程池中分别执行 function, 结果按段的顺序追加到 pReadRes
+    void ParallelVinQuery(const std::vector<Vin> &sorted_vins,
+                          const std::function<void(const std::vector<Vin> &, std::vector<Row> *)> &function,
+                          std::vector<Row> &pReadRes);
+
+    // 逐层查找有序且不重复的 vins
+    void LayeredLatestQuery(const std::vector<Vin> &vins, const std::set<std::string> &columns,
+                            const QuerySnapshot &snapshot, std::vector<Row> &pReadRes);
+
+    // 通过 latest_index_ 查询有序且不重复的 vins
+    void IndexLatestQuery(const std::vector<Vin> &vins, const std::set<std::string> &columns,
+                          std::vector<Row> &pReadRes);
+
+    // 查询 memtable 内符合时间范围的元素
+    auto MemTableRangeQuery(TableShard::RangeQueryRequest &req, const std::shared_ptr<MemTable>& memtable) -> void;
+
+    // 从 iter 的当前位置按批读取 [lower_bound_, upper_bound_] 内的行, 跳过更新的数据中已经存在的时间戳
+    void CollectRangeRows(Iterator *iter, TableShard::RangeQueryRequest &req);
+
+    // 根据文件的 key 范围与时间戳范围判断是否需要查找
+    auto FileOverlapsRange(const FileMetaDataPtr &fileMetaData, const TableShard::RangeQueryRequest &req) -> bool;
+
+    void FileTableRangeQuery(const FileMetaDataPtr& fileMetaData, TableShard::RangeQueryRequest &req);
+
+    // 后台线程任务
+    static void BGWork(void* table);
+    void BackgroundCall();
+
+    // 要求：持有锁
+    void MaybeScheduleCompaction();
+
+    // 要求：持有锁
+    // 执行一个 compaction, 没有可执行的计划时返回 false
+    auto BackgroundCompaction(std::unique_lock<std::mutex> &lock) -> bool;
+
+    // 要求：持有锁
+    // 直接删除所有数据都已过期的文件, 不存在时返回 false
+    auto DropExpiredFiles(std::unique_lock<std::mutex> &lock) -> bool;
+
+    // 要求：持有锁
+    // 文件已经从元数据中移除, logged 表示移除已经写入 manifest_log
+    void RemoveObsoleteFile(const FileMetaDataPtr &file, bool logged);
+
+    // 执行 Manual Compaction
+    auto DoManualCompaction(CompactionTask* task) -> bool;
+
+    // 将 task 的 key 范围划分为多个 subcompaction, 返回相邻范围的分界 key, 不需要拆分时为空
+    auto GetSubcompactionBoundaries(CompactionTask *task) -> std::vector<InternalKey>;
+
+    auto NewCompactionInputIterator(CompactionTask *task) -> std::unique_ptr<Iterator>;
+
+    // 压缩 task 中 [lower, upper) 范围内的 key, nullptr 表示不限制
+    void DoSubcompaction(CompactionTask *task, const InternalKey *lower, const InternalKey *upper,
+                         std::vector<FileMetaDataPtr> *outputs);
+
+    void StartMemTableCompaction(const std::shared_ptr<MemTable> mem);
+
+    // 执行 Minor Compaction, time window compaction 时按时间窗口输出多个文件
+    auto CompactMemTable(const std::shared_ptr<MemTable>& mem, file_number_t file_number) -> std::vector<FileMetaDataPtr>;
+
+    std::string table_name_{};
+    Schema schema_{};
+
+    // 按 schema 顺序排列的列类型
+    std::vector<ColumnType> column_types_;
+    uint32_t shard_id_{0};
+    DBOptions *options_{nullptr};
+
+    TableCache *table_cache_{nullptr};
+
+    std::atomic_bool is_shutting_down_{false};
+
+    // 下述是需要锁保护的变量
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    TableMetaData table_meta_data_;
+    std::shared_ptr<MemTable> mem_;
+    std::vector<std::shared_ptr<MemTable>> imm_;
+    std::deque<Writer*> write_queue_;   // 写请求队列
+
+    // 当前 mem_ 对应的 WAL
+    std::unique_ptr<LogWriter> log_;
+
+    // 元数据持久化前需要保留的 WAL
+    std::vector<file_number_t> log_numbers_;
+
+    // memtable 与 imm 的数据所在的第一个 WAL
+    std::unordered_map<const MemTable*, file_number_t> mem_log_numbers_;
+
+    // 编号小于 log_number_ 的 WAL 中的数据都已经写入 sstable 并记录在 manifest 中
+    file_number_t log_number_{0};
+
+    // 编号不小于 index_file_number_ 的 sstable 可能包含持久化的 latest index 中没有的数据
+    file_number_t index_file_number_{0};
+
+    // manifest_log 中最后记录的 latest index 文件, 0 表示没有
+    file_number_t latest_index_file_{0};
+
+    std::atomic<uint64_t> log_sync_count_{0};
+
+    std::atomic<uint64_t> sstable_probe_count_{0};
+
+    std::atomic<uint64_t> compaction_bytes_written_{0};
+
+    // 数据保留时长, 0 表示永久保留
+    int64_t retention_{0};
+
+    // 表中写入的最大时间戳, 与当前时间中较小的一个作为过期时间的基准
+    std::atomic<int64_t> *newest_timestamp_;
+
+    // 包含 shard 内所有 vin 的最新一行, 随 sstable 元数据一起持久化
+    LatestIndex latest_index_;
+
+    // 当前正在压缩的线程数量, 包括 memtable 的 flush
+    int32_t compaction_thread_count_{0};
+
+    // 已经提交到后台线程池且尚未完成的 compaction 数量
+    int32_t bg_compaction_scheduled_{0};
+
+    // 正在 flush 的 memtable 输出文件的 sequence
+    std::set<file_number_t> flushing_sequences_;
+};
+
+}  // namespace LindormContest
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include "common/macros.h"
+
+namespace LindormContest {
+
+// 按 K_DIRECT_IO_ALIGNMENT 对齐的缓冲区, 用于 O_DIRECT 读写
+// 内存从进程内共享的缓冲池中获取, 析构时归还, 避免频繁申请大块对齐内存
+class AlignedBuffer {
+public:
+    AlignedBuffer() = default;
+
+    explicit AlignedBuffer(size_t size) { Reserve(size); }
+
+    ~AlignedBuffer() { Release(); }
+
+    DISALLOW_COPY(AlignedBuffer);
+
+    AlignedBuffer(AlignedBuffer &&other) noexcept : data_(other.data_), capacity_(other.capacity_) {
+        other.data_ = nullptr;
+        other.capacity_ = 0;
+    }
+
+    auto operator=(AlignedBuffer &&other) noexcept -> AlignedBuffer & {
+        if(this != &other) {
+            Release();
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            other.data_ = nullptr;
+            other.capacity_ = 0;
+        }
+        return *this;
+    }
+
+    // 保证容量不小于 size, 容量不足时不保留原有内容
+    void Reserve(size_t size);
+
+    auto GetData() const -> char * { return data_; }
+
+    auto GetCapacity() const -> size_t { return capacity_; }
+
+private:
+    void Release();
+
+    char *data_{nullptr};
+    size_t capacity_{0};
+};
+
+}  // namespace LindormContest
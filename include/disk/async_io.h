@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace LindormContest {
+
+// 一次读取请求, 从 fd 的 offset 处读取 size 字节到 data
+struct ReadRequest {
+    int fd_;
+    char *data_;
+    uint32_t size_;
+    uint64_t offset_;
+};
+
+// 批量读取: 一次提交多个读取请求, 并行完成后返回
+// 内核支持时使用 io_uring, 否则使用 pread 线程池
+class AsyncIO {
+public:
+    virtual ~AsyncIO() = default;
+
+    // 等待所有请求完成, 任意一个请求失败时抛出 IO 异常
+    virtual void ReadBatch(std::vector<ReadRequest> &requests) = 0;
+
+    virtual auto Name() const -> const char * = 0;
+
+    // 进程内共享的实例, 第一次调用时选择实现
+    static auto Default() -> AsyncIO *;
+
+    // 内核不支持 io_uring 时返回 nullptr
+    static auto NewIoUring(uint32_t queue_depth) -> std::unique_ptr<AsyncIO>;
+
+    static auto NewThreadPool(uint32_t thread_count) -> std::unique_ptr<AsyncIO>;
+};
+
+}  // namespace LindormContest
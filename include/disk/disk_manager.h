@@ -1,7 +1,12 @@
 #ifndef LJDB_DISK_DISK_MANAGER_H
 #define LJDB_DISK_DISK_MANAGER_H
 
+#include <memory>
+#include <string>
+#include <vector>
 #include "common/config.h"
+#include "disk/async_io.h"
+#include "disk/file_writer.h"
 
 namespace LindormContest {
 
@@ -9,9 +14,12 @@ void SetDatabaseDirectory(const std::string &directory);
 
 class DiskManager {
 public:
-    static auto OpenSSTableFile(file_number_t file_number) -> std::ifstream;
+    // 以只读方式打开 sstable, 返回文件描述符, 由调用者关闭
+    // direct_io 不为 nullptr 且为 true 时以 O_DIRECT 打开, 文件系统不支持时退回普通读取并将其置为 false
+    static auto OpenSSTableFile(file_number_t file_number, bool *direct_io = nullptr) -> int;
 
-    static auto CreateSSTableFile(file_number_t file_number) -> std::ofstream;
+    // direct_io 为 true 时以 O_DIRECT 写入, 绕过 page cache
+    static auto CreateSSTableFile(file_number_t file_number, bool direct_io = false) -> std::unique_ptr<FileWriter>;
 
     static auto CreakWritableFile(const std::string& filename) -> std::ofstream;
 
@@ -23,11 +31,46 @@ public:
 
     static void ReadBlock(std::ifstream& file, char* data, uint32_t size, uint32_t offset);
 
-    static void ReadBlock(file_number_t file_number, char* data, uint32_t size, uint32_t offset);
+    // 使用 pread 读取, 不修改文件偏移, 多个线程可以同时读取同一个文件描述符
+    static void ReadBlock(int fd, char* data, uint32_t size, uint64_t offset);
 
-    static void WriteBlock(std::ofstream& file, const char* data, uint32_t size);
+    // O_DIRECT 读取, data / size / offset 都需要对齐
+    // 读到文件末尾时只要求读取 min_size 字节, 返回实际读取的字节数
+    static auto ReadDirect(int fd, char* data, uint32_t size, uint64_t offset, uint32_t min_size) -> uint32_t;
+
+    // 批量读取, 所有请求并行执行, 全部完成后返回, 见 AsyncIO
+    static void ReadBlocks(std::vector<ReadRequest> &requests);
+
+    // 以只读方式映射整个文件, 映射建立后可以关闭文件描述符
+    static auto MapFile(int fd, uint64_t size) -> const char*;
+
+    static void UnmapFile(const char* data, uint64_t size);
 
     static auto GetFileSize(std::ifstream& file) -> uint64_t;
+
+    // 以追加方式创建文件, 返回文件描述符
+    static auto CreateAppendableFile(const std::string& filename) -> int;
+
+    // 以追加方式打开文件, 不存在时创建, 保留已有内容
+    static auto OpenAppendableFile(const std::string& filename) -> int;
+
+    static void AppendFile(int fd, const char* data, size_t size);
+
+    static void TruncateFile(const std::string& filename, uint64_t size);
+
+    // 原子地替换 to
+    static void RenameFile(const std::string& from, const std::string& to);
+
+    // fdatasync, 保证追加的数据落盘
+    static void SyncFile(int fd);
+
+    // fsync 数据目录, 保证新建、重命名的文件在崩溃后仍然存在
+    static void SyncDirectory();
+
+    static void CloseFile(int fd);
+
+    // 返回数据目录下的所有文件名
+    static auto GetChildren() -> std::vector<std::string>;
 };
 
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "common/macros.h"
+#include "disk/aligned_buffer.h"
+
+namespace LindormContest {
+
+// 顺序写入一个新文件, 数据先写入对齐的缓冲区, 缓冲区满时整块写入
+// direct_io 为 true 时以 O_DIRECT 打开, 每次写入的长度与偏移都按 K_DIRECT_IO_ALIGNMENT 对齐
+// 最后一块不足对齐大小时补齐写入, 再截断到实际长度, 文件内容与普通写入相同
+class FileWriter {
+public:
+    FileWriter(const std::string &filename, bool direct_io);
+
+    ~FileWriter();
+
+    DISALLOW_COPY_AND_MOVE(FileWriter);
+
+    void Append(const char *data, size_t size);
+
+    // 写入缓冲区中剩余的数据, fdatasync 后关闭文件, 之后不能再调用 Append
+    void Close();
+
+    auto IsDirectIO() const -> bool { return direct_io_; }
+
+    // 已经追加的字节数
+    auto GetFileSize() const -> uint64_t { return file_size_; }
+
+private:
+    void WriteBuffer(size_t size);
+
+    std::string filename_;
+    int fd_{-1};
+    bool direct_io_;
+
+    AlignedBuffer buffer_;
+    size_t buffer_used_{0};
+
+    uint64_t file_size_{0};     // 逻辑长度
+    uint64_t write_offset_{0};  // 已经写入文件的长度, 总是对齐的
+};
+
+}  // namespace LindormContest
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "common/macros.h"
+
+namespace LindormContest {
+
+// memtable 使用的内存池, 内存只在 Arena 析构时统一释放
+// 要求：同一时刻只有一个线程分配内存
+class Arena {
+public:
+    Arena() = default;
+
+    ~Arena();
+
+    DISALLOW_COPY_AND_MOVE(Arena);
+
+    auto Allocate(size_t bytes) -> char*;
+
+    // 按指针大小对齐, 用于存放 skiplist 节点
+    auto AllocateAligned(size_t bytes) -> char*;
+
+    // 已申请的总内存, 可以被其他线程读取
+    auto MemoryUsage() const -> size_t { return memory_usage_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    auto AllocateFallback(size_t bytes) -> char*;
+
+    auto AllocateNewBlock(size_t block_bytes) -> char*;
+
+    char *alloc_ptr_{nullptr};
+    size_t alloc_bytes_remaining_{0};
+
+    std::vector<char*> blocks_;
+
+    std::atomic<size_t> memory_usage_{0};
+};
+
+inline auto Arena::Allocate(size_t bytes) -> char* {
+    ASSERT(bytes > 0, "allocate 0 bytes");
+    if(bytes <= alloc_bytes_remaining_) {
+        char *result = alloc_ptr_;
+        alloc_ptr_ += bytes;
+        alloc_bytes_remaining_ -= bytes;
+        return result;
+    }
+    return AllocateFallback(bytes);
+}
+
+}  // namespace LindormContest
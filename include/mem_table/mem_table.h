@@ -1,44 +1,63 @@
 #pragma once
 
-#include <mutex>
+#include <atomic>
+#include <string_view>
 #include "common/macros.h"
 #include "common/iterator.h"
+#include "mem_table/arena.h"
+#include "mem_table/skiplist.h"
 
 namespace LindormContest {
 
+// entry format (存放在 arena 中):
+// | vin (17) | timestamp (8) | sequence (8) | value length (4) | value data |
+//
+// 同一个 InternalKey 多次写入时, sequence 较大的 entry 排在前面, 迭代器只返回最新的版本
+// 写入：同一时刻只允许一个线程写入, 由 Table 的写入队列保证
+// 读取：不需要加锁
 class MemTable {
 private:
     class MemTableIterator;
 
+    struct KeyComparator {
+        auto operator()(const char *a, const char *b) const -> int;
+    };
+
+    using Table = SkipList<const char*, KeyComparator>;
+
 public:
-    explicit MemTable() = default;
+    static constexpr uint32_t SEQUENCE_SIZE = 8;
+    static constexpr uint32_t ENTRY_HEADER_SIZE = INTERNAL_KEY_SIZE + SEQUENCE_SIZE + 4;
+
+    explicit MemTable() : table_(KeyComparator(), &arena_) {}
 
     DISALLOW_COPY_AND_MOVE(MemTable);
 
     auto Insert(const Row& row) -> bool;
 
-    auto ApproximateSize() const -> size_t { return approximate_size_; }
+    // value 为 CodingUtil::EncodeRowValue 编码后的数据
+    auto Insert(const InternalKey &key, std::string_view value) -> void;
 
-    auto Clear() -> void;
+    auto ApproximateSize() const -> size_t { return approximate_size_.load(std::memory_order_relaxed); }
 
-    auto Empty() const -> bool { return approximate_size_ == 0; }
+    // arena 已申请的内存
+    auto MemoryUsage() const -> size_t { return arena_.MemoryUsage(); }
 
-    auto NewIterator() -> std::unique_ptr<Iterator>;
+    auto Empty() const -> bool { return ApproximateSize() == 0; }
 
-    auto Lock() -> void { mutex_.lock(); }
-
-    auto Unlock() -> void { mutex_.unlock(); }
+    auto NewIterator() -> std::unique_ptr<Iterator>;
 
 private:
-    std::mutex mutex_;
+    Arena arena_;
+    Table table_;
 
-    std::map<InternalKey, std::string> data_;
-    size_t approximate_size_ = 0;
+    uint64_t sequence_{0};
+    std::atomic<size_t> approximate_size_{0};
 };
 
 class MemTable::MemTableIterator : public Iterator {
 public:
-    explicit MemTableIterator(MemTable *mem_table) : mem_table_(mem_table), iter_(mem_table->data_.begin()) {};
+    explicit MemTableIterator(MemTable *mem_table) : iter_(&mem_table->table_) {};
 
     ~MemTableIterator() override = default;
 
@@ -46,17 +65,26 @@ public:
 
     auto Seek(const InternalKey &key) -> void override;
 
-    auto GetKey() -> InternalKey override;
+    auto GetKey() -> const InternalKey & override;
 
-    auto GetValue() -> std::string override;
+    auto GetValue() -> std::string_view override;
 
     auto Valid() -> bool override;
 
     auto Next() -> void override;
 
+    auto NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t override;
+
 private:
-    MemTable *mem_table_;
-    std::map<InternalKey, std::string>::iterator iter_;
+    // 移动后解码当前 entry 的 key
+    void DecodeKey() {
+        if(iter_.Valid()) {
+            key_ = InternalKey(iter_.key());
+        }
+    }
+
+    Table::Iterator iter_;
+    InternalKey key_;
 };
 
-}  // namespace LindormContest
\ No newline at end of file
+}  // namespace LindormContest
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <random>
+#include "common/macros.h"
+#include "mem_table/arena.h"
+
+namespace LindormContest {
+
+// 基于 Arena 的跳表
+// 写入：同一时刻只允许一个线程调用 Insert, 由调用者保证
+// 读取：不需要加锁, 节点在 SkipList 析构前不会被释放
+// 节点的 next 指针通过 release/acquire 发布, 读者总能看到已初始化的节点
+template<typename Key, class Comparator>
+class SkipList {
+private:
+    struct Node;
+
+public:
+    explicit SkipList(Comparator cmp, Arena *arena);
+
+    DISALLOW_COPY_AND_MOVE(SkipList);
+
+    // 要求：跳表中不存在与 key 相等的元素
+    void Insert(const Key &key);
+
+    auto Contains(const Key &key) const -> bool;
+
+    class Iterator {
+    public:
+        explicit Iterator(const SkipList *list) : list_(list) {}
+
+        auto Valid() const -> bool { return node_ != nullptr; }
+
+        auto key() const -> const Key & {
+            ASSERT(Valid(), "iterator is invalid");
+            return node_->key_;
+        }
+
+        void Next() {
+            ASSERT(Valid(), "iterator is invalid");
+            node_ = node_->Next(0);
+        }
+
+        // 定位到第一个 >= target 的元素
+        void Seek(const Key &target) { node_ = list_->FindGreaterOrEqual(target, nullptr); }
+
+        void SeekToFirst() { node_ = list_->head_->Next(0); }
+
+    private:
+        const SkipList *list_;
+        Node *node_{nullptr};
+    };
+
+private:
+    static constexpr int K_MAX_HEIGHT = 12;
+
+    auto GetMaxHeight() const -> int { return max_height_.load(std::memory_order_relaxed); }
+
+    auto NewNode(const Key &key, int height) -> Node*;
+
+    auto RandomHeight() -> int;
+
+    auto Equal(const Key &a, const Key &b) const -> bool { return compare_(a, b) == 0; }
+
+    // key 是否大于 node 中的元素
+    auto KeyIsAfterNode(const Key &key, Node *n) const -> bool {
+        return (n != nullptr) && (compare_(n->key_, key) < 0);
+    }
+
+    // 返回第一个 >= key 的节点, prev 记录每一层的前驱节点
+    auto FindGreaterOrEqual(const Key &key, Node **prev) const -> Node*;
+
+    Comparator const compare_;
+    Arena *const arena_;
+
+    Node *const head_;
+
+    std::atomic<int> max_height_{1};
+
+    std::minstd_rand rnd_{0xdeadbeef};
+};
+
+template<typename Key, class Comparator>
+struct SkipList<Key, Comparator>::Node {
+    explicit Node(const Key &k) : key_(k) {}
+
+    Key const key_;
+
+    auto Next(int n) -> Node* {
+        return next_[n].load(std::memory_order_acquire);
+    }
+
+    void SetNext(int n, Node *x) {
+        next_[n].store(x, std::memory_order_release);
+    }
+
+    auto NoBarrierNext(int n) -> Node* {
+        return next_[n].load(std::memory_order_relaxed);
+    }
+
+    void NoBarrierSetNext(int n, Node *x) {
+        next_[n].store(x, std::memory_order_relaxed);
+    }
+
+private:
+    // 长度等于节点高度, next_[0] 为最底层
+    std::atomic<Node*> next_[1];
+};
+
+template<typename Key, class Comparator>
+auto SkipList<Key, Comparator>::NewNode(const Key &key, int height) -> Node* {
+    char *const node_memory = arena_->AllocateAligned(
+            sizeof(Node) + sizeof(std::atomic<Node*>) * (height - 1));
+    return new (node_memory) Node(key);
+}
+
+template<typename Key, class Comparator>
+auto SkipList<Key, Comparator>::RandomHeight() -> int {
+    // 以 1/4 的概率增加高度
+    int height = 1;
+    while(height < K_MAX_HEIGHT && (rnd_() % 4) == 0) {
+        height++;
+    }
+    return height;
+}
+
+template<typename Key, class Comparator>
+auto SkipList<Key, Comparator>::FindGreaterOrEqual(const Key &key, Node **prev) const -> Node* {
+    Node *x = head_;
+    int level = GetMaxHeight() - 1;
+    while(true) {
+        Node *next = x->Next(level);
+        if(KeyIsAfterNode(key, next)) {
+            x = next;
+        } else {
+            if(prev != nullptr) {
+                prev[level] = x;
+            }
+            if(level == 0) {
+                return next;
+            }
+            level--;
+        }
+    }
+}
+
+template<typename Key, class Comparator>
+SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena *arena)
+    : compare_(cmp), arena_(arena), head_(NewNode(Key(), K_MAX_HEIGHT)) {
+    for(int i = 0; i < K_MAX_HEIGHT; i++) {
+        head_->SetNext(i, nullptr);
+    }
+}
+
+template<typename Key, class Comparator>
+void SkipList<Key, Comparator>::Insert(const Key &key) {
+    Node *prev[K_MAX_HEIGHT];
+    Node *x = FindGreaterOrEqual(key, prev);
+    ASSERT(x == nullptr || !Equal(key, x->key_), "duplicate key in skiplist");
+
+    int height = RandomHeight();
+    if(height > GetMaxHeight()) {
+        for(int i = GetMaxHeight(); i < height; i++) {
+            prev[i] = head_;
+        }
+        // 读者看到新的高度后, 会从 head_ 的高层读到 nullptr 并下降, 不会出错
+        max_height_.store(height, std::memory_order_relaxed);
+    }
+
+    x = NewNode(key, height);
+    for(int i = 0; i < height; i++) {
+        x->NoBarrierSetNext(i, prev[i]->NoBarrierNext(i));
+        prev[i]->SetNext(i, x);
+    }
+}
+
+template<typename Key, class Comparator>
+auto SkipList<Key, Comparator>::Contains(const Key &key) const -> bool {
+    Node *x = FindGreaterOrEqual(key, nullptr);
+    return x != nullptr && Equal(key, x->key_);
+}
+
+}  // namespace LindormContest
@@ -18,9 +18,14 @@ private:
     class BlockIterator;
 
 public:
-    explicit Block(char* data, uint32_t size);
+    // owned 为 false 时 data 由外部管理, 例如 mmap 映射的 sstable
+    explicit Block(char* data, uint32_t size, bool owned = true);
 
-    ~Block() { delete []data_; }
+    ~Block() {
+        if(owned_) {
+            delete []data_;
+        }
+    }
 
     auto NewIterator() -> std::unique_ptr<Iterator>;
 
@@ -34,14 +39,16 @@ private:
     const uint32_t block_magic_{BLOCK_MAGIC};
     char *data_;
     const uint32_t size_;
-    
+    const bool owned_;
+
     uint32_t num_entries_;
 };
 
 
+// 格式见 BlockBuilder, Seek 先在 restart point 上二分查找, 再顺序解码
 class Block::BlockIterator : public Iterator {
 public:
-    explicit BlockIterator(const char *data, uint32_t size, uint32_t num_entries);
+    explicit BlockIterator(const char *data, uint32_t size);
 
     ~BlockIterator() override = default;
 
@@ -49,23 +56,37 @@ public:
 
     void Seek(const InternalKey &key) override;
 
-    auto GetKey() -> InternalKey override;
+    auto GetKey() -> const InternalKey & override;
 
-    auto GetValue() -> std::string override;
+    auto GetValue() -> std::string_view override;
 
     auto Valid() -> bool override;
 
     auto Next() -> void override;
 
+    auto NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t override;
+
 private:
+    auto GetRestartPoint(uint32_t index) const -> uint32_t;
+
+    void SeekToRestartPoint(uint32_t index);
+
+    // 解码 next_ 处的 entry, 没有更多 entry 时返回 false
+    auto ParseNextKey() -> bool;
+
     const char *data_;
 
-    // Offset of entry array
-    const uint32_t *entry_array_;
+    // restart offset array 的起始位置, 也是 entry 的结束位置
+    uint32_t restarts_;
+    uint32_t num_restarts_;
 
-    uint32_t num_entries_;
+    // 当前 entry 与下一个 entry 的位置
+    uint32_t current_;
+    uint32_t next_;
 
-    uint32_t curr_idx_{0};
+    InternalKey key_;
+    const char *value_{nullptr};
+    uint32_t value_size_{0};
 };
 
 
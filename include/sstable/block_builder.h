@@ -2,6 +2,7 @@
 
 
 #include <cstdint>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <memory>
@@ -13,13 +14,19 @@
 namespace LindormContest {
 
 // block format:
-// entry : | key | value length | value data|
+// entry : | shared vin length (1) | non shared vin length (1) | vin suffix | timestamp delta (varint) |
+//         | value length (varint) | value data |
 //
-// Block : | entry  | entry    | ... | entry |      | entry offset array | num entries|
+// Block : | entry  | entry    | ... | entry | restart offset array | num restarts (4) | num entries (4) |
+//
+// 每 RESTART_INTERVAL 个 entry 设置一个 restart point, restart point 处的 entry 保存完整的 vin,
+// timestamp delta 为与前一个 entry 时间戳之差的 zigzag 编码, restart point 处与 0 相减
 class BlockBuilder {
 public:
-    static constexpr uint32_t INITIAL_SIZE = 4;
-    static constexpr uint32_t ENTRY_LENGTH_SIZE = 4 + 4 + 4;
+    static constexpr uint32_t INITIAL_SIZE = 4 + 4;
+    static constexpr uint32_t RESTART_INTERVAL = 16;
+    // entry 中除 key 与 value 外的最大开销, 包括 restart offset
+    static constexpr uint32_t ENTRY_LENGTH_SIZE = 1 + 1 + 2 + 5 + 4;
 
     explicit BlockBuilder(uint32_t capacity) : capacity_(capacity) {}
     DISALLOW_COPY_AND_MOVE(BlockBuilder);
@@ -28,20 +35,25 @@ public:
 
     auto Init() -> void;
 
+    // 要求：key 递增
     auto Add(const InternalKey &key, std::string_view value) -> bool;
 
     auto EstimatedSize() const -> uint32_t {return curr_size_;}
 
     auto Builder() -> std::unique_ptr<Block>;
 
-    auto Empty() -> bool {return entry_offsets_.empty(); }
+    auto Empty() -> bool {return num_entries_ == 0; }
 
 private:
     char* data_{nullptr};
     uint32_t capacity_;
     uint32_t offset_{};
     uint32_t curr_size_{INITIAL_SIZE};
-    std::vector<uint32_t> entry_offsets_{};
+    uint32_t num_entries_{0};
+    std::vector<uint32_t> restarts_{};
+
+    InternalKey last_key_{};
+    std::string entry_{};
 };
 
 }  // namespace ljdb
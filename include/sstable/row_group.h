@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/column_batch.h"
+#include "common/iterator.h"
+
+namespace LindormContest {
+
+// 列式 sstable 中的一个 row group, 由一个 key chunk 和每一列各自的 column chunk 组成
+// 每个 chunk 单独压缩, 读取时只需要解压查询的列
+//
+// key chunk    : | key | key | ... | key | num rows |
+// column chunk : | value | value | ... | value | num rows |
+// value 的编码与 CodingUtil::DecodeRow 一致: int 4 字节, double 8 字节, string | length (4) | data |
+
+// 遍历一个 row group, GetValue 返回按 schema 顺序编码的整行, 拼接在迭代器内复用的缓冲区中
+// 未读取的列 (columns 中为 nullptr) 使用默认值填充
+class RowGroupIterator : public Iterator {
+public:
+    RowGroupIterator(const std::vector<ColumnType> *column_types, const char *keys, uint32_t num_rows,
+                     std::vector<const char *> columns);
+
+    ~RowGroupIterator() override = default;
+
+    auto SeekToFirst() -> void override;
+
+    void Seek(const InternalKey &key) override;
+
+    auto GetKey() -> const InternalKey & override;
+
+    auto GetValue() -> std::string_view override;
+
+    auto Valid() -> bool override;
+
+    auto Next() -> void override;
+
+    auto NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t override;
+
+private:
+    // 将每一列的偏移移动到 curr_idx_ 对应的行
+    void PositionColumns();
+
+    const std::vector<ColumnType> *column_types_;
+    const char *keys_;
+    uint32_t num_rows_;
+    uint32_t curr_idx_{0};
+
+    std::vector<const char *> columns_;
+    std::vector<uint32_t> column_offsets_;
+    uint32_t column_idx_{0};    // column_offsets_ 对应的行
+
+    InternalKey key_;
+    std::string value_;
+};
+
+}  // namespace LindormContest
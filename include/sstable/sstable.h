@@ -1,18 +1,74 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <memory>
 #include <fstream>
 
+#include "common/config.h"
 #include "sstable/block.h"
+#include "sstable/row_group.h"
 #include "disk/disk_manager.h"
 #include "common/macros.h"
 #include "cache/cache.h"
+#include "util/bloom.h"
 
 namespace LindormContest {
 
-const constexpr size_t SSTABLE_FOOTER_LENGTH = CodingUtil::LENGTH_SIZE;
+// sstable format:
+// | data block / row group | ... | filter | index block | column types | footer |
+// footer : | filter offset (4) | index block offset (4) | column types offset (4) |
+//
+// filter 为所有 vin 的布隆过滤器, 可以为空
+//
+// 行式 sstable 的 column types 为空, index 指向 data block
+// 列式 sstable 每列记录 1 字节的 ColumnType, index 指向 row group:
+// index value : | row group offset (8) | key chunk size (4) | column chunk size (4) | ... |
+//
+// 每个 index value 的末尾都记录了对应 block / row group 的 zone map, 见 ZoneMap
+const constexpr size_t SSTABLE_FOOTER_LENGTH = CodingUtil::LENGTH_SIZE * 3;
+
+
+// block / row group 的第一个 key 与时间戳范围, 位于 index value 的末尾
+// | first key (25) | min timestamp (8) | max timestamp (8) |
+struct ZoneMap {
+    static constexpr size_t SIZE = INTERNAL_KEY_SIZE + CodingUtil::FIXED_64_SIZE * 2;
+
+    InternalKey first_key_;
+    int64_t min_timestamp_{MAX_TIMESTAMP};
+    int64_t max_timestamp_{INT64_MIN};
+
+    ZoneMap() = default;
+
+    // 从 index value 的末尾解析
+    explicit ZoneMap(std::string_view index_value) {
+        ASSERT(index_value.size() >= SIZE, "index value is too short");
+        const char *p = index_value.data() + index_value.size() - SIZE;
+        first_key_ = InternalKey(p);
+        min_timestamp_ = CodingUtil::DecodeInt64(p + INTERNAL_KEY_SIZE);
+        max_timestamp_ = CodingUtil::DecodeInt64(p + INTERNAL_KEY_SIZE + CodingUtil::FIXED_64_SIZE);
+    }
+
+    // key 必须有序添加
+    auto Add(const InternalKey &key) -> void {
+        if(min_timestamp_ > max_timestamp_) {
+            first_key_ = key;
+        }
+        min_timestamp_ = std::min(min_timestamp_, key.timestamp_);
+        max_timestamp_ = std::max(max_timestamp_, key.timestamp_);
+    }
+
+    auto EncodeTo(std::string *dst) const -> void {
+        dst->append(first_key_.Encode());
+        char buffer[CodingUtil::FIXED_64_SIZE];
+        CodingUtil::PutInt64(buffer, min_timestamp_);
+        dst->append(buffer, CodingUtil::FIXED_64_SIZE);
+        CodingUtil::PutInt64(buffer, max_timestamp_);
+        dst->append(buffer, CodingUtil::FIXED_64_SIZE);
+    }
+};
 
 
 // iterator 中支持 cache 的删除操作
@@ -29,33 +85,130 @@ static void IteratorCleanupBlock(void *arg, void* value) {
 }
 
 
+class SSTable;
+
+// 批量预读的一个 block, 由 SSTable::CollectPrefetch 生成
+// request_ 读取完成后调用 SSTable::InstallPrefetch 解码并放入 block cache
+struct BlockPrefetch {
+    SSTable *sstable_;
+    uint64_t offset_;
+    uint32_t size_;
+    int column_;
+    AlignedBuffer buffer_;
+    uint32_t skip_;     // O_DIRECT 读取按对齐范围进行, block 在 buffer_ 中的偏移
+    ReadRequest request_;
+};
+
+
 class SSTable {
 public:
-    SSTable(file_number_t file_number, uint64_t file_size, Cache<Block> *cache = nullptr);
+    // use_mmap 为 true 时映射整个文件, index block 直接引用映射的内存, 其它 block 从映射的内存解码
+    // direct_io 为 true 时以 O_DIRECT 读取, 忽略 use_mmap
+    SSTable(file_number_t file_number, uint64_t file_size, Cache<Block> *cache = nullptr, bool use_mmap = false,
+            bool direct_io = false);
 
-    SSTable(file_number_t file_number, uint64_t file_size, std::unique_ptr<Block> index_block, Cache<Block> *cache = nullptr)
-        : file_number_(file_number), file_size_(file_size), index_block_(std::move(index_block)), cache_(cache) {}
+    SSTable(file_number_t file_number, uint64_t file_size, std::unique_ptr<Block> index_block, Cache<Block> *cache = nullptr,
+            std::vector<ColumnType> column_types = {}, std::string filter = {}, bool direct_io = false)
+        : file_number_(file_number), file_size_(file_size), direct_io_(direct_io),
+          fd_(DiskManager::OpenSSTableFile(file_number, &direct_io_)), cache_(cache),
+          index_block_(std::move(index_block)), column_types_(std::move(column_types)), filter_(std::move(filter)) {}
 
     DISALLOW_COPY_AND_MOVE(SSTable);
 
-    auto NewIterator() -> std::unique_ptr<Iterator>;
+    ~SSTable();
+
+    // column_mask 为 nullptr 时读取所有列, 行式 sstable 忽略 column_mask
+    auto NewIterator(const ColumnMask *column_mask = nullptr) -> std::unique_ptr<Iterator>;
+
+    auto IsColumnar() const -> bool { return !column_types_.empty(); }
+
+    auto IsMapped() const -> bool { return mapped_data_ != nullptr; }
+
+    auto IsDirectIO() const -> bool { return direct_io_; }
+
+    // 通过布隆过滤器判断 sstable 是否可能包含 vin, 返回 false 时一定不包含
+    auto MayContain(const Vin &vin) const -> bool {
+        return BloomFilter::KeyMayMatch(std::string_view(vin.vin, VIN_LENGTH), filter_);
+    }
 
     auto GetFileNumber() const -> file_number_t { return file_number_; }
 
     auto GetFileSize() const -> uint64_t { return file_size_; }
 
-    static auto ReadBlock(void* arg, const std::string &key) -> std::unique_ptr<Iterator>;
+    // 只返回可能包含 [lower, upper] 内 key 的 block / row group, 根据 zone map 跳过其它 block 且不读取
+    // 迭代器仍会返回这些 block 中范围外的 key, 需要调用者过滤
+    auto NewRangeIterator(const InternalKey &lower, const InternalKey &upper,
+                          const ColumnMask *column_mask = nullptr) -> std::unique_ptr<Iterator>;
+
+    // 收集 vins 最新一行所在且不在 block cache 中的 block, 批量读取后调用 InstallPrefetch
+    // 不使用 block cache 或映射文件时不需要预读
+    void CollectPrefetch(const std::vector<Vin> &vins, const ColumnMask *column_mask, std::vector<BlockPrefetch> *prefetches);
+
+    void InstallPrefetch(BlockPrefetch &prefetch);
+
+    // 从 block cache 中删除该 sstable 的所有 block, 文件删除前调用
+    void EvictBlocks();
+
+    // index block 中每个 block / row group 的 key, 不读取 data block
+    void GetBlockKeys(std::vector<InternalKey> *keys) const;
+
+    // 从磁盘读取的 block / chunk 数量
+    auto TestGetBlockReadCount() const -> uint64_t { return block_read_count_.load(std::memory_order_relaxed); }
+
+    static auto ReadBlock(void* arg, std::string_view key) -> std::unique_ptr<Iterator>;
 
     auto GetBlockCacheID(block_id_t block_id) -> cache_id_t;
 
 private:
+    // 列式 sstable 迭代器的参数, 由迭代器释放
+    struct RowGroupReadArg {
+        SSTable *sstable_;
+        ColumnMask column_mask_;
+    };
+
+    static auto ReadRowGroup(void* arg, std::string_view key) -> std::unique_ptr<Iterator>;
+
+    // LoadBlock 读取的 block 类型, 大于等于 0 时表示第 column 列的 column chunk
+    static constexpr int K_DATA_BLOCK = -2;
+    static constexpr int K_KEY_CHUNK = -1;
+
+    // 从 cache 或磁盘中读取并解码一个 block
+    // 位于 cache 中时 handle 不为 nullptr, 需要通过 RegisterBlockCleanup 交给迭代器释放
+    auto LoadBlock(uint64_t offset, uint64_t size, int column, CacheHandle<Block> **handle) -> Block*;
+
+    void RegisterBlockCleanup(Iterator *iter, Block *block, CacheHandle<Block> *handle);
+
+    // 解码从磁盘读取的 block, 数据损坏时抛出 IO 异常
+    auto DecodeBlock(const char *raw, uint64_t size, int column) -> Block*;
+
+    // 读取文件中的一段数据, 映射文件时直接返回映射的内存, 否则读入 scratch
+    // O_DIRECT 时读取包含该段数据的对齐范围, 返回值指向 scratch 中的对应位置
+    auto ReadRaw(uint64_t offset, uint32_t size, AlignedBuffer *scratch) const -> const char*;
+
     file_number_t file_number_; // sstable 编号
     uint64_t file_size_; // sstable 大小
 
+    // 是否以 O_DIRECT 打开, 需要在 fd_ 之前初始化
+    bool direct_io_;
+
+    // sstable 存活期间一直打开, 所有读取共享该文件描述符
+    int fd_;
+
+    // 使用 mmap 时整个文件的映射, 否则为 nullptr
+    const char *mapped_data_{nullptr};
+
     Cache<Block>* cache_;
 
     // index block
     std::unique_ptr<Block> index_block_{nullptr};
+
+    // 列式 sstable 每一列的类型, 行式 sstable 为空
+    std::vector<ColumnType> column_types_;
+
+    // vin 布隆过滤器, 常驻内存
+    std::string filter_;
+
+    std::atomic<uint64_t> block_read_count_{0};
 };
 
 }  // namespace LindormContest
@@ -2,14 +2,15 @@
 
 #include <cstdint>
 #include <string>
+#include <memory>
 #include <vector>
-#include <fstream>
 
 #include "common/config.h"
 #include "sstable/block.h"
 #include "sstable/block_builder.h"
 #include "sstable/sstable.h"
 #include "disk/disk_manager.h"
+#include "struct/Schema.h"
 
 namespace LindormContest {
 
@@ -36,19 +37,29 @@ struct BlockMeta {
     uint32_t offset_;
     uint64_t size_;
     InternalKey end_key_;
+    ZoneMap zone_map_;
 
-    BlockMeta(uint32_t offset_, uint64_t size, InternalKey end_key)
-            : offset_(offset_), size_(size), end_key_(std::move(end_key)) {}
+    BlockMeta(uint32_t offset_, uint64_t size, InternalKey end_key, const ZoneMap &zone_map)
+            : offset_(offset_), size_(size), end_key_(std::move(end_key)), zone_map_(zone_map) {}
 };
 
 class SStableBuilder {
 public:
-    explicit SStableBuilder(file_number_t file_number, Cache<Block> *block_cache = nullptr, uint32_t block_size = SSTABLE_BLOCK_CAPACITY)
-        : file_number_(file_number), block_cache_(block_cache), file_(DiskManager::CreateSSTableFile(file_number)), block_builder_(block_size) {}
+    // 行式 sstable, value 为任意数据
+    // direct_io 为 true 时以 O_DIRECT 写入, Builder 返回的 SSTable 也以 O_DIRECT 读取
+    explicit SStableBuilder(file_number_t file_number, Cache<Block> *block_cache = nullptr, uint32_t block_size = SSTABLE_BLOCK_CAPACITY,
+                            bool direct_io = false)
+        : file_number_(file_number), direct_io_(direct_io), file_(DiskManager::CreateSSTableFile(file_number, direct_io)),
+          block_cache_(block_cache), block_builder_(block_size) {}
+
+    // 列式 sstable, value 必须是按 schema 编码的整行, 每一列单独存储
+    // bloom_bits_per_key 为 0 时不生成 vin 布隆过滤器
+    explicit SStableBuilder(file_number_t file_number, Cache<Block> *block_cache, const Schema &schema, bool direct_io = false,
+                            int bloom_bits_per_key = K_BLOOM_BITS_PER_KEY,
+                            uint32_t row_group_size = SSTABLE_ROW_GROUP_CAPACITY);
 
     // 要求：之前没有调用过 Builder
-    // TODO 将行式存储改为列式存储
-    auto Add(const InternalKey &key, std::string &value) -> void;
+    auto Add(const InternalKey &key, std::string_view value) -> void;
 
     auto Builder() -> std::unique_ptr<SSTable>;
 
@@ -57,19 +68,45 @@ public:
 private:
     auto FlushBlock() -> void;
 
+    auto AddToRowGroup(const InternalKey &key, std::string_view value) -> void;
+
+    auto FlushRowGroup() -> void;
+
+    // 记录 filter 的 key, key 有序, 相同的 vin 只记录一次
+    auto AddFilterKey(const InternalKey &key) -> void;
+
+    // 编码并写入一个 chunk, column 为 -1 时表示 key chunk, 返回写入的大小
+    auto WriteChunk(std::string &chunk, int column) -> uint32_t;
+
     // 与 SSTable 的 GetBlockCacheID 相同
     auto GetBlockCacheID(block_id_t block_id) -> cache_id_t;
 
     file_number_t file_number_;
 
-    std::ofstream file_;
+    bool direct_io_;
+
+    std::unique_ptr<FileWriter> file_;
     Cache<Block> *block_cache_;
 
     BlockBuilder block_builder_;    // 用于构建 block
     InternalKey end_key_;         // 当前构建 block 的最后一个 key
+    ZoneMap zone_map_{};          // 当前构建 block / row group 的 zone map
 
     std::vector<BlockMeta> block_meta_{};
 
+    // 列式 sstable 当前构建的 row group
+    std::vector<ColumnType> column_types_{};
+    uint32_t row_group_size_{0};
+    std::string key_chunk_{};
+    std::vector<std::string> column_chunks_{};
+    uint32_t row_group_rows_{0};
+    uint32_t row_group_bytes_{0};
+    std::vector<std::string> row_group_index_{};    // 与 block_meta_ 一一对应的 index value
+
+    // vin 布隆过滤器
+    int bloom_bits_per_key_{K_BLOOM_BITS_PER_KEY};
+    std::string filter_keys_{};    // 所有不同的 vin, 每个 VIN_LENGTH 字节
+
     uint32_t estimated_size_{0};
     uint64_t offset_{0};
 };
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LindormContest {
+
+// 布隆过滤器, 与 LevelDB 的 BloomFilterPolicy 相同, 使用 double hashing 生成 k 个哈希值
+// filter 格式: | bit array | k (1) |
+class BloomFilter {
+public:
+    // 根据 keys 生成 filter 并追加到 dst
+    static void CreateFilter(const std::vector<std::string_view> &keys, int bits_per_key, std::string *dst) {
+        // k = bits_per_key * ln(2)
+        auto k = static_cast<size_t>(bits_per_key * 0.69);
+        k = std::max<size_t>(1, std::min<size_t>(30, k));
+
+        size_t bits = std::max<size_t>(64, keys.size() * bits_per_key);
+        size_t bytes = (bits + 7) / 8;
+        bits = bytes * 8;
+
+        auto init_size = dst->size();
+        dst->resize(init_size + bytes, 0);
+        dst->push_back(static_cast<char>(k));
+        char *array = dst->data() + init_size;
+        for(auto &key : keys) {
+            uint32_t h = Hash(key);
+            const uint32_t delta = (h >> 17) | (h << 15);
+            for(size_t j = 0; j < k; j++) {
+                const uint32_t bit_pos = h % bits;
+                array[bit_pos / 8] |= static_cast<char>(1 << (bit_pos % 8));
+                h += delta;
+            }
+        }
+    }
+
+    // key 一定不存在时返回 false, filter 为空时返回 true
+    static auto KeyMayMatch(std::string_view key, std::string_view filter) -> bool {
+        if(filter.size() < 2) {
+            return true;
+        }
+
+        const size_t bits = (filter.size() - 1) * 8;
+        const size_t k = static_cast<uint8_t>(filter.back());
+        if(k > 30) {
+            return true;
+        }
+
+        uint32_t h = Hash(key);
+        const uint32_t delta = (h >> 17) | (h << 15);
+        for(size_t j = 0; j < k; j++) {
+            const uint32_t bit_pos = h % bits;
+            if((filter[bit_pos / 8] & (1 << (bit_pos % 8))) == 0) {
+                return false;
+            }
+            h += delta;
+        }
+        return true;
+    }
+
+private:
+    // murmur 风格的哈希
+    static auto Hash(std::string_view key) -> uint32_t {
+        const uint32_t m = 0xc6a4a793;
+        const uint32_t seed = 0xbc9f1d34;
+        const auto *p = reinterpret_cast<const uint8_t *>(key.data());
+        const auto *limit = p + key.size();
+        uint32_t h = seed ^ (key.size() * m);
+
+        while(p + 4 <= limit) {
+            uint32_t w = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+            p += 4;
+            h += w;
+            h *= m;
+            h ^= (h >> 16);
+        }
+
+        switch(limit - p) {
+            case 3:
+                h += static_cast<uint32_t>(p[2]) << 16;
+                [[fallthrough]];
+            case 2:
+                h += static_cast<uint32_t>(p[1]) << 8;
+                [[fallthrough]];
+            case 1:
+                h += p[0];
+                h *= m;
+                h ^= (h >> 24);
+                break;
+            default:
+                break;
+        }
+        return h;
+    }
+};
+
+}  // namespace LindormContest
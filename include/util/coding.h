@@ -60,6 +60,39 @@ public:
         return *reinterpret_cast<const int64_t *>(data);
     }
 
+    // varint: 每字节 7 位有效数据, 最高位表示后续是否还有字节
+    static auto PutVarint64(std::string *dst, uint64_t value) -> void {
+        while(value >= 0x80) {
+            dst->push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        dst->push_back(static_cast<char>(value));
+    }
+
+    // 解析失败时返回 false
+    static auto GetVarint64(const char **p, const char *limit, uint64_t *value) -> bool {
+        uint64_t result = 0;
+        for(uint32_t shift = 0; shift <= 63 && *p < limit; shift += 7) {
+            uint64_t byte = static_cast<uint8_t>(**p);
+            (*p)++;
+            result |= (byte & 0x7f) << shift;
+            if((byte & 0x80) == 0) {
+                *value = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // zigzag: 将有符号数映射为无符号数, 使绝对值小的负数也能用较短的 varint 表示
+    static auto ZigZagEncode(int64_t value) -> uint64_t {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    static auto ZigZagDecode(uint64_t value) -> int64_t {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
     static auto DecodeInteger(const char *data) -> int32_t {
         return *reinterpret_cast<const int32_t *>(data);
     }
@@ -68,27 +101,32 @@ public:
         return *reinterpret_cast<const double_t *>(data);
     }
 
-    static auto EncodeRow(Row row) -> std::string {
-        std::string buffer;
+    // 将 row 的所有列按 schema 顺序编码后追加到 dst, 格式与 DecodeRow 一致
+    static auto EncodeRowValue(const Row &row, std::string *dst) -> bool {
         for(auto &col : row.columns) {
             if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_DOUBLE_FLOAT) {
-                buffer.resize(8);
-                memcpy(buffer.data(), col.second.columnData, 8);
+                dst->append(col.second.columnData, 8);
             } else if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_INTEGER) {
-                buffer.resize(4);
-                memcpy(buffer.data(), col.second.columnData, 4);
+                dst->append(col.second.columnData, 4);
             } else if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_STRING) {
                 std::pair<int32_t, const char *> value;
                 if(col.second.getStringValue(value) != 0) {
-                    return "";
+                    return false;
                 }
-                buffer.resize(4 + value.first);
-                memcpy(buffer.data(), &value.first, 4);
-                memcpy(buffer.data() + 4, value.second, value.first);
+                dst->append(reinterpret_cast<const char *>(&value.first), 4);
+                dst->append(value.second, value.first);
             } else {
-                return "";
+                return false;
             }
         }
+        return true;
+    }
+
+    static auto EncodeRow(const Row &row) -> std::string {
+        std::string buffer;
+        if(!EncodeRowValue(row, &buffer)) {
+            return "";
+        }
         return buffer;
     }
 
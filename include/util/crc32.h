@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace LindormContest {
+
+// CRC-32 (IEEE 802.3), 用于校验 WAL 记录
+class Crc32 {
+public:
+    static auto Value(const char *data, size_t n) -> uint32_t {
+        static const auto table = MakeTable();
+        uint32_t crc = 0xffffffffU;
+        auto p = reinterpret_cast<const uint8_t *>(data);
+        for(size_t i = 0; i < n; i++) {
+            crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+        }
+        return crc ^ 0xffffffffU;
+    }
+
+private:
+    static auto MakeTable() -> std::array<uint32_t, 256> {
+        std::array<uint32_t, 256> table{};
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for(int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }
+};
+
+}  // namespace LindormContest
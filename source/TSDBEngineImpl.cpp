@@ -10,6 +10,7 @@
 #include "common/logger.h"
 #include <unistd.h>
 #include <fcntl.h>
+#include <algorithm>
 
 
 namespace LindormContest {
@@ -39,40 +40,179 @@ namespace LindormContest {
             db_option_ = NewDBOptions();
         }
 
-        if(tables_.empty()) {
+        if(std::atomic_load(&tables_)->empty()) {
+            auto tables = std::make_shared<TableMap>();
+            manifest_ = std::make_unique<Manifest>();
+            db_option_->manifest_ = manifest_.get();
+
             std::ifstream file;
+            bool exist_manifest = true;
             try {
-                file = DiskManager::OpenFile("/manifest_file");
+                file = DiskManager::OpenFile(MANIFEST_FILE_NAME);
             } catch (Exception &e) {
-                if(e.Type() == ExceptionType::IO) {
-                    LOG_INFO("manifest_file not found");
-                    return 0;
+                if(e.Type() != ExceptionType::IO) {
+                    LOG_ERROR("manifest_file open failed");
+                    return -1;
+                }
+                LOG_INFO("manifest_file not found");
+                exist_manifest = false;
+            }
+
+            if(exist_manifest) {
+                try {
+                    file.seekg(0, std::ios::end);
+                    auto file_size = file.tellg();
+                    file.seekg(0, std::ios::beg);
+
+                    // 读取 generation 与 file number
+                    char buffer[4];
+                    file.read(buffer, 4);
+                    manifest_->SetGeneration(CodingUtil::DecodeUint32(buffer));
+                    file.read(buffer, 4);
+                    db_option_->next_file_number_.store(CodingUtil::DecodeUint32(buffer), std::memory_order_release);
+
+                    // 回放 manifest_log 前不能开始压缩
+                    while(file.tellg() < file_size) {
+                        auto table = new Table("", Schema(), db_option_);
+                        table->ReadMetaData(file, false);
+                        tables->emplace(table->GetTableName(), table);
+                    }
+                } catch (Exception &e) {
+                    file.close();
+                    return -1;
+                }
+                file.close();
+            }
+
+            try {
+                manifest_->Recover([&](ManifestRecordType type, const std::string &table_name, std::string_view body) {
+                    ApplyManifestRecord(*tables, type, table_name, body);
+                });
+                for(auto &table : *tables) {
+                    table.second->RecoverLatestIndex();
                 }
-                LOG_ERROR("manifest_file open failed");
+                if(manifest_->GetLogSize() > K_MANIFEST_LOG_COMPACTION_SIZE) {
+                    WriteManifestSnapshot(*tables);
+                }
+            } catch (Exception &e) {
+                LOG_ERROR("recover manifest failed : %s", e.what());
                 return -1;
             }
 
+            for(auto &table : *tables) {
+                table.second->ScheduleCompaction();
+            }
+
+            if(RecoverLogFiles(*tables) != 0) {
+                return -1;
+            }
+            std::atomic_store(&tables_, std::shared_ptr<const TableMap>(std::move(tables)));
+        }
+        return 0;
+    }
+
+    void TSDBEngineImpl::ApplyManifestRecord(TableMap &tables, ManifestRecordType type, const std::string &table_name,
+                                             std::string_view body) {
+        if(type == MANIFEST_NEW_TABLE) {
+            if(body.size() < CodingUtil::LENGTH_SIZE) {
+                throw Exception(ExceptionType::IO, "corrupted manifest_log record");
+            }
+            if(tables.count(table_name) == 0) {
+                auto shard_count = CodingUtil::DecodeUint32(body.data());
+                auto schema = CodingUtil::BytesToSchema(std::string(body.substr(CodingUtil::LENGTH_SIZE)));
+                tables.emplace(table_name, new Table(table_name, schema, db_option_, shard_count));
+            }
+            return;
+        }
+
+        auto iter = tables.find(table_name);
+        if(iter == tables.end()) {
+            throw Exception(ExceptionType::IO, "manifest_log refers to unknown table " + table_name);
+        }
+
+        if(type == MANIFEST_VERSION_EDIT) {
+            VersionEdit edit;
+            if(!edit.DecodeFrom(body)) {
+                throw Exception(ExceptionType::IO, "corrupted manifest_log record");
+            }
+            iter->second->ApplyVersionEdit(edit);
+            auto next_file_number = static_cast<int32_t>(edit.next_file_number_);
+            if(next_file_number > db_option_->next_file_number_.load(std::memory_order_acquire)) {
+                db_option_->next_file_number_.store(next_file_number, std::memory_order_release);
+            }
+        } else if(type == MANIFEST_LATEST_INDEX) {
+            if(body.size() != CodingUtil::LENGTH_SIZE * 2) {
+                throw Exception(ExceptionType::IO, "corrupted manifest_log record");
+            }
+            iter->second->ApplyLatestIndex(CodingUtil::DecodeUint32(body.data()),
+                                           CodingUtil::DecodeUint32(body.data() + CodingUtil::LENGTH_SIZE));
+        } else {
+            throw Exception(ExceptionType::IO, "unknown manifest_log record type");
+        }
+    }
+
+    void TSDBEngineImpl::WriteManifestSnapshot(const TableMap &tables) {
+        LOG_INFO("write manifest_file, manifest_log size = %lu", manifest_->GetLogSize());
+        manifest_->WriteSnapshot([&](std::ofstream &file) {
+            char buffer[4];
+            CodingUtil::EncodeValue(buffer, db_option_->next_file_number_.load(std::memory_order_acquire));
+            file.write(buffer, 4);
+
+            for(auto &table : tables) {
+                table.second->WriteMetaData(file);
+            }
+        });
+
+        // 快照中已经包含 latest index, 清空后的 manifest_log 不再引用任何 latest index 文件
+        const std::string prefix = LATEST_INDEX_NAME.substr(1) + "_";
+        for(auto &filename : DiskManager::GetChildren()) {
+            if(filename.compare(0, prefix.size(), prefix) == 0) {
+                DiskManager::RemoveFile("/" + filename);
+            }
+        }
+    }
+
+    auto TSDBEngineImpl::RecoverLogFiles(TableMap &tables) -> int {
+        // 按编号顺序回放上次未正常关闭时遗留的 WAL
+        std::vector<file_number_t> log_numbers;
+        const std::string prefix = LOG_NAME.substr(1) + "_";
+        for(auto &filename : DiskManager::GetChildren()) {
+            if(filename.compare(0, prefix.size(), prefix) == 0) {
+                log_numbers.push_back(static_cast<file_number_t>(std::stoul(filename.substr(prefix.size()))));
+            }
+        }
+        std::sort(log_numbers.begin(), log_numbers.end());
+
+        for(auto log_number : log_numbers) {
+            // 避免新文件与遗留的 WAL 编号冲突
+            if(static_cast<int32_t>(log_number) >= db_option_->next_file_number_.load(std::memory_order_acquire)) {
+                db_option_->next_file_number_.store(static_cast<int32_t>(log_number) + 1, std::memory_order_release);
+            }
 
             try {
-                file.seekg(0, std::ios::end);
-                auto file_size = file.tellg();
-                file.seekg(0, std::ios::beg);
-
-                // 读取 file number
-                char buffer[4];
-                file.read(buffer, 4);
-                db_option_->next_file_number_.store(CodingUtil::DecodeUint32(buffer), std::memory_order_release);
-
-                while(file.tellg() < file_size) {
-                    auto table = new Table("", Schema(), db_option_);
-                    table->ReadMetaData(file);
-                    tables_.emplace(table->GetTableName(), table);
+                LogReader reader(log_number);
+                std::string_view record;
+                std::string table_name;
+                Schema schema;
+                uint32_t shard_id;
+                if(!reader.ReadRecord(&record) || !TableShard::DecodeLogHeader(record, &table_name, &schema, &shard_id)) {
+                    LOG_WARN("skip invalid log file %u", log_number);
+                    DiskManager::RemoveFile(GET_LOG_NAME(log_number));
+                    continue;
+                }
+
+                auto iter = tables.find(table_name);
+                if(iter == tables.end()) {
+                    iter = tables.emplace(table_name, new Table(table_name, schema, db_option_)).first;
+                    manifest_->LogNewTable(table_name, schema, iter->second->GetShardCount());
                 }
+
+                LOG_INFO("recover log file %u for table %s", log_number, table_name.c_str());
+                iter->second->RecoverLogFile(shard_id, log_number, reader);
             } catch (Exception &e) {
-                file.close();
+                LOG_ERROR("recover log file %u failed : %s", log_number, e.what());
                 return -1;
             }
-            file.close();
         }
         return 0;
     }
@@ -90,54 +230,56 @@ namespace LindormContest {
         }
 
         std::unique_lock<std::mutex> lock(mutex_);
-        if(tables_.count(tableName) == 1) {
+        auto old_tables = std::atomic_load(&tables_);
+        if(old_tables->count(tableName) == 1) {
             return -1;
         }
 
-        if(tables_.find(tableName) != tables_.end()) {
+        auto table = new Table(tableName, schema, db_option_);
+        try {
+            manifest_->LogNewTable(tableName, schema, table->GetShardCount());
+        } catch (Exception &e) {
+            LOG_ERROR("write manifest_log failed : %s", e.what());
+            delete table;
             return -1;
         }
 
-        tables_.emplace(tableName, new Table(tableName, schema, db_option_));
+        auto tables = std::make_shared<TableMap>(*old_tables);
+        tables->emplace(tableName, table);
+        std::atomic_store(&tables_, std::shared_ptr<const TableMap>(std::move(tables)));
         return 0;
     }
 
     auto TSDBEngineImpl::shutdown() -> int {
         LOG_INFO("Shutting down");
 
+        auto tables = std::atomic_load(&tables_);
+
         // 通知关闭
-        for(auto &table : tables_) {
+        for(auto &table : *tables) {
             table.second->Shutdown();
         }
 
         // 等待后台任务退出
         db_option_->bg_task_->WaitForEmptyQueue();
 
-        // 写入元数据
+        // sstable 的变更已经写入 manifest_log, 只需要追加 latest index 文件的编号
+        // 没有并发写入的 record, manifest_log 过大时写入新的快照
         try {
-            std::ofstream file(db_directory_ + "/manifest_file", std::ofstream::trunc);
-            if(!file.is_open()) {
-                LOG_ERROR("manifest_file open failed");
-                return -1;
+            for(auto &table : *tables) {
+                table.second->LogLatestIndex();
             }
-
-            // 写入 file number
-            char buffer[4];
-            CodingUtil::EncodeValue(buffer, db_option_->next_file_number_.load(std::memory_order_acquire));
-            file.write(buffer, 4);
-
-            for(auto &table : tables_) {
-                table.second->WriteMetaData(file);
+            if(manifest_ != nullptr && manifest_->GetLogSize() > K_MANIFEST_LOG_COMPACTION_SIZE) {
+                WriteManifestSnapshot(*tables);
             }
-            file.flush();
-            file.close();
         } catch (Exception &e) {
-            LOG_ERROR("manifest_file write failed");
+            LOG_ERROR("manifest_log write failed : %s", e.what());
             return -1;
         }
 
-        for(auto &table : tables_) {
+        for(auto &table : *tables) {
             table.second->EraseSSTableFile();
+            table.second->EraseLogFile();
         }
 
         return 0;
@@ -148,15 +290,14 @@ namespace LindormContest {
             return -1;
         }
 
-        std::unique_lock<std::mutex> lock(mutex_);
-        auto table = tables_.find(writeRequest.tableName);
-        if(table == tables_.end()) {
+        auto table = GetTable(writeRequest.tableName);
+        if(table == nullptr) {
             return -1;
         }
         int result;
 
         try {
-            result = table->second->Upsert(writeRequest);
+            result = table->Upsert(writeRequest);
         } catch (Exception &e) {
             result = -1;
             LOG_ERROR("Upsert failed : %s", e.what());
@@ -169,17 +310,15 @@ namespace LindormContest {
             return -1;
         }
 
-        std::unique_lock<std::mutex> lock(mutex_);
-        auto table = tables_.find(pReadReq.tableName);
-        if(table == tables_.end()) {
+        auto table = GetTable(pReadReq.tableName);
+        if(table == nullptr) {
             return -1;
         }
-        lock.unlock();
 
         int result;
 
         try {
-            result = table->second->ExecuteLatestQuery(pReadReq, pReadRes);
+            result = table->ExecuteLatestQuery(pReadReq, pReadRes);
         } catch (Exception &e) {
             result = -1;
             LOG_ERROR("Failed to execute: %s", e.what());
@@ -194,18 +333,16 @@ namespace LindormContest {
             return -1;
         }
 
-        std::unique_lock<std::mutex> lock(mutex_);
-        auto table = tables_.find(trReadReq.tableName);
-        if(table == tables_.end()) {
+        auto table = GetTable(trReadReq.tableName);
+        if(table == nullptr) {
             LOG_INFO("executeTimeRangeQuery -1");
             return -1;
         }
-        lock.unlock();
 
         int result;
 
         try {
-            result = table->second->ExecuteTimeRangeQuery(trReadReq, trReadRes);
+            result = table->ExecuteTimeRangeQuery(trReadReq, trReadRes);
         } catch (Exception &e) {
             result = -1;
             LOG_ERROR("ExecuteTimeRangeQuery -1, %s", e.what());
@@ -214,11 +351,18 @@ namespace LindormContest {
         return result;
     }
 
+    auto TSDBEngineImpl::GetTable(const std::string &table_name) const -> Table* {
+        auto tables = std::atomic_load(&tables_);
+        auto iter = tables->find(table_name);
+        return iter == tables->end() ? nullptr : iter->second;
+    }
+
     TSDBEngineImpl::~TSDBEngineImpl() {
-        for(auto &table : tables_) {
+        for(auto &table : *tables_) {
             delete table.second;
         }
         db_option_->bg_task_->Shutdown();
+        delete db_option_->query_executor_;
 
         delete db_option_->block_cache_;
         delete db_option_->table_cache_;
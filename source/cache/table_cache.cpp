@@ -2,6 +2,7 @@
 
 #include <utility>
 #include "cache/cache.h"
+#include "db/db_options.h"
 
 namespace LindormContest {
 
@@ -13,13 +14,77 @@ static void IteratorCleanupTableCache(void *arg, void* value) {
     table_cache->Release(handle);
 }
 
-auto TableCache::NewTableIterator(const FileMetaDataPtr& file_meta_data) -> std::unique_ptr<Iterator> {
-    auto handle = FindTable(file_meta_data);
-    auto iter = handle->value_->NewIterator();
+auto TableCache::NewTableIterator(const FileMetaDataPtr& file_meta_data, const ColumnMask *column_mask) -> std::unique_ptr<Iterator> {
+    auto handle = FindTable(*file_meta_data);
+    auto iter = handle->value_->NewIterator(column_mask);
     iter->RegisterCleanup(IteratorCleanupTableCache, &this->cache_, handle);
     return iter;
 }
 
+auto TableCache::NewTableRangeIterator(const FileMetaDataPtr& file_meta_data, const InternalKey &lower, const InternalKey &upper,
+                                       const ColumnMask *column_mask) -> std::unique_ptr<Iterator> {
+    auto handle = FindTable(*file_meta_data);
+    auto iter = handle->value_->NewRangeIterator(lower, upper, column_mask);
+    iter->RegisterCleanup(IteratorCleanupTableCache, &this->cache_, handle);
+    return iter;
+}
+
+auto TableCache::MayContain(const FileMetaDataPtr& file_meta_data, const Vin &vin) -> bool {
+    auto handle = FindTable(*file_meta_data);
+    auto may_contain = handle->value_->MayContain(vin);
+    cache_.Release(handle);
+    return may_contain;
+}
+
+void TableCache::FilterVins(const FileMetaDataPtr& file_meta_data, const std::vector<Vin> &vins, std::vector<Vin> *result) {
+    auto handle = FindTable(*file_meta_data);
+    for(auto &vin : vins) {
+        if(handle->value_->MayContain(vin)) {
+            result->push_back(vin);
+        }
+    }
+    cache_.Release(handle);
+}
+
+void TableCache::GetBlockKeys(const FileMetaDataPtr& file_meta_data, std::vector<InternalKey> *keys) {
+    auto handle = FindTable(*file_meta_data);
+    handle->value_->GetBlockKeys(keys);
+    cache_.Release(handle);
+}
+
+void TableCache::PrefetchBlocks(const std::vector<std::pair<FileMetaDataPtr, std::vector<Vin>>> &files,
+                                const ColumnMask *column_mask) {
+    std::vector<CacheHandle<SSTable> *> handles;
+    std::vector<BlockPrefetch> prefetches;
+    for(auto &file : files) {
+        auto handle = FindTable(*file.first);
+        handles.push_back(handle);
+        handle->value_->CollectPrefetch(file.second, column_mask, &prefetches);
+    }
+
+    std::vector<ReadRequest> requests;
+    requests.reserve(prefetches.size());
+    for(auto &prefetch : prefetches) {
+        requests.push_back(prefetch.request_);
+    }
+
+    try {
+        DiskManager::ReadBlocks(requests);
+        for(auto &prefetch : prefetches) {
+            prefetch.sstable_->InstallPrefetch(prefetch);
+        }
+    } catch(...) {
+        for(auto handle : handles) {
+            cache_.Release(handle);
+        }
+        throw;
+    }
+
+    for(auto handle : handles) {
+        cache_.Release(handle);
+    }
+}
+
 void TableCache::AddSSTable(std::unique_ptr<SSTable> sstable) {
     std::scoped_lock<std::mutex> lock(mutex_);
     auto file_number = sstable->GetFileNumber();
@@ -27,17 +92,30 @@ void TableCache::AddSSTable(std::unique_ptr<SSTable> sstable) {
     cache_.Release(handle);
 }
 
-auto TableCache::FindTable(const FileMetaDataPtr& file_meta_data) -> CacheHandle<SSTable> * {
+void TableCache::EvictSSTable(const FileMetaData &file_meta_data) {
+    // 需要 index block 确定 block 的位置, 不在 TableCache 中时不为此重新打开即将删除的文件
+    // 残留的 block 的 file number 不会被复用, 由 block cache 的 LRU 淘汰
+    auto handle = cache_.Lookup(file_meta_data.file_number_);
+    if(handle == nullptr) {
+        return;
+    }
+    handle->value_->EvictBlocks();
+    cache_.Release(handle);
+    cache_.Erase(file_meta_data.file_number_);
+}
+
+auto TableCache::FindTable(const FileMetaData &file_meta_data) -> CacheHandle<SSTable> * {
     // 加锁保护同时调用 FindTable 查询同一个不在缓存的 SSTable
     std::scoped_lock<std::mutex> lock(mutex_);
 
-    auto handle = cache_.Lookup(file_meta_data->file_number_);
+    auto handle = cache_.Lookup(file_meta_data.file_number_);
     if(handle != nullptr) {
         return handle;
     }
 
-    auto sstable = new SSTable(file_meta_data->file_number_, file_meta_data->file_size_, block_cache_);
-    handle = cache_.Insert(file_meta_data->file_number_, std::unique_ptr<SSTable>(sstable), 1);
+    auto sstable = new SSTable(file_meta_data.file_number_, file_meta_data.file_size_, options_->block_cache_,
+                               options_->use_mmap_reads_, options_->use_direct_io_);
+    handle = cache_.Insert(file_meta_data.file_number_, std::unique_ptr<SSTable>(sstable), 1);
     return handle;
 }
 
@@ -0,0 +1,612 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "snappy/snappy.h"
+#include "codec/column_codec.h"
+#include "sstable/row_group.h"
+#include "util/coding.h"
+#include "db/format.h"
+
+namespace LindormContest {
+
+namespace {
+
+// 按位写入, 高位在前
+class BitWriter {
+public:
+    explicit BitWriter(std::string *dst) : dst_(dst) {}
+
+    // 写入 value 的低 n 位, 1 <= n <= 64
+    void Write(uint64_t value, uint32_t n) {
+        while(n > 0) {
+            uint32_t take = std::min(64 - bits_, n);
+            uint64_t part = (value >> (n - take)) & Mask(take);
+            acc_ = take == 64 ? part : (acc_ << take) | part;
+            bits_ += take;
+            n -= take;
+            if(bits_ == 64) {
+                FlushBytes(8);
+            }
+        }
+    }
+
+    void Finish() {
+        if(bits_ > 0) {
+            auto bytes = (bits_ + 7) / 8;
+            acc_ <<= bytes * 8 - bits_;
+            bits_ = bytes * 8;
+            FlushBytes(bytes);
+        }
+    }
+
+    static auto Mask(uint32_t n) -> uint64_t { return n == 64 ? ~0ULL : (1ULL << n) - 1; }
+
+private:
+    void FlushBytes(uint32_t bytes) {
+        for(uint32_t i = bytes; i > 0; i--) {
+            dst_->push_back(static_cast<char>(acc_ >> ((i - 1) * 8)));
+        }
+        acc_ = 0;
+        bits_ = 0;
+    }
+
+    std::string *dst_;
+    uint64_t acc_{0};
+    uint32_t bits_{0};
+};
+
+class BitReader {
+public:
+    BitReader(const char *p, const char *limit) : p_(p), limit_(limit) {}
+
+    // 读取 n 位, 1 <= n <= 64, 数据不足时返回 false
+    auto Read(uint32_t n, uint64_t *value) -> bool {
+        if(n > 32) {
+            uint64_t high;
+            uint64_t low;
+            if(!Read(n - 32, &high) || !Read(32, &low)) {
+                return false;
+            }
+            *value = (high << 32) | low;
+            return true;
+        }
+
+        Refill();
+        if(bits_ < n) {
+            return false;
+        }
+        *value = buf_ >> (64 - n);
+        buf_ = n == 64 ? 0 : buf_ << n;
+        bits_ -= n;
+        return true;
+    }
+
+private:
+    // buf_ 中的数据左对齐
+    void Refill() {
+        while(bits_ <= 56 && p_ < limit_) {
+            buf_ |= static_cast<uint64_t>(static_cast<uint8_t>(*p_)) << (56 - bits_);
+            bits_ += 8;
+            p_++;
+        }
+    }
+
+    const char *p_;
+    const char *limit_;
+    uint64_t buf_{0};
+    uint32_t bits_{0};
+};
+
+auto GetRowCount(const std::string &chunk) -> uint32_t {
+    return CodingUtil::DecodeUint32(chunk.data() + chunk.size() - CodingUtil::LENGTH_SIZE);
+}
+
+void AppendRowCount(std::string *chunk, uint32_t num_rows) {
+    char buffer[CodingUtil::LENGTH_SIZE];
+    CodingUtil::PutUint32(buffer, num_rows);
+    chunk->append(buffer, CodingUtil::LENGTH_SIZE);
+}
+
+// 取 chunk 的前 rows 行作为采样
+auto SampleChunk(ColumnType type, const std::string &chunk, uint32_t rows) -> std::string {
+    const char *p = chunk.data();
+    for(uint32_t i = 0; i < rows; i++) {
+        p += type == COLUMN_TYPE_UNINITIALIZED ? INTERNAL_KEY_SIZE : ColumnValueSize(type, p);
+    }
+    std::string sample(chunk.data(), p);
+    AppendRowCount(&sample, rows);
+    return sample;
+}
+
+void EncodeSnappy(const std::string &chunk, std::string *dst) {
+    std::string compressed;
+    snappy::Compress(chunk.data(), chunk.size(), &compressed);
+    dst->append(compressed);
+}
+
+auto DecodeSnappy(const char *p, const char *limit, char *out, size_t length) -> bool {
+    size_t uncompressed_length;
+    return snappy::GetUncompressedLength(p, limit - p, &uncompressed_length) && uncompressed_length == length
+           && snappy::RawUncompress(p, limit - p, out);
+}
+
+void EncodeDeltaVarint(const std::string &chunk, uint32_t num_rows, std::string *dst) {
+    int64_t prev = 0;
+    const char *p = chunk.data();
+    for(uint32_t i = 0; i < num_rows; i++, p += 4) {
+        int64_t value = CodingUtil::DecodeInteger(p);
+        CodingUtil::PutVarint64(dst, CodingUtil::ZigZagEncode(value - prev));
+        prev = value;
+    }
+}
+
+auto DecodeDeltaVarint(const char *p, const char *limit, uint32_t num_rows, char *out, char *out_limit) -> bool {
+    if(out_limit - out != static_cast<ptrdiff_t>(num_rows) * 4) {
+        return false;
+    }
+    int64_t prev = 0;
+    uint64_t delta;
+    for(uint32_t i = 0; i < num_rows; i++, out += 4) {
+        if(!CodingUtil::GetVarint64(&p, limit, &delta)) {
+            return false;
+        }
+        prev += CodingUtil::ZigZagDecode(delta);
+        CodingUtil::EncodeValue(out, static_cast<int32_t>(prev));
+    }
+    return true;
+}
+
+void EncodeGorilla(const std::string &chunk, uint32_t num_rows, std::string *dst) {
+    BitWriter writer(dst);
+    uint64_t prev = 0;
+    uint32_t prev_leading = 65;
+    uint32_t prev_trailing = 0;
+    const char *p = chunk.data();
+    for(uint32_t i = 0; i < num_rows; i++, p += 8) {
+        uint64_t value = CodingUtil::DecodeFixed64(p);
+        if(i == 0) {
+            writer.Write(value, 64);
+            prev = value;
+            continue;
+        }
+
+        uint64_t x = value ^ prev;
+        prev = value;
+        if(x == 0) {
+            writer.Write(0, 1);
+            continue;
+        }
+
+        writer.Write(1, 1);
+        uint32_t leading = std::min(static_cast<uint32_t>(__builtin_clzll(x)), 31U);
+        uint32_t trailing = __builtin_ctzll(x);
+        if(prev_leading != 65 && leading >= prev_leading && trailing >= prev_trailing) {
+            // 有效位落在上一个窗口内, 复用窗口
+            writer.Write(0, 1);
+            writer.Write(x >> prev_trailing, 64 - prev_leading - prev_trailing);
+        } else {
+            uint32_t meaningful = 64 - leading - trailing;
+            writer.Write(1, 1);
+            writer.Write(leading, 5);
+            writer.Write(meaningful - 1, 6);
+            writer.Write(x >> trailing, meaningful);
+            prev_leading = leading;
+            prev_trailing = trailing;
+        }
+    }
+    writer.Finish();
+}
+
+auto DecodeGorilla(const char *p, const char *limit, uint32_t num_rows, char *out, char *out_limit) -> bool {
+    if(out_limit - out != static_cast<ptrdiff_t>(num_rows) * 8) {
+        return false;
+    }
+    BitReader reader(p, limit);
+    uint64_t prev = 0;
+    uint32_t leading = 0;
+    uint32_t trailing = 0;
+    uint64_t bits;
+    for(uint32_t i = 0; i < num_rows; i++, out += 8) {
+        if(i == 0) {
+            if(!reader.Read(64, &prev)) {
+                return false;
+            }
+        } else {
+            if(!reader.Read(1, &bits)) {
+                return false;
+            }
+            if(bits == 1) {
+                if(!reader.Read(1, &bits)) {
+                    return false;
+                }
+                if(bits == 1) {
+                    uint64_t l;
+                    uint64_t m;
+                    if(!reader.Read(5, &l) || !reader.Read(6, &m)) {
+                        return false;
+                    }
+                    leading = l;
+                    trailing = 64 - leading - (m + 1);
+                }
+                if(!reader.Read(64 - leading - trailing, &bits)) {
+                    return false;
+                }
+                prev ^= bits << trailing;
+            }
+        }
+        CodingUtil::EncodeValue(out, prev);
+    }
+    return true;
+}
+
+void EncodeDictionaryRLE(const std::string &chunk, uint32_t num_rows, std::string *dst) {
+    std::vector<std::string_view> dictionary;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<std::pair<uint32_t, uint32_t>> runs;
+
+    const char *p = chunk.data();
+    for(uint32_t i = 0; i < num_rows; i++) {
+        auto size = CodingUtil::DecodeUint32(p);
+        std::string_view value(p + 4, size);
+        p += 4 + size;
+
+        auto iter = ids.find(value);
+        if(iter == ids.end()) {
+            iter = ids.emplace(value, dictionary.size()).first;
+            dictionary.push_back(value);
+        }
+        if(!runs.empty() && runs.back().first == iter->second) {
+            runs.back().second++;
+        } else {
+            runs.emplace_back(iter->second, 1);
+        }
+    }
+
+    CodingUtil::PutVarint64(dst, dictionary.size());
+    for(auto &value : dictionary) {
+        CodingUtil::PutVarint64(dst, value.size());
+        dst->append(value);
+    }
+    CodingUtil::PutVarint64(dst, runs.size());
+    for(auto &run : runs) {
+        CodingUtil::PutVarint64(dst, run.first);
+        CodingUtil::PutVarint64(dst, run.second);
+    }
+}
+
+// 读取字典, 之后 p 指向游程部分
+auto DecodeDictionary(const char **p, const char *limit, std::vector<std::string_view> *dictionary) -> bool {
+    uint64_t dictionary_size;
+    if(!CodingUtil::GetVarint64(p, limit, &dictionary_size) || dictionary_size > static_cast<uint64_t>(limit - *p)) {
+        return false;
+    }
+    dictionary->reserve(dictionary_size);
+    for(uint64_t i = 0; i < dictionary_size; i++) {
+        uint64_t size;
+        if(!CodingUtil::GetVarint64(p, limit, &size) || size > static_cast<uint64_t>(limit - *p)) {
+            return false;
+        }
+        dictionary->emplace_back(*p, size);
+        *p += size;
+    }
+    return true;
+}
+
+// 解码前遍历一次游程, 计算解码后的长度
+auto DictionaryRLELength(const char *p, const char *limit, uint32_t num_rows, size_t *length) -> bool {
+    std::vector<std::string_view> dictionary;
+    uint64_t run_count;
+    if(!DecodeDictionary(&p, limit, &dictionary) || !CodingUtil::GetVarint64(&p, limit, &run_count)) {
+        return false;
+    }
+    uint64_t rows = 0;
+    *length = 0;
+    for(uint64_t i = 0; i < run_count; i++) {
+        uint64_t id;
+        uint64_t run_length;
+        if(!CodingUtil::GetVarint64(&p, limit, &id) || !CodingUtil::GetVarint64(&p, limit, &run_length)
+           || id >= dictionary.size() || run_length > num_rows - rows) {
+            return false;
+        }
+        *length += (CodingUtil::LENGTH_SIZE + dictionary[id].size()) * run_length;
+        rows += run_length;
+    }
+    return rows == num_rows;
+}
+
+auto DecodeDictionaryRLE(const char *p, const char *limit, uint32_t num_rows, char *out, char *out_limit) -> bool {
+    std::vector<std::string_view> dictionary;
+    uint64_t run_count;
+    if(!DecodeDictionary(&p, limit, &dictionary) || !CodingUtil::GetVarint64(&p, limit, &run_count)) {
+        return false;
+    }
+    uint64_t rows = 0;
+    for(uint64_t i = 0; i < run_count; i++) {
+        uint64_t id;
+        uint64_t length;
+        if(!CodingUtil::GetVarint64(&p, limit, &id) || !CodingUtil::GetVarint64(&p, limit, &length)
+           || id >= dictionary.size() || length > num_rows - rows) {
+            return false;
+        }
+        auto &value = dictionary[id];
+        if(static_cast<uint64_t>(out_limit - out) < (CodingUtil::LENGTH_SIZE + value.size()) * length) {
+            return false;
+        }
+        for(uint64_t j = 0; j < length; j++) {
+            CodingUtil::PutUint32(out, value.size());
+            std::memcpy(out + CodingUtil::LENGTH_SIZE, value.data(), value.size());
+            out += CodingUtil::LENGTH_SIZE + value.size();
+        }
+        rows += length;
+    }
+    return rows == num_rows && out == out_limit;
+}
+
+void EncodeKeyDelta(const std::string &chunk, uint32_t num_rows, std::string *dst) {
+    // vin 游程编码
+    std::vector<std::pair<const char *, uint32_t>> runs;
+    const char *p = chunk.data();
+    for(uint32_t i = 0; i < num_rows; i++, p += INTERNAL_KEY_SIZE) {
+        if(!runs.empty() && std::memcmp(runs.back().first, p, VIN_LENGTH) == 0) {
+            runs.back().second++;
+        } else {
+            runs.emplace_back(p, 1);
+        }
+    }
+    CodingUtil::PutVarint64(dst, runs.size());
+    for(auto &run : runs) {
+        dst->append(run.first, VIN_LENGTH);
+        CodingUtil::PutVarint64(dst, run.second);
+    }
+
+    // timestamp delta-of-delta, 使用无符号数运算避免溢出
+    uint64_t prev = 0;
+    uint64_t prev_delta = 0;
+    p = chunk.data() + VIN_LENGTH;
+    for(uint32_t i = 0; i < num_rows; i++, p += INTERNAL_KEY_SIZE) {
+        auto timestamp = static_cast<uint64_t>(CodingUtil::DecodeInt64(p));
+        uint64_t delta = timestamp - prev;
+        CodingUtil::PutVarint64(dst, CodingUtil::ZigZagEncode(static_cast<int64_t>(delta - prev_delta)));
+        prev = timestamp;
+        prev_delta = delta;
+    }
+}
+
+auto DecodeKeyDelta(const char *p, const char *limit, uint32_t num_rows, char *out, char *out_limit) -> bool {
+    if(out_limit - out != static_cast<ptrdiff_t>(num_rows) * INTERNAL_KEY_SIZE) {
+        return false;
+    }
+    char *chunk = out;
+
+    uint64_t run_count;
+    if(!CodingUtil::GetVarint64(&p, limit, &run_count)) {
+        return false;
+    }
+    uint64_t rows = 0;
+    for(uint64_t i = 0; i < run_count; i++) {
+        const char *vin = p;
+        p += VIN_LENGTH;
+        uint64_t length;
+        if(p > limit || !CodingUtil::GetVarint64(&p, limit, &length) || rows + length > num_rows) {
+            return false;
+        }
+        for(uint64_t j = 0; j < length; j++, out += INTERNAL_KEY_SIZE) {
+            std::memcpy(out, vin, VIN_LENGTH);
+        }
+        rows += length;
+    }
+    if(rows != num_rows) {
+        return false;
+    }
+
+    uint64_t prev = 0;
+    uint64_t prev_delta = 0;
+    uint64_t dod;
+    out = chunk + VIN_LENGTH;
+    for(uint32_t i = 0; i < num_rows; i++, out += INTERNAL_KEY_SIZE) {
+        if(!CodingUtil::GetVarint64(&p, limit, &dod)) {
+            return false;
+        }
+        prev_delta += static_cast<uint64_t>(CodingUtil::ZigZagDecode(dod));
+        prev += prev_delta;
+        CodingUtil::PutInt64(out, static_cast<int64_t>(prev));
+    }
+    return true;
+}
+
+// type 为 COLUMN_TYPE_UNINITIALIZED 时表示 key chunk
+auto SpecializedCodec(ColumnType type) -> CodecType {
+    switch(type) {
+        case COLUMN_TYPE_INTEGER:
+            return CodecType::DELTA_VARINT;
+        case COLUMN_TYPE_DOUBLE_FLOAT:
+            return CodecType::GORILLA;
+        case COLUMN_TYPE_STRING:
+            return CodecType::DICTIONARY_RLE;
+        default:
+            return CodecType::KEY_DELTA;
+    }
+}
+
+void Encode(CodecType codec, const std::string &chunk, std::string *dst) {
+    dst->push_back(static_cast<char>(codec));
+    if(codec == CodecType::SNAPPY) {
+        EncodeSnappy(chunk, dst);
+        return;
+    }
+
+    auto num_rows = GetRowCount(chunk);
+    CodingUtil::PutVarint64(dst, num_rows);
+    switch(codec) {
+        case CodecType::DELTA_VARINT:
+            EncodeDeltaVarint(chunk, num_rows, dst);
+            break;
+        case CodecType::GORILLA:
+            EncodeGorilla(chunk, num_rows, dst);
+            break;
+        case CodecType::DICTIONARY_RLE:
+            EncodeDictionaryRLE(chunk, num_rows, dst);
+            break;
+        default:
+            EncodeKeyDelta(chunk, num_rows, dst);
+            break;
+    }
+}
+
+// 读取专用编码的行数, 之后 p 指向 payload
+// 除字典编码外每行至少占用 1 位, 行数超过 payload 的位数时数据损坏, 避免按损坏的行数分配内存
+auto DecodeRowCount(ColumnType type, CodecType codec, const char **p, const char *limit, uint32_t *num_rows) -> bool {
+    uint64_t rows;
+    if(codec != SpecializedCodec(type) || !CodingUtil::GetVarint64(p, limit, &rows) || rows > UINT32_MAX
+       || (codec != CodecType::DICTIONARY_RLE && rows > static_cast<uint64_t>(limit - *p) * 8)) {
+        return false;
+    }
+    *num_rows = static_cast<uint32_t>(rows);
+    return true;
+}
+
+auto DecodedLength(ColumnType type, const char *data, size_t size, size_t *length) -> bool {
+    if(size == 0) {
+        return false;
+    }
+    auto codec = static_cast<CodecType>(data[0]);
+    const char *p = data + 1;
+    const char *limit = data + size;
+    if(codec == CodecType::SNAPPY) {
+        return snappy::GetUncompressedLength(p, limit - p, length);
+    }
+
+    uint32_t num_rows;
+    if(!DecodeRowCount(type, codec, &p, limit, &num_rows)) {
+        return false;
+    }
+    switch(codec) {
+        case CodecType::DELTA_VARINT:
+            *length = static_cast<size_t>(num_rows) * 4;
+            break;
+        case CodecType::GORILLA:
+            *length = static_cast<size_t>(num_rows) * 8;
+            break;
+        case CodecType::DICTIONARY_RLE:
+            if(!DictionaryRLELength(p, limit, num_rows, length)) {
+                return false;
+            }
+            break;
+        default:
+            *length = static_cast<size_t>(num_rows) * INTERNAL_KEY_SIZE;
+            break;
+    }
+    *length += CodingUtil::LENGTH_SIZE;
+    return true;
+}
+
+auto Decode(ColumnType type, const char *data, size_t size, char *chunk, size_t length) -> bool {
+    if(size == 0) {
+        return false;
+    }
+    auto codec = static_cast<CodecType>(data[0]);
+    const char *p = data + 1;
+    const char *limit = data + size;
+    if(codec == CodecType::SNAPPY) {
+        return DecodeSnappy(p, limit, chunk, length);
+    }
+
+    uint32_t num_rows;
+    if(length < CodingUtil::LENGTH_SIZE || !DecodeRowCount(type, codec, &p, limit, &num_rows)) {
+        return false;
+    }
+
+    // 行数写在 chunk 末尾
+    char *out_limit = chunk + length - CodingUtil::LENGTH_SIZE;
+    bool ok;
+    switch(codec) {
+        case CodecType::DELTA_VARINT:
+            ok = DecodeDeltaVarint(p, limit, num_rows, chunk, out_limit);
+            break;
+        case CodecType::GORILLA:
+            ok = DecodeGorilla(p, limit, num_rows, chunk, out_limit);
+            break;
+        case CodecType::DICTIONARY_RLE:
+            ok = DecodeDictionaryRLE(p, limit, num_rows, chunk, out_limit);
+            break;
+        default:
+            ok = DecodeKeyDelta(p, limit, num_rows, chunk, out_limit);
+            break;
+    }
+    CodingUtil::PutUint32(out_limit, num_rows);
+    return ok;
+}
+
+auto DecodeToString(ColumnType type, const char *data, size_t size, std::string *chunk) -> bool {
+    size_t length;
+    if(!DecodedLength(type, data, size, &length)) {
+        return false;
+    }
+    chunk->resize(length);
+    return Decode(type, data, size, chunk->data(), length);
+}
+
+auto Choose(ColumnType type, const std::string &chunk) -> CodecType {
+    auto num_rows = GetRowCount(chunk);
+    if(num_rows == 0) {
+        return CodecType::SNAPPY;
+    }
+
+    auto sample = SampleChunk(type, chunk, std::min(num_rows, ColumnCodec::K_SAMPLE_ROWS));
+    std::string snappy_result;
+    std::string specialized_result;
+    Encode(CodecType::SNAPPY, sample, &snappy_result);
+    Encode(SpecializedCodec(type), sample, &specialized_result);
+    return specialized_result.size() < snappy_result.size() ? SpecializedCodec(type) : CodecType::SNAPPY;
+}
+
+}  // namespace
+
+void ColumnCodec::EncodeColumnChunk(ColumnType type, const std::string &chunk, std::string *dst) {
+    Encode(Choose(type, chunk), chunk, dst);
+}
+
+auto ColumnCodec::DecodeColumnChunk(ColumnType type, const char *data, size_t size, std::string *chunk) -> bool {
+    return DecodeToString(type, data, size, chunk);
+}
+
+auto ColumnCodec::GetColumnChunkLength(ColumnType type, const char *data, size_t size, size_t *length) -> bool {
+    return DecodedLength(type, data, size, length);
+}
+
+auto ColumnCodec::DecodeColumnChunk(ColumnType type, const char *data, size_t size, char *chunk, size_t length) -> bool {
+    return Decode(type, data, size, chunk, length);
+}
+
+void ColumnCodec::EncodeKeyChunk(const std::string &chunk, std::string *dst) {
+    Encode(Choose(COLUMN_TYPE_UNINITIALIZED, chunk), chunk, dst);
+}
+
+auto ColumnCodec::DecodeKeyChunk(const char *data, size_t size, std::string *chunk) -> bool {
+    return DecodeToString(COLUMN_TYPE_UNINITIALIZED, data, size, chunk);
+}
+
+auto ColumnCodec::GetKeyChunkLength(const char *data, size_t size, size_t *length) -> bool {
+    return DecodedLength(COLUMN_TYPE_UNINITIALIZED, data, size, length);
+}
+
+auto ColumnCodec::DecodeKeyChunk(const char *data, size_t size, char *chunk, size_t length) -> bool {
+    return Decode(COLUMN_TYPE_UNINITIALIZED, data, size, chunk, length);
+}
+
+auto ColumnCodec::EncodeColumnChunk(ColumnType type, CodecType codec, const std::string &chunk, std::string *dst) -> bool {
+    if(codec != CodecType::SNAPPY && codec != SpecializedCodec(type)) {
+        return false;
+    }
+    Encode(codec, chunk, dst);
+    return true;
+}
+
+auto ColumnCodec::ChooseCodec(ColumnType type, const std::string &chunk) -> CodecType {
+    return Choose(type, chunk);
+}
+
+}  // namespace LindormContest
@@ -1,20 +1,17 @@
-#include "queue"
 #include "common/merger_iterator.h"
 
 #include <utility>
 
 namespace LindormContest {
 
+// 有效的 children 组成以当前 key 为序的最小堆, 堆顶即当前位置
+// 每个 child 的 key 在移动后读取一次, Next 只需要 O(log k) 次比较
 class MergingIterator : public Iterator {
-private:
-    struct IteratorCompare {
-        auto operator()(Iterator *lhs, Iterator *rhs) const -> bool {
-            return lhs->GetKey() < rhs->GetKey();
-        }
-    };
-
 public:
-    explicit MergingIterator(std::vector<std::unique_ptr<Iterator>> children) : children_(std::move(children)) {}
+    explicit MergingIterator(std::vector<std::unique_ptr<Iterator>> children)
+        : children_(std::move(children)), keys_(children_.size()) {
+        heap_.reserve(children_.size());
+    }
 
     ~MergingIterator() override = default;
 
@@ -22,23 +19,41 @@ public:
 
     void Seek(const InternalKey &key) override;
 
-    auto GetKey() -> InternalKey override {
-        return children_[idx_]->GetKey();
+    auto GetKey() -> const InternalKey & override {
+        return *keys_[heap_[0]];
     }
 
-    auto GetValue() -> std::string override {
-        return children_[idx_]->GetValue();
+    auto GetValue() -> std::string_view override {
+        return children_[heap_[0]]->GetValue();
     }
 
-    auto Valid() -> bool override;
+    auto Valid() -> bool override {
+        return !heap_.empty();
+    }
 
     auto Next() -> void override;
 
 private:
+    // key 相同时靠前的 child 更小
+    auto Less(size_t a, size_t b) const -> bool {
+        if(*keys_[a] == *keys_[b]) {
+            return a < b;
+        }
+        return *keys_[a] < *keys_[b];
+    }
+
+    // 所有 children 定位后重新建堆
     void InitHeap();
 
-    size_t idx_{0};
+    void SiftDown(size_t pos);
+
     std::vector<std::unique_ptr<Iterator>> children_;
+
+    // children_[i] 当前的 key, 在 children_[i] 移动前有效
+    std::vector<const InternalKey *> keys_;
+
+    // 有效的 child 编号
+    std::vector<size_t> heap_;
 };
 
 auto MergingIterator::SeekToFirst() -> void {
@@ -55,29 +70,50 @@ void MergingIterator::Seek(const InternalKey &key) {
     InitHeap();
 }
 
-auto MergingIterator::Valid() -> bool {
-    return children_[idx_]->Valid();
-}
-
 auto MergingIterator::Next() -> void {
-    children_[idx_]->Next();
-    InitHeap();
+    auto idx = heap_[0];
+    children_[idx]->Next();
+    if(children_[idx]->Valid()) {
+        keys_[idx] = &children_[idx]->GetKey();
+    } else {
+        heap_[0] = heap_.back();
+        heap_.pop_back();
+    }
+    if(!heap_.empty()) {
+        SiftDown(0);
+    }
 }
 
 void MergingIterator::InitHeap() {
-    bool vis = false;
+    heap_.clear();
     for(size_t i = 0; i < children_.size(); i++) {
         if(children_[i]->Valid()) {
-            if(!vis) {
-                idx_ = i;
-                vis = true;
-            } else {
-                if(children_[i]->GetKey() < children_[idx_]->GetKey()) {
-                    idx_ = i;
-                }
-            }
+            keys_[i] = &children_[i]->GetKey();
+            heap_.push_back(i);
+        }
+    }
+    for(size_t pos = heap_.size() / 2; pos > 0; pos--) {
+        SiftDown(pos - 1);
+    }
+}
+
+void MergingIterator::SiftDown(size_t pos) {
+    auto idx = heap_[pos];
+    while(true) {
+        auto child = pos * 2 + 1;
+        if(child >= heap_.size()) {
+            break;
+        }
+        if(child + 1 < heap_.size() && Less(heap_[child + 1], heap_[child])) {
+            child++;
+        }
+        if(!Less(heap_[child], idx)) {
+            break;
         }
+        heap_[pos] = heap_[child];
+        pos = child;
     }
+    heap_[pos] = idx;
 }
 
 auto NewMergingIterator(std::vector<std::unique_ptr<Iterator>> children) -> std::unique_ptr<Iterator> {
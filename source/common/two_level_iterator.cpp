@@ -4,29 +4,34 @@ namespace LindormContest {
 
 class TwoLevelIterator : public Iterator {
 public:
+    // 创建时不读取 data block, 第一次使用前没有调用 Seek 时才定位到第一个元素
     explicit TwoLevelIterator(std::unique_ptr<Iterator> index_iter, BlockFunction block_function, void *arg) : index_iter_(std::move(index_iter)),
-    block_function_(block_function), arg_(arg) {
-        index_iter_->SeekToFirst();
-        InitDataBlock();
-        if(data_iter_ != nullptr) {
-            data_iter_->SeekToFirst();
-        }
-    }
+    block_function_(block_function), arg_(arg) {}
 
     auto SeekToFirst() -> void override;
 
     void Seek(const InternalKey &key) override;
 
-    auto GetKey() -> InternalKey override;
+    auto GetKey() -> const InternalKey & override;
 
-    auto GetValue() -> std::string override;
+    auto GetValue() -> std::string_view override;
 
     auto Valid() -> bool override;
 
     auto Next() -> void override;
+
+    auto NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t override;
 private:
     void InitDataBlock();
 
+    void MaybeSeekToFirst() {
+        if(!positioned_) {
+            SeekToFirst();
+        }
+    }
+
+    bool positioned_{false};
+
     std::unique_ptr<Iterator> index_iter_;
     std::unique_ptr<Iterator> data_iter_{};
 
@@ -35,6 +40,7 @@ private:
 };
 
 void TwoLevelIterator::SeekToFirst() {
+    positioned_ = true;
     index_iter_->SeekToFirst();
     InitDataBlock();
     if(data_iter_ != nullptr) {
@@ -43,6 +49,14 @@ void TwoLevelIterator::SeekToFirst() {
 }
 
 void TwoLevelIterator::Seek(const InternalKey &key) {
+    // index key 为 block 的最后一个 key, key 位于当前 block 内时不需要重新查找 index 和读取 block
+    if(positioned_ && data_iter_ != nullptr && data_iter_->Valid() && !(key < data_iter_->GetKey())
+       && !(index_iter_->GetKey() < key)) {
+        data_iter_->Seek(key);
+        return;
+    }
+
+    positioned_ = true;
     index_iter_->Seek(key);
     InitDataBlock();
     if(data_iter_ != nullptr) {
@@ -50,21 +64,25 @@ void TwoLevelIterator::Seek(const InternalKey &key) {
     }
 }
 
-auto TwoLevelIterator::GetKey() -> InternalKey {
+auto TwoLevelIterator::GetKey() -> const InternalKey & {
+    MaybeSeekToFirst();
     ASSERT(data_iter_ != nullptr && data_iter_->Valid(), "data_iter_ is nullptr or invalid");
     return data_iter_->GetKey();
 }
 
-auto TwoLevelIterator::GetValue() -> std::string {
+auto TwoLevelIterator::GetValue() -> std::string_view {
+    MaybeSeekToFirst();
     ASSERT(data_iter_ != nullptr && data_iter_->Valid(), "data_iter_ is nullptr or invalid");
     return data_iter_->GetValue();
 }
 
 auto TwoLevelIterator::Valid() -> bool {
+    MaybeSeekToFirst();
     return data_iter_ != nullptr && data_iter_->Valid();
 }
 
 void TwoLevelIterator::Next() {
+    MaybeSeekToFirst();
     ASSERT(data_iter_ != nullptr, "data_iter_ is nullptr");
     data_iter_->Next();
     if(!data_iter_->Valid()) {
@@ -78,9 +96,31 @@ void TwoLevelIterator::Next() {
     }
 }
 
+auto TwoLevelIterator::NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t {
+    MaybeSeekToFirst();
+    size_t count = 0;
+    while(count < n && data_iter_ != nullptr) {
+        count += data_iter_->NextBatch(n - count, limit, batch);
+        // 达到 n 或遇到大于 limit 的 key
+        if(data_iter_->Valid()) {
+            break;
+        }
+
+        data_iter_.reset();
+        index_iter_->Next();
+        InitDataBlock();
+        if(data_iter_ != nullptr) {
+            data_iter_->SeekToFirst();
+        }
+    }
+    return count;
+}
+
 void TwoLevelIterator::InitDataBlock() {
     if(index_iter_->Valid()) {
         data_iter_ = block_function_(arg_, index_iter_->GetValue());
+    } else {
+        data_iter_.reset();
     }
 }
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <thread>
 #include <atomic>
 #include "db/background.h"
@@ -11,21 +12,78 @@ void BackgroundTask::Schedule(void (*function)(void *), void *arg) {
 
     if(!started_background_thread_) {
         started_background_thread_ = true;
-        std::thread(&BackgroundTask::BackgroundThread, this).detach();
+        alive_thread_count_ = thread_count_;
+        for(int i = 0; i < thread_count_; i++) {
+            std::thread(&BackgroundTask::BackgroundThread, this).detach();
+        }
     }
 
-    if(background_work_queue_.empty()) {
-        cv_.notify_one();
+    background_work_queue_.emplace(function, arg);
+    cv_.notify_all();
+}
+
+void BackgroundTask::Run(size_t count, const std::function<void(size_t)> &function) {
+    if(count == 0) {
+        return;
+    }
+    if(count == 1 || thread_count_ == 0) {
+        for(size_t i = 0; i < count; i++) {
+            function(i);
+        }
+        return;
     }
 
-    background_work_queue_.emplace(function, arg);
+    auto batch = std::make_shared<Batch>();
+    batch->function_ = &function;
+    batch->count_ = count;
+
+    // 调用线程执行一个子任务, 其余的最多交给 count - 1 个后台线程
+    auto helpers = std::min(count - 1, static_cast<size_t>(thread_count_));
+    for(size_t i = 0; i < helpers; i++) {
+        Schedule(&BackgroundTask::BatchWork, new std::shared_ptr<Batch>(batch));
+    }
+
+    Work(batch.get());
+
+    std::unique_lock<std::mutex> lock(batch->mutex_);
+    batch->cv_.wait(lock, [&batch] { return batch->done_ == batch->count_; });
+    if(batch->error_ != nullptr) {
+        std::rethrow_exception(batch->error_);
+    }
+}
+
+void BackgroundTask::Work(Batch *batch) {
+    std::unique_lock<std::mutex> lock(batch->mutex_);
+    while(batch->next_ < batch->count_) {
+        auto idx = batch->next_++;
+        lock.unlock();
+
+        std::exception_ptr error = nullptr;
+        try {
+            (*batch->function_)(idx);
+        } catch(...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if(error != nullptr && batch->error_ == nullptr) {
+            batch->error_ = error;
+        }
+        if(++batch->done_ == batch->count_) {
+            batch->cv_.notify_all();
+        }
+    }
+}
+
+void BackgroundTask::BatchWork(void *arg) {
+    std::unique_ptr<std::shared_ptr<Batch>> batch(reinterpret_cast<std::shared_ptr<Batch>*>(arg));
+    Work(batch->get());
 }
 
 void BackgroundTask::BackgroundThreadMain() {
     std::unique_lock<std::mutex> lock(mutex_);
     while(!is_shutting_down_.load(std::memory_order_acquire)) {
         while (background_work_queue_.empty()) {
-            cv_.notify_all();
             cv_.wait(lock);
 
             if(is_shutting_down_.load(std::memory_order_acquire)) {
@@ -36,14 +94,19 @@ void BackgroundTask::BackgroundThreadMain() {
         ASSERT(!background_work_queue_.empty(), "background_work_queue_ is empty");
         auto background_work_function = background_work_queue_.front().function_;
         void* background_work_arg = background_work_queue_.front().arg_;
+        background_work_queue_.pop();
+        running_count_++;
         lock.unlock();
 
         background_work_function(background_work_arg);
 
         lock.lock();
-        background_work_queue_.pop();
+        running_count_--;
+        if(background_work_queue_.empty() && running_count_ == 0) {
+            cv_.notify_all();
+        }
     };
 }
 
 
-}; // namespace ljdb
\ No newline at end of file
+}; // namespace ljdb
@@ -2,11 +2,13 @@
 
 namespace LindormContest {
 
-    auto NewDBOptions() -> DBOptions * {
+    auto NewDBOptions(int compaction_thread_count, int query_thread_count) -> DBOptions * {
         auto db_options = new DBOptions();
-        db_options->block_cache_ = new Cache<Block>(1 << 28);
-        db_options->table_cache_ = new TableCache(512, db_options->block_cache_);
-        db_options->bg_task_ = new BackgroundTask();
+        // block cache 的容量以字节计, block 按解码后的大小计费
+        db_options->block_cache_ = new Cache<Block>(K_BLOCK_CACHE_SIZE);
+        db_options->table_cache_ = new TableCache(512, db_options);
+        db_options->bg_task_ = new BackgroundTask(compaction_thread_count);
+        db_options->query_executor_ = new QueryExecutor(query_thread_count);
         return db_options;
     }
 } // namespace LindormContest
\ No newline at end of file
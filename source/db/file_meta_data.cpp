@@ -3,14 +3,16 @@
 #include <utility>
 #include <algorithm>
 #include "cache/table_cache.h"
+#include "common/exception.h"
 #include "db/file_meta_data.h"
 
 namespace LindormContest {
 
 FileMetaData::FileMetaData(file_number_t file_number, InternalKey smallest, InternalKey largest,
-                           uint64_t file_size, int64_t max_timestamp): file_number_(file_number),
-                           smallest_(std::move(smallest)), largest_(std::move(largest)), file_size_(file_size),
-                           max_timestamp_(max_timestamp) {
+                           uint64_t file_size, int64_t min_timestamp, int64_t max_timestamp, file_number_t sequence)
+                           : file_number_(file_number), smallest_(std::move(smallest)), largest_(std::move(largest)),
+                           file_size_(file_size), min_timestamp_(min_timestamp), max_timestamp_(max_timestamp),
+                           sequence_(sequence == 0 ? file_number : sequence) {
     // 简单的复制 leveldb
     allowed_seeks_ = static_cast<uint32_t>(file_size_ / 16384U);
     if(allowed_seeks_ < 100) {
@@ -27,9 +29,28 @@ FileMetaData::FileMetaData(const std::string &src) {
 
     uint32_t offset = 12 + INTERNAL_KEY_SIZE + INTERNAL_KEY_SIZE;
     max_timestamp_ = CodingUtil::DecodeFixed64(src.data() + offset);
+    offset += sizeof(max_timestamp_);
+    min_timestamp_ = CodingUtil::DecodeInt64(src.data() + offset);
+    offset += sizeof(min_timestamp_);
+    sequence_ = CodingUtil::DecodeUint32(src.data() + offset);
     allowed_seeks_ = static_cast<uint32_t>(file_size_ / 16384U);
 }
 
+FileMetaData::~FileMetaData() {
+    if(obsolete_table_cache_ == nullptr) {
+        return;
+    }
+
+    // 不再有版本或迭代器引用该文件
+    try {
+        obsolete_table_cache_->EvictSSTable(*this);
+        DiskManager::RemoveSSTableFile(file_number_);
+        LOG_DEBUG("remove obsolete sstable %d", file_number_);
+    } catch (Exception &e) {
+        LOG_ERROR("remove obsolete sstable %d failed : %s", file_number_, e.what());
+    }
+}
+
 void FileMetaData::EncodeTo(std::string *dst) const {
     char buffer[INTERNAL_KEY_SIZE];
     CodingUtil::EncodeValue(buffer, file_number_);
@@ -43,6 +64,12 @@ void FileMetaData::EncodeTo(std::string *dst) const {
 
     CodingUtil::EncodeValue(buffer, max_timestamp_);
     dst->append(buffer, sizeof(max_timestamp_));
+
+    CodingUtil::EncodeValue(buffer, min_timestamp_);
+    dst->append(buffer, sizeof(min_timestamp_));
+
+    CodingUtil::EncodeValue(buffer, sequence_);
+    dst->append(buffer, sizeof(sequence_));
 }
 
 class FileMetaDataIterator : public Iterator {
@@ -64,15 +91,15 @@ public:
         }
     }
 
-    auto GetKey() -> InternalKey override {
-        return InternalKey();
+    auto GetKey() -> const InternalKey & override {
+        return key_;
     }
 
-    auto GetValue() -> std::string override {
+    auto GetValue() -> std::string_view override {
         ASSERT(index_ < files_.size(), "index_ is out of range");
-        std::string ret;
-        files_[index_]->EncodeTo(&ret);
-        return ret;
+        value_.clear();
+        files_[index_]->EncodeTo(&value_);
+        return value_;
     }
 
     auto Valid() -> bool override {
@@ -86,15 +113,27 @@ public:
 private:
     std::vector<FileMetaDataPtr> files_;
     size_t index_{0};
+
+    InternalKey key_;
+    std::string value_;
 };
 
+void SortNewestFirst(std::vector<FileMetaDataPtr> *files) {
+    std::sort(files->begin(), files->end(), [](const FileMetaDataPtr &a, const FileMetaDataPtr &b) {
+        if(a->sequence_ != b->sequence_) {
+            return a->sequence_ > b->sequence_;
+        }
+        return a->GetFileNumber() > b->GetFileNumber();
+    });
+}
+
 auto NewFileMetaDataIterator(const std::vector<FileMetaDataPtr>& files) -> std::unique_ptr<Iterator> {
     return std::make_unique<FileMetaDataIterator>(files);
 }
 
-auto GetFileIterator(void *arg, const std::string &file_value) -> std::unique_ptr<Iterator> {
+auto GetFileIterator(void *arg, std::string_view file_value) -> std::unique_ptr<Iterator> {
     auto table_cache = reinterpret_cast<TableCache*>(arg);
-    auto file_meta_data = std::make_shared<FileMetaData>(file_value);
+    auto file_meta_data = std::make_shared<FileMetaData>(std::string(file_value));
     return table_cache->NewTableIterator(file_meta_data);
 }
 
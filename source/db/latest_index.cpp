@@ -0,0 +1,104 @@
+#include "db/latest_index.h"
+#include "db/format.h"
+#include "util/coding.h"
+
+namespace LindormContest {
+
+auto LatestIndex::GetStripe(const Vin &vin) -> size_t {
+    return (HashVin(vin) >> 16) % K_NUM_STRIPES;
+}
+
+void LatestIndex::Update(const Vin &vin, int64_t timestamp, std::string_view value) {
+    auto &stripe = stripes_[GetStripe(vin)];
+    std::unique_lock<std::shared_mutex> lock(stripe.mutex_);
+    auto iter = stripe.map_.find(vin);
+    if(iter == stripe.map_.end()) {
+        stripe.map_.emplace(vin, Entry{timestamp, std::string(value)});
+    } else if(iter->second.timestamp_ <= timestamp) {
+        iter->second.timestamp_ = timestamp;
+        iter->second.value_.assign(value.data(), value.size());
+    }
+}
+
+auto LatestIndex::Size() const -> size_t {
+    size_t size = 0;
+    for(auto &stripe : stripes_) {
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex_);
+        size += stripe.map_.size();
+    }
+    return size;
+}
+
+auto LatestIndex::WriteTo(std::ofstream &file) const -> void {
+    std::string data;
+    EncodeTo(&data);
+    file.write(data.data(), static_cast<int64_t>(data.size()));
+}
+
+auto LatestIndex::EncodeTo(std::string *dst) const -> void {
+    // 数量在编码完成后填入, 与编码的记录保持一致
+    auto count_offset = dst->size();
+    dst->resize(count_offset + CodingUtil::LENGTH_SIZE);
+
+    uint32_t count = 0;
+    char buffer[sizeof(int64_t)];
+    for(auto &stripe : stripes_) {
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex_);
+        for(auto &entry : stripe.map_) {
+            dst->append(entry.first.vin, VIN_LENGTH);
+            CodingUtil::PutInt64(buffer, entry.second.timestamp_);
+            dst->append(buffer, sizeof(int64_t));
+            CodingUtil::PutUint32(buffer, entry.second.value_.size());
+            dst->append(buffer, CodingUtil::LENGTH_SIZE);
+            dst->append(entry.second.value_);
+            count++;
+        }
+    }
+    CodingUtil::PutUint32(dst->data() + count_offset, count);
+}
+
+auto LatestIndex::DecodeFrom(std::string_view src) -> bool {
+    if(src.size() < CodingUtil::LENGTH_SIZE) {
+        return false;
+    }
+    auto count = CodingUtil::DecodeUint32(src.data());
+    size_t offset = CodingUtil::LENGTH_SIZE;
+
+    const size_t entry_header_size = VIN_LENGTH + sizeof(int64_t) + CodingUtil::LENGTH_SIZE;
+    Vin vin;
+    for(uint32_t i = 0; i < count; i++) {
+        if(offset + entry_header_size > src.size()) {
+            return false;
+        }
+        memcpy(vin.vin, src.data() + offset, VIN_LENGTH);
+        auto timestamp = CodingUtil::DecodeInt64(src.data() + offset + VIN_LENGTH);
+        auto value_size = CodingUtil::DecodeUint32(src.data() + offset + VIN_LENGTH + sizeof(int64_t));
+        offset += entry_header_size;
+        if(offset + value_size > src.size()) {
+            return false;
+        }
+        Update(vin, timestamp, src.substr(offset, value_size));
+        offset += value_size;
+    }
+    return true;
+}
+
+auto LatestIndex::ReadFrom(std::ifstream &file) -> void {
+    char buffer[sizeof(int64_t)];
+    file.read(buffer, CodingUtil::LENGTH_SIZE);
+    auto count = CodingUtil::DecodeUint32(buffer);
+
+    Vin vin;
+    std::string value;
+    for(uint32_t i = 0; i < count; i++) {
+        file.read(vin.vin, VIN_LENGTH);
+        file.read(buffer, sizeof(int64_t));
+        auto timestamp = CodingUtil::DecodeInt64(buffer);
+        file.read(buffer, CodingUtil::LENGTH_SIZE);
+        value.resize(CodingUtil::DecodeUint32(buffer));
+        file.read(value.data(), static_cast<int64_t>(value.size()));
+        Update(vin, timestamp, value);
+    }
+}
+
+}  // namespace LindormContest
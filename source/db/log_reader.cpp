@@ -0,0 +1,42 @@
+#include <fstream>
+#include "db/log_reader.h"
+#include "db/log_writer.h"
+#include "disk/disk_manager.h"
+#include "util/coding.h"
+#include "util/crc32.h"
+
+namespace LindormContest {
+
+LogReader::LogReader(file_number_t log_number) : LogReader(GET_LOG_NAME(log_number)) {}
+
+LogReader::LogReader(const std::string &filename) {
+    auto file = DiskManager::OpenFile(filename);
+    auto file_size = DiskManager::GetFileSize(file);
+    buffer_.resize(file_size);
+    DiskManager::ReadBlock(file, buffer_.data(), file_size, 0);
+    file.close();
+}
+
+auto LogReader::ReadRecord(std::string_view *record) -> bool {
+    if(offset_ + LOG_RECORD_HEADER_SIZE > buffer_.size()) {
+        return false;
+    }
+
+    auto checksum = CodingUtil::DecodeUint32(buffer_.data() + offset_);
+    auto length = CodingUtil::DecodeUint32(buffer_.data() + offset_ + CodingUtil::LENGTH_SIZE);
+    if(offset_ + LOG_RECORD_HEADER_SIZE + length > buffer_.size()) {
+        // 写入过程中崩溃, 末尾的 record 不完整
+        return false;
+    }
+
+    const char *payload = buffer_.data() + offset_ + LOG_RECORD_HEADER_SIZE;
+    if(Crc32::Value(payload, length) != checksum) {
+        return false;
+    }
+
+    *record = std::string_view(payload, length);
+    offset_ += LOG_RECORD_HEADER_SIZE + length;
+    return true;
+}
+
+}  // namespace LindormContest
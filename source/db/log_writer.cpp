@@ -0,0 +1,35 @@
+#include "db/log_writer.h"
+#include "disk/disk_manager.h"
+#include "util/coding.h"
+#include "util/crc32.h"
+
+namespace LindormContest {
+
+LogWriter::LogWriter(file_number_t log_number)
+    : log_number_(log_number), fd_(DiskManager::CreateAppendableFile(GET_LOG_NAME(log_number))) {}
+
+LogWriter::LogWriter(const std::string &filename)
+    : log_number_(0), fd_(DiskManager::OpenAppendableFile(filename)) {}
+
+LogWriter::~LogWriter() {
+    DiskManager::CloseFile(fd_);
+}
+
+auto LogWriter::AddRecord(std::string_view record) -> void {
+    char header[LOG_RECORD_HEADER_SIZE];
+    CodingUtil::PutUint32(header, Crc32::Value(record.data(), record.size()));
+    CodingUtil::PutUint32(header + CodingUtil::LENGTH_SIZE, record.size());
+
+    // header 与 payload 通过一次 write 写入
+    std::string buffer;
+    buffer.reserve(LOG_RECORD_HEADER_SIZE + record.size());
+    buffer.append(header, LOG_RECORD_HEADER_SIZE);
+    buffer.append(record.data(), record.size());
+    DiskManager::AppendFile(fd_, buffer.data(), buffer.size());
+}
+
+auto LogWriter::Sync() -> void {
+    DiskManager::SyncFile(fd_);
+}
+
+}  // namespace LindormContest
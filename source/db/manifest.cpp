@@ -0,0 +1,217 @@
+#include "db/manifest.h"
+#include "db/log_reader.h"
+#include "disk/disk_manager.h"
+#include "util/coding.h"
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+auto VersionEdit::EncodeTo(std::string *dst) const -> void {
+    char buffer[CodingUtil::LENGTH_SIZE];
+    auto put = [&](uint32_t value) {
+        CodingUtil::PutUint32(buffer, value);
+        dst->append(buffer, CodingUtil::LENGTH_SIZE);
+    };
+
+    put(shard_id_);
+    put(next_file_number_);
+    put(log_number_);
+
+    put(deleted_files_.size());
+    for(auto &file : deleted_files_) {
+        put(file.first);
+        put(file.second);
+    }
+
+    put(added_files_.size());
+    for(auto &file : added_files_) {
+        put(file.first);
+        file.second->EncodeTo(dst);
+    }
+}
+
+auto VersionEdit::DecodeFrom(std::string_view src) -> bool {
+    size_t offset = 0;
+    auto get = [&](uint32_t *value) {
+        if(offset + CodingUtil::LENGTH_SIZE > src.size()) {
+            return false;
+        }
+        *value = CodingUtil::DecodeUint32(src.data() + offset);
+        offset += CodingUtil::LENGTH_SIZE;
+        return true;
+    };
+
+    uint32_t count;
+    if(!get(&shard_id_) || !get(&next_file_number_) || !get(&log_number_) || !get(&count)) {
+        return false;
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t level, file_number;
+        if(!get(&level) || !get(&file_number)) {
+            return false;
+        }
+        deleted_files_.emplace_back(static_cast<int32_t>(level), file_number);
+    }
+
+    if(!get(&count)) {
+        return false;
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t level;
+        if(!get(&level) || offset + FILE_META_DATA_SIZE > src.size()) {
+            return false;
+        }
+        auto file = std::make_shared<FileMetaData>(std::string(src.substr(offset, FILE_META_DATA_SIZE)));
+        offset += FILE_META_DATA_SIZE;
+        added_files_.emplace_back(static_cast<int32_t>(level), std::move(file));
+    }
+    return offset == src.size();
+}
+
+// 解析 record 的类型、表名与 body
+static auto DecodeRecord(std::string_view record, ManifestRecordType *type, std::string *table_name,
+                         std::string_view *body) -> bool {
+    const size_t header_size = 1 + CodingUtil::LENGTH_SIZE;
+    if(record.size() < header_size) {
+        return false;
+    }
+    *type = static_cast<ManifestRecordType>(record[0]);
+    auto name_size = CodingUtil::DecodeUint32(record.data() + 1);
+    if(header_size + name_size > record.size()) {
+        return false;
+    }
+    *table_name = std::string(record.substr(header_size, name_size));
+    *body = record.substr(header_size + name_size);
+    return true;
+}
+
+void Manifest::Recover(const std::function<void(ManifestRecordType, const std::string &, std::string_view)> &apply) {
+    std::unique_ptr<LogReader> reader;
+    try {
+        reader = std::make_unique<LogReader>(MANIFEST_LOG_NAME);
+    } catch (Exception &e) {
+        LOG_INFO("manifest_log not found");
+        ResetLog();
+        return;
+    }
+
+    // 快照写入后、清空 log 前崩溃时, log 中的变更已经包含在快照中
+    std::string_view record;
+    ManifestRecordType type;
+    std::string table_name;
+    std::string_view body;
+    if(!reader->ReadRecord(&record) || !DecodeRecord(record, &type, &table_name, &body) || type != MANIFEST_LOG_HEADER
+       || body.size() != CodingUtil::LENGTH_SIZE || CodingUtil::DecodeUint32(body.data()) != generation_) {
+        LOG_INFO("discard stale manifest_log");
+        reader.reset();
+        ResetLog();
+        return;
+    }
+
+    uint32_t count = 0;
+    while(reader->ReadRecord(&record)) {
+        if(!DecodeRecord(record, &type, &table_name, &body)) {
+            throw Exception(ExceptionType::IO, "corrupted manifest_log record");
+        }
+        apply(type, table_name, body);
+        count++;
+    }
+    LOG_INFO("replay %u manifest_log records", count);
+
+    // 丢弃末尾不完整的 record, 之后追加的 record 才能被读取
+    auto size = reader->GetOffset();
+    reader.reset();
+    DiskManager::TruncateFile(MANIFEST_LOG_NAME, size);
+
+    std::scoped_lock<std::mutex> lock(mutex_);
+    log_ = std::make_unique<LogWriter>(MANIFEST_LOG_NAME);
+    log_size_ = size;
+}
+
+void Manifest::LogNewTable(const std::string &table_name, const Schema &schema, uint32_t shard_count) {
+    std::string body;
+    char buffer[CodingUtil::LENGTH_SIZE];
+    CodingUtil::PutUint32(buffer, shard_count);
+    body.append(buffer, CodingUtil::LENGTH_SIZE);
+    body.append(CodingUtil::SchemaToBytes(schema));
+    AddRecord(MANIFEST_NEW_TABLE, table_name, body);
+}
+
+void Manifest::LogEdit(const std::string &table_name, const VersionEdit &edit) {
+    std::string body;
+    edit.EncodeTo(&body);
+    AddRecord(MANIFEST_VERSION_EDIT, table_name, body);
+}
+
+void Manifest::LogLatestIndex(const std::string &table_name, uint32_t shard_id, file_number_t index_file_number) {
+    std::string body;
+    char buffer[CodingUtil::LENGTH_SIZE];
+    CodingUtil::PutUint32(buffer, shard_id);
+    body.append(buffer, CodingUtil::LENGTH_SIZE);
+    CodingUtil::PutUint32(buffer, index_file_number);
+    body.append(buffer, CodingUtil::LENGTH_SIZE);
+    AddRecord(MANIFEST_LATEST_INDEX, table_name, body);
+}
+
+auto Manifest::GetLogSize() const -> uint64_t {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    return log_size_;
+}
+
+void Manifest::WriteSnapshot(const std::function<void(std::ofstream &)> &write) {
+    const std::string temp_name = MANIFEST_FILE_NAME + ".tmp";
+    auto generation = generation_ + 1;
+    {
+        auto file = DiskManager::CreakWritableFile(temp_name);
+        char buffer[CodingUtil::LENGTH_SIZE];
+        CodingUtil::PutUint32(buffer, generation);
+        file.write(buffer, CodingUtil::LENGTH_SIZE);
+        write(file);
+        file.flush();
+        if(file.bad()) {
+            throw Exception(ExceptionType::IO, "I/O error while writing manifest_file");
+        }
+    }
+    auto fd = DiskManager::OpenAppendableFile(temp_name);
+    DiskManager::SyncFile(fd);
+    DiskManager::CloseFile(fd);
+
+    // 替换快照后旧的 log 因 generation 不一致而失效
+    DiskManager::RenameFile(temp_name, MANIFEST_FILE_NAME);
+    DiskManager::SyncDirectory();
+    generation_ = generation;
+    ResetLog();
+}
+
+void Manifest::AddRecord(ManifestRecordType type, const std::string &table_name, std::string_view body) {
+    std::string record;
+    record.reserve(1 + CodingUtil::LENGTH_SIZE + table_name.size() + body.size());
+    record.push_back(static_cast<char>(type));
+    char buffer[CodingUtil::LENGTH_SIZE];
+    CodingUtil::PutUint32(buffer, table_name.size());
+    record.append(buffer, CodingUtil::LENGTH_SIZE);
+    record.append(table_name);
+    record.append(body);
+
+    std::scoped_lock<std::mutex> lock(mutex_);
+    ASSERT(log_ != nullptr, "manifest_log is not opened");
+    log_->AddRecord(record);
+    log_->Sync();
+    log_size_ += LOG_RECORD_HEADER_SIZE + record.size();
+}
+
+void Manifest::ResetLog() {
+    {
+        std::scoped_lock<std::mutex> lock(mutex_);
+        log_ = std::make_unique<LogWriter>(MANIFEST_LOG_NAME);
+        DiskManager::TruncateFile(MANIFEST_LOG_NAME, 0);
+        log_size_ = 0;
+    }
+
+    char buffer[CodingUtil::LENGTH_SIZE];
+    CodingUtil::PutUint32(buffer, generation_);
+    AddRecord(MANIFEST_LOG_HEADER, "", std::string_view(buffer, CodingUtil::LENGTH_SIZE));
+}
+
+}  // namespace LindormContest
@@ -0,0 +1,99 @@
+#include "db/query_executor.h"
+
+namespace LindormContest {
+
+QueryExecutor::QueryExecutor(int thread_count) {
+    for(int i = 0; i < thread_count; i++) {
+        threads_.emplace_back(&QueryExecutor::WorkerMain, this);
+    }
+}
+
+QueryExecutor::~QueryExecutor() {
+    {
+        std::scoped_lock<std::mutex> lock(mutex_);
+        is_shutting_down_ = true;
+    }
+    cv_.notify_all();
+    for(auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+void QueryExecutor::Run(size_t count, const std::function<void(size_t)> &function) {
+    if(count == 0) {
+        return;
+    }
+    if(count == 1 || threads_.empty()) {
+        for(size_t i = 0; i < count; i++) {
+            function(i);
+        }
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->function_ = &function;
+    batch->count_ = count;
+
+    // 调用线程执行一个子任务, 其余的最多交给 count - 1 个线程
+    auto helpers = std::min(count - 1, threads_.size());
+    {
+        std::scoped_lock<std::mutex> lock(mutex_);
+        for(size_t i = 0; i < helpers; i++) {
+            batches_.push(batch);
+        }
+    }
+    if(helpers == 1) {
+        cv_.notify_one();
+    } else {
+        cv_.notify_all();
+    }
+
+    Work(batch.get());
+
+    std::unique_lock<std::mutex> lock(batch->mutex_);
+    batch->cv_.wait(lock, [&batch] { return batch->done_ == batch->count_; });
+    if(batch->error_ != nullptr) {
+        std::rethrow_exception(batch->error_);
+    }
+}
+
+void QueryExecutor::Work(Batch *batch) {
+    std::unique_lock<std::mutex> lock(batch->mutex_);
+    while(batch->next_ < batch->count_) {
+        auto idx = batch->next_++;
+        lock.unlock();
+
+        std::exception_ptr error = nullptr;
+        try {
+            (*batch->function_)(idx);
+        } catch(...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if(error != nullptr && batch->error_ == nullptr) {
+            batch->error_ = error;
+        }
+        if(++batch->done_ == batch->count_) {
+            batch->cv_.notify_all();
+        }
+    }
+}
+
+void QueryExecutor::WorkerMain() {
+    while(true) {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return is_shutting_down_ || !batches_.empty(); });
+            if(batches_.empty()) {
+                return;
+            }
+            batch = std::move(batches_.front());
+            batches_.pop();
+        }
+        Work(batch.get());
+    }
+}
+
+}  // namespace LindormContest
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <memory>
+#include <set>
 #include <utility>
 #include "db/table_meta_data.h"
 
@@ -24,33 +26,65 @@ void TableMetaData::GetOverlappingInputs(int level, const InternalKey *begin, co
 
 }
 
+auto TableMetaData::CompactionScore(int level) const -> double {
+    // 同一时刻只允许一个 l0 compaction, l0 的文件之间存在重叠
+    if(level == 0) {
+        for(auto &file : files_[0]) {
+            if(file->being_compacted_) {
+                return 0;
+            }
+        }
+        return static_cast<double>(files_[0].size()) / static_cast<double>(K_L0_COMPACTION_TRIGGER);
+    }
+
+    uint64_t total_file_size = 0;
+    for(auto &file : files_[level]) {
+        if(!file->being_compacted_) {
+            total_file_size += file->GetFileSize();
+        }
+    }
+    return static_cast<double>(total_file_size) / MaxBytesForLevel(level);
+}
+
 void TableMetaData::Finalize() {
-    // l0 compaction
-    int best_level = 0;
-    double best_score = static_cast<double>(files_[0].size()) /
-                 static_cast<double>(K_L0_COMPACTION_TRIGGER);
-
-    // l1 ~ l6 compaction
-    for(int level = 1; level < K_NUM_LEVELS - 1; level++) {
-        double score = static_cast<double>(TotalFileSize(level)) /
-                       MaxBytesForLevel(level);
-        if(score > best_score) {
-            best_score = score;
-            best_level = level;
+    if(time_window_size_ > 0) {
+        // 所有文件位于 L0, 存在需要合并的窗口时分数为 1
+        auto windows = GetTimeWindows();
+        double score = 0;
+        for(auto it = windows.begin(); it != windows.end(); it++) {
+            if(!PickTimeWindowInputs(it->second, std::next(it) == windows.end(), std::numeric_limits<file_number_t>::max()).empty()) {
+                score = 1;
+                break;
+            }
         }
+        compaction_score_[0] = score;
+        size_compaction_score_ = score;
+        size_compaction_level_ = 0;
+        return;
     }
 
+    // 正在压缩的文件不计入分数
+    int best_level = 0;
+    double best_score = -1;
+    for(int level = 0; level < K_NUM_LEVELS - 1; level++) {
 #ifdef DEBUG_MODE_CLOSE_COMPRESSION
-    size_compaction_score_ = 0;
-    size_compaction_level_ = -1;
+        compaction_score_[level] = 0;
 #else
+        compaction_score_[level] = CompactionScore(level);
+#endif
+        if(compaction_score_[level] > best_score) {
+            best_score = compaction_score_[level];
+            best_level = level;
+        }
+    }
+
     size_compaction_score_ = best_score;
     size_compaction_level_ = best_level;
-#endif
 }
 
 void TableMetaData::SeekCompaction(int level, FileMetaDataPtr meta_data) {
-    if(seek_compaction_level_ != -1) {
+    // time window compaction 只合并同一窗口的文件
+    if(seek_compaction_level_ != -1 || time_window_size_ > 0) {
         return;
     }
 
@@ -58,54 +92,94 @@ void TableMetaData::SeekCompaction(int level, FileMetaDataPtr meta_data) {
     seek_compaction_file_ = std::move(meta_data);
 }
 
-auto TableMetaData::GenerateCompactionTask() -> CompactionTask* {
-    const bool size_compaction = size_compaction_score_ >= 1 && size_compaction_level_ >= 0;
-    const bool seek_compaction = seek_compaction_level_ != -1;
-
-    if(!size_compaction && !seek_compaction) {
-        return nullptr;
+auto TableMetaData::GenerateCompactionTask(file_number_t flushing_sequence) -> CompactionTask* {
+    if(time_window_size_ > 0) {
+        return PickTimeWindowCompaction(flushing_sequence);
     }
 
-    auto task = new CompactionTask();
-
-    std::vector<FileMetaDataPtr> files;
-
-    // 确定压缩文件的开始位置
-    size_t start_idx = 0;
-    if(size_compaction) {
-        files = GetFileMetaData(size_compaction_level_);
-        task->level_ = size_compaction_level_;
-        task->type_ = CompactionType::SizeCompaction;
+    // 按分数从高到低选择第一个与正在执行的 compaction 不冲突的 level
+    std::vector<int> levels;
+    for(int level = 0; level < K_NUM_LEVELS - 1; level++) {
+        if(compaction_score_[level] >= 1) {
+            levels.push_back(level);
+        }
+    }
+    std::stable_sort(levels.begin(), levels.end(), [this](int a, int b) {
+        return compaction_score_[a] > compaction_score_[b];
+    });
 
+    for(auto level : levels) {
+        auto &files = files_[level];
+        size_t start_idx = 0;
         for(size_t i = 0; i < files.size(); i++) {
-            if(files[i]->GetSmallest() > size_compaction_pointer_[size_compaction_level_]) {
+            if(files[i]->GetSmallest() > size_compaction_pointer_[level] && !files[i]->being_compacted_) {
                 start_idx = i;
                 break;
             }
         }
-    } else {
-        files = GetFileMetaData(seek_compaction_level_);
 
-        task->level_ = seek_compaction_level_;
-        task->type_ = CompactionType::SeekCompaction;
+        auto task = PickCompaction(level, CompactionType::SizeCompaction, start_idx, flushing_sequence);
+        if(task != nullptr) {
+            return task;
+        }
+    }
 
-        for(size_t i = 0; i < files.size(); i++) {
-            if(files[i]->GetFileNumber() == seek_compaction_file_->GetFileNumber()) {
-                start_idx = i;
-                break;
-            }
+    if(seek_compaction_level_ == -1) {
+        return nullptr;
+    }
+
+    auto &files = files_[seek_compaction_level_];
+    for(size_t i = 0; i < files.size(); i++) {
+        if(files[i]->GetFileNumber() == seek_compaction_file_->GetFileNumber()) {
+            return PickCompaction(seek_compaction_level_, CompactionType::SeekCompaction, i, flushing_sequence);
         }
     }
 
-    // 确定压缩文件的结束位置
+    // 文件已经被其它 compaction 删除
+    seek_compaction_level_ = -1;
+    seek_compaction_file_ = nullptr;
+    return nullptr;
+}
+
+auto TableMetaData::PickCompaction(int level, CompactionType type, size_t start_idx,
+                                   file_number_t flushing_sequence) -> CompactionTask* {
+    auto &files = files_[level];
+    if(level == 0 && std::any_of(files.begin(), files.end(), [](auto &file) { return file->being_compacted_; })) {
+        return nullptr;
+    }
+
+    auto task = new CompactionTask();
+    task->level_ = level;
+    task->output_level_ = level + 1;
+    task->type_ = type;
+
     uint64_t compaction_size = 0;
-    for(size_t i = start_idx; i < files.size(); i++) {
-        if(compaction_size + files[i]->GetFileSize() > MAX_FILE_SIZE + MAX_FILE_SIZE) {
-            break;
+    if(level == 0) {
+        // L0 的文件之间存在重叠, 按 sequence 从旧到新连续选择, 留在 L0 的文件都比 L1 中的数据新
+        // 比正在 flush 的 memtable 更新的文件留在 L0, 否则 flush 完成后 L0 中的旧数据会覆盖 L1 中的新数据
+        auto candidates = files;
+        SortNewestFirst(&candidates);
+        std::reverse(candidates.begin(), candidates.end());
+        for(auto &file : candidates) {
+            if(file->sequence_ >= flushing_sequence) {
+                break;
+            }
+            if(!task->input_files_[0].empty() && compaction_size + file->GetFileSize() > MAX_FILE_SIZE + MAX_FILE_SIZE) {
+                break;
+            }
+            task->input_files_[0].emplace_back(file);
+            compaction_size += file->GetFileSize();
         }
+    } else {
+        // 确定压缩文件的结束位置
+        for(size_t i = start_idx; i < files.size(); i++) {
+            if(files[i]->being_compacted_ || compaction_size + files[i]->GetFileSize() > MAX_FILE_SIZE + MAX_FILE_SIZE) {
+                break;
+            }
 
-        task->input_files_[0].emplace_back(files[i]);
-        compaction_size += files[i]->GetFileSize();
+            task->input_files_[0].emplace_back(files[i]);
+            compaction_size += files[i]->GetFileSize();
+        }
     }
 
     if(task->input_files_[0].empty()) {
@@ -113,14 +187,110 @@ auto TableMetaData::GenerateCompactionTask() -> CompactionTask* {
         return nullptr;
     }
 
-    // 确定 level + 1 的文件
+    // 确定 level + 1 的文件, 与正在压缩的文件重叠时放弃
+    // L0 的文件之间存在重叠且按 sequence 选择, 需要取所有输入文件的 smallest 与 largest
     auto start_key = task->input_files_[0][0]->GetSmallest();
     auto end_key = task->input_files_[0].back()->GetLargest();
-    GetOverlappingInputs(size_compaction_level_ + 1, &start_key, &end_key, &task->input_files_[1]);
+    for(auto &file : task->input_files_[0]) {
+        if(file->GetSmallest() < start_key) {
+            start_key = file->GetSmallest();
+        }
+        if(end_key < file->GetLargest()) {
+            end_key = file->GetLargest();
+        }
+    }
+    GetOverlappingInputs(level + 1, &start_key, &end_key, &task->input_files_[1]);
+    for(auto &file : task->input_files_[1]) {
+        if(file->being_compacted_) {
+            delete task;
+            return nullptr;
+        }
+    }
 
+    for(auto &files : task->input_files_) {
+        for(auto &file : files) {
+            file->being_compacted_ = true;
+        }
+    }
     return task;
 }
 
+auto TableMetaData::GetExpiredFiles() const -> std::vector<std::pair<int, FileMetaDataPtr>> {
+    std::vector<std::pair<int, FileMetaDataPtr>> expired;
+    if(expire_timestamp_ == INT64_MIN) {
+        return expired;
+    }
+    for(int level = 0; level < K_NUM_LEVELS; level++) {
+        for(auto &file : files_[level]) {
+            if(file->max_timestamp_ < expire_timestamp_ && !file->being_compacted_) {
+                expired.emplace_back(level, file);
+            }
+        }
+    }
+    return expired;
+}
+
+auto TableMetaData::GetTimeWindows() const -> std::map<int64_t, std::vector<FileMetaDataPtr>> {
+    std::map<int64_t, std::vector<FileMetaDataPtr>> windows;
+    for(auto &file : files_[0]) {
+        windows[GetTimeWindow(file)].push_back(file);
+    }
+    return windows;
+}
+
+auto TableMetaData::PickTimeWindowInputs(const std::vector<FileMetaDataPtr> &files, bool newest,
+                                         file_number_t flushing_sequence) const -> std::vector<FileMetaDataPtr> {
+    // 同一次 flush 或 compaction 输出的文件 sequence 相同, 属于同一个 sorted run
+    std::vector<FileMetaDataPtr> inputs;
+    std::set<file_number_t> runs;
+    for(auto &file : files) {
+        if(file->being_compacted_) {
+            return {};
+        }
+        // 比正在 flush 的 memtable 更新的文件不能与更旧的文件合并, 否则合并结果会遮盖 flush 的数据
+        if(file->sequence_ < flushing_sequence) {
+            inputs.push_back(file);
+            runs.insert(file->sequence_);
+        }
+    }
+
+    size_t trigger = newest ? K_L0_COMPACTION_TRIGGER : 2;
+    if(runs.size() < trigger) {
+        return {};
+    }
+    return inputs;
+}
+
+auto TableMetaData::PickTimeWindowCompaction(file_number_t flushing_sequence) -> CompactionTask* {
+    // 优先合并旧的窗口, 旧窗口不再写入, 合并一次后不再参与 compaction
+    auto windows = GetTimeWindows();
+    for(auto it = windows.begin(); it != windows.end(); it++) {
+        auto inputs = PickTimeWindowInputs(it->second, std::next(it) == windows.end(), flushing_sequence);
+        if(inputs.empty()) {
+            continue;
+        }
+
+        auto task = new CompactionTask();
+        task->level_ = 0;
+        task->output_level_ = 0;
+        task->type_ = CompactionType::SizeCompaction;
+        task->input_files_[0] = std::move(inputs);
+        for(auto &file : task->input_files_[0]) {
+            file->being_compacted_ = true;
+        }
+        return task;
+    }
+    return nullptr;
+}
+
+void TableMetaData::ReleaseCompactionTask(CompactionTask *task) {
+    for(auto &files : task->input_files_) {
+        for(auto &file : files) {
+            file->being_compacted_ = false;
+        }
+    }
+}
+
 void TableMetaData::AddFileMetaData(int32_t level, const std::vector<FileMetaDataPtr> &file) {
     files_[level].insert(files_[level].end(), file.begin(), file.end());
     std::sort(files_[level].begin(), files_[level].end(), [](const auto &a, const auto &b) {
@@ -145,12 +315,22 @@ void TableMetaData::RemoveFileMetaData(int32_t level, const std::vector<FileMeta
     }
 }
 
+void TableMetaData::RemoveFileMetaData(int32_t level, file_number_t file_number) {
+    auto it = std::find_if(files_[level].begin(), files_[level].end(), [&](const FileMetaDataPtr &f) {
+        return f->GetFileNumber() == file_number;
+    });
+    if(it != files_[level].end()) {
+        files_[level].erase(it);
+    }
+}
+
 void TableMetaData::ClearCompaction() {
     seek_compaction_level_ = -1;
     seek_compaction_file_ = nullptr;
 
     size_compaction_level_ = -1;
     size_compaction_score_ = 0;
+    std::fill(std::begin(compaction_score_), std::end(compaction_score_), 0);
 }
 
 
@@ -0,0 +1,1251 @@
+
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include "db/table_shard.h"
+#include "util/coding.h"
+#include "common/config.h"
+#include "sstable/sstable_builder.h"
+#include "db/background.h"
+#include "common/merger_iterator.h"
+#include "common/two_level_iterator.h"
+#include "db/file_meta_data.h"
+#include "common/logger.h"
+#include "common/exception.h"
+
+namespace LindormContest {
+
+TableShard::TableShard(std::string table_name, Schema schema, uint32_t shard_id, DBOptions *options,
+                       std::atomic<int64_t> *newest_timestamp) :
+table_name_(std::move(table_name)), schema_(std::move(schema)), shard_id_(shard_id), options_(options),
+table_cache_(options->table_cache_), newest_timestamp_(newest_timestamp) {
+    if(options_->compaction_style_ == TimeWindowCompaction) {
+        table_meta_data_.SetTimeWindowSize(options_->time_window_size_);
+    }
+    for(auto &column : schema_.columnTypeMap) {
+        column_types_.push_back(column.second);
+    }
+    auto retention = options_->retention_.find(table_name_);
+    if(retention != options_->retention_.end()) {
+        retention_ = retention->second;
+    }
+}
+
+
+enum LogRecordType : uint8_t {
+    LOG_TABLE_HEADER = 1,
+    LOG_WRITE_BATCH = 2,
+};
+
+auto TableShard::Upsert(const std::vector<const Row*> &rows) -> int {
+    Writer w(&rows);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // 若其他线程正在写入, 则等待, 当前请求可能被 leader 一并写入
+    write_queue_.push_back(&w);
+    while(!w.done_ && (write_queue_.front() != &w || imm_.size() >= 5)) {
+        cv_.wait(lock);
+    }
+
+    if(w.done_) {
+        return w.result_;
+    }
+
+    if(is_shutting_down_.load(std::memory_order_acquire)) {
+        write_queue_.pop_front();
+        cv_.notify_all();
+        return -1;
+    }
+
+    int result = 0;
+    try {
+        MakeRoomForWrite();
+    } catch (Exception &e) {
+        LOG_ERROR("create log file failed : %s", e.what());
+        result = -1;
+    }
+
+    // 合并队列中的写请求
+    size_t group_size = 1;
+    if(result == 0) {
+        auto max_group_size = static_cast<size_t>(std::max(options_->max_write_group_size_, 1));
+        group_size = std::min(write_queue_.size(), max_group_size);
+    }
+    std::vector<Writer*> group(write_queue_.begin(), write_queue_.begin() + static_cast<int64_t>(group_size));
+
+    if(result == 0) {
+        auto mem = mem_;
+        auto log = log_.get();
+        lock.unlock();
+
+        // 编码 WAL record
+        std::string record;
+        record.push_back(static_cast<char>(LOG_WRITE_BATCH));
+        uint32_t row_count = 0;
+        record.resize(record.size() + CodingUtil::LENGTH_SIZE);
+        for(auto writer : group) {
+            for(auto row : *writer->rows_) {
+                auto key = InternalKey(row->vin, row->timestamp).Encode();
+                record.append(key);
+
+                auto length_offset = record.size();
+                record.resize(length_offset + CodingUtil::LENGTH_SIZE);
+                CodingUtil::EncodeRowValue(*row, &record);
+                CodingUtil::PutUint32(record.data() + length_offset, record.size() - length_offset - CodingUtil::LENGTH_SIZE);
+                row_count++;
+            }
+        }
+        CodingUtil::PutUint32(record.data() + 1, row_count);
+
+        try {
+            if(log != nullptr) {
+                log->AddRecord(record);
+                if(options_->sync_wal_) {
+                    log->Sync();
+                    log_sync_count_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            // 将数据写入 memtable, 当前线程是 mem 唯一的写入者
+            InsertLogRecord(record, mem.get());
+        } catch (Exception &e) {
+            LOG_ERROR("write log failed : %s", e.what());
+            result = -1;
+        }
+
+        lock.lock();
+    }
+
+    for(auto writer : group) {
+        write_queue_.pop_front();
+        writer->result_ = result;
+        writer->done_ = true;
+    }
+    cv_.notify_all();
+    return result;
+}
+
+void TableShard::MakeRoomForWrite() {
+    if(mem_ == nullptr) {
+        mem_ = std::make_shared<MemTable>();
+    } else if(mem_->ApproximateSize() >= K_MEM_TABLE_SIZE_THRESHOLD) {
+        LOG_INFO("memtable is full, flush to immtable");
+
+        StartMemTableCompaction(mem_);
+
+        imm_.push_back(mem_);
+        mem_ = std::make_shared<MemTable>();
+        log_.reset();
+    }
+
+    if(log_ == nullptr && options_->use_wal_) {
+        NewLogFile();
+    }
+    if(log_ != nullptr) {
+        mem_log_numbers_.emplace(mem_.get(), log_->GetLogNumber());
+    }
+}
+
+void TableShard::NewLogFile() {
+    auto log = std::make_unique<LogWriter>(options_->NextFileNumber());
+
+    // 第一条 record 记录表名、shard 编号与 schema, 用于恢复尚未写入 manifest 的表
+    std::string record;
+    record.push_back(static_cast<char>(LOG_TABLE_HEADER));
+    char buffer[CodingUtil::LENGTH_SIZE];
+    CodingUtil::PutUint32(buffer, shard_id_);
+    record.append(buffer, CodingUtil::LENGTH_SIZE);
+    CodingUtil::PutUint32(buffer, table_name_.size());
+    record.append(buffer, CodingUtil::LENGTH_SIZE);
+    record.append(table_name_);
+    record.append(CodingUtil::SchemaToBytes(schema_));
+    log->AddRecord(record);
+
+    log_numbers_.push_back(log->GetLogNumber());
+    log_ = std::move(log);
+}
+
+auto TableShard::DecodeLogHeader(std::string_view record, std::string *table_name, Schema *schema,
+                                 uint32_t *shard_id) -> bool {
+    const size_t header_size = 1 + CodingUtil::LENGTH_SIZE * 2;
+    if(record.size() < header_size || record[0] != static_cast<char>(LOG_TABLE_HEADER)) {
+        return false;
+    }
+    *shard_id = CodingUtil::DecodeUint32(record.data() + 1);
+    auto name_size = CodingUtil::DecodeUint32(record.data() + 1 + CodingUtil::LENGTH_SIZE);
+    if(header_size + name_size > record.size()) {
+        return false;
+    }
+    *table_name = std::string(record.substr(header_size, name_size));
+    *schema = CodingUtil::BytesToSchema(std::string(record.substr(header_size + name_size)));
+    return true;
+}
+
+void TableShard::InsertLogRecord(std::string_view record, MemTable *mem) {
+    ASSERT(record[0] == static_cast<char>(LOG_WRITE_BATCH), "invalid log record type");
+    auto row_count = CodingUtil::DecodeUint32(record.data() + 1);
+    const char *p = record.data() + 1 + CodingUtil::LENGTH_SIZE;
+    int64_t newest_timestamp = INT64_MIN;
+    for(uint32_t i = 0; i < row_count; i++) {
+        InternalKey key(p);
+        p += INTERNAL_KEY_SIZE;
+        auto value_size = CodingUtil::DecodeUint32(p);
+        p += CodingUtil::LENGTH_SIZE;
+        mem->Insert(key, std::string_view(p, value_size));
+        latest_index_.Update(key.vin_, key.timestamp_, std::string_view(p, value_size));
+        newest_timestamp = std::max(newest_timestamp, key.timestamp_);
+        p += value_size;
+    }
+    UpdateNewestTimestamp(newest_timestamp);
+}
+
+void TableShard::UpdateNewestTimestamp(int64_t timestamp) {
+    auto newest = newest_timestamp_->load(std::memory_order_relaxed);
+    while(newest < timestamp && !newest_timestamp_->compare_exchange_weak(newest, timestamp, std::memory_order_relaxed)) {
+    }
+}
+
+auto TableShard::GetExpireTimestamp() const -> int64_t {
+    auto newest = newest_timestamp_->load(std::memory_order_relaxed);
+    if(retention_ <= 0 || newest == INT64_MIN) {
+        return INT64_MIN;
+    }
+    // 超前于当前时间的异常时间戳不会使其它数据提前过期
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    return std::min<int64_t>(newest, now) - retention_;
+}
+
+auto TableShard::RecoverLogFile(file_number_t log_number, LogReader &reader) -> void {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    // 数据已经写入 sstable, 删除 WAL 前崩溃时遗留
+    if(log_number < log_number_) {
+        DiskManager::RemoveFile(GET_LOG_NAME(log_number));
+        return;
+    }
+    log_numbers_.push_back(log_number);
+
+    std::string_view record;
+    while(reader.ReadRecord(&record)) {
+        if(record.empty() || record[0] != static_cast<char>(LOG_WRITE_BATCH)) {
+            continue;
+        }
+
+        if(mem_ == nullptr) {
+            mem_ = std::make_shared<MemTable>();
+        } else if(mem_->ApproximateSize() >= K_MEM_TABLE_SIZE_THRESHOLD) {
+            StartMemTableCompaction(mem_);
+            imm_.push_back(mem_);
+            mem_ = std::make_shared<MemTable>();
+        }
+        mem_log_numbers_.emplace(mem_.get(), log_number);
+
+        InsertLogRecord(record, mem_.get());
+    }
+}
+
+void TableShard::EraseLogFile() {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    log_.reset();
+    for(auto log_number : log_numbers_) {
+        DiskManager::RemoveFile(GET_LOG_NAME(log_number));
+    }
+    log_numbers_.clear();
+}
+
+auto TableShard::GetQuerySnapshot() -> QuerySnapshot {
+    QuerySnapshot snapshot;
+    std::scoped_lock<std::mutex> lock(mutex_);
+    snapshot.mem_ = mem_;
+    for(auto iter = imm_.rbegin(); iter != imm_.rend(); ++iter) {
+        snapshot.imm_.push_back(*iter);
+    }
+    for(int i = 0; i < K_NUM_LEVELS; ++i) {
+        snapshot.files_[i] = table_meta_data_.GetFileMetaData(i);
+    }
+    SortNewestFirst(&snapshot.files_[0]);
+    return snapshot;
+}
+
+auto TableShard::QueryTaskCount(size_t count, size_t min_task_size) const -> size_t {
+    if(options_->query_executor_ == nullptr || options_->max_query_parallelism_ <= 1) {
+        return 1;
+    }
+    return std::max<size_t>(1, std::min<size_t>(options_->max_query_parallelism_, count / min_task_size));
+}
+
+void TableShard::ParallelVinQuery(const std::vector<Vin> &sorted_vins,
+                                  const std::function<void(const std::vector<Vin> &, std::vector<Row> *)> &function,
+                                  std::vector<Row> &pReadRes) {
+    auto tasks = QueryTaskCount(sorted_vins.size(), K_MIN_QUERY_TASK_VINS);
+    if(tasks == 1) {
+        function(sorted_vins, &pReadRes);
+        return;
+    }
+
+    // 每个子任务查找一段连续的 vin, 按顺序拼接后结果仍按 vin 有序
+    std::vector<std::vector<Row>> results(tasks);
+    options_->query_executor_->Run(tasks, [&](size_t i) {
+        std::vector<Vin> task_vins(sorted_vins.begin() + static_cast<std::ptrdiff_t>(sorted_vins.size() * i / tasks),
+                                   sorted_vins.begin() + static_cast<std::ptrdiff_t>(sorted_vins.size() * (i + 1) / tasks));
+        function(task_vins, &results[i]);
+    });
+    for(auto &rows : results) {
+        pReadRes.insert(pReadRes.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    }
+}
+
+auto TableShard::ExecuteLatestQuery(const std::vector<Vin> &vins, const std::set<std::string> &columns,
+                                    std::vector<Row> &pReadRes) -> int {
+    // 请求中可能包含重复的 vin, 结果按 vin 有序且不重复
+    // 逐层查找时每个 memtable 与 sstable 的迭代器只需要向前扫描一次, 使用 latest index 时排序只用于去重与结果有序
+    std::vector<Vin> sorted_vins(vins);
+    std::sort(sorted_vins.begin(), sorted_vins.end());
+    sorted_vins.erase(std::unique(sorted_vins.begin(), sorted_vins.end()), sorted_vins.end());
+
+    if(options_->use_latest_index_) {
+        ParallelVinQuery(sorted_vins, [&](const std::vector<Vin> &task_vins, std::vector<Row> *result) {
+            IndexLatestQuery(task_vins, columns, *result);
+        }, pReadRes);
+        return 0;
+    }
+
+    auto snapshot = GetQuerySnapshot();
+    ParallelVinQuery(sorted_vins, [&](const std::vector<Vin> &task_vins, std::vector<Row> *result) {
+        LayeredLatestQuery(task_vins, columns, snapshot, *result);
+    }, pReadRes);
+    return 0;
+}
+
+void TableShard::LayeredLatestQuery(const std::vector<Vin> &vins, const std::set<std::string> &columns,
+                                    const QuerySnapshot &snapshot, std::vector<Row> &pReadRes) {
+    auto query = QueryRequest(&vins, &columns, &pReadRes);
+
+    auto query_func = [this](std::unique_ptr<Iterator> iter, const std::vector<Vin> &vins, TableShard::QueryRequest &req,
+                             int64_t max_timestamp) {
+        bool positioned = false;
+        for(auto &vin : vins) {
+            if(max_timestamp != -1 && req.vin_map_.count(vin) != 0 && req.vin_map_[vin].timestamp >= max_timestamp) {
+                continue;
+            }
+
+            if(max_timestamp != -1) {
+                sstable_probe_count_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // 迭代器位于上一个 vin 之后的第一个 key, 已经不小于 target 时不需要 Seek
+            InternalKey target(vin, MAX_TIMESTAMP);
+            if(!positioned || (iter->Valid() && iter->GetKey() < target)) {
+                iter->Seek(target);
+                positioned = true;
+            }
+            if(!iter->Valid()) {
+                break;
+            }
+
+            const auto &key = iter->GetKey();
+            if(key.vin_ != vin) {
+                continue;
+            }
+
+            if(req.vin_map_.count(key.vin_) == 0 || req.vin_map_[key.vin_].timestamp < key.timestamp_) {
+                Row row = CodingUtil::DecodeRow(iter->GetValue().data(), schema_, req.columns_);
+                row.vin = vin;
+                row.timestamp = key.timestamp_;
+                req.vin_map_[row.vin] = row;
+            }
+        }
+    };
+
+    // mem 的读取不需要加锁
+    if(snapshot.mem_ != nullptr) {
+        query_func(snapshot.mem_->NewIterator(), vins, query, -1);
+    }
+
+    // 搜索 imm
+    for(auto &imm : snapshot.imm_) {
+        query_func(imm->NewIterator(), vins, query, -1);
+    }
+
+    // 搜索 sstable, 布隆过滤器排除的 vin 不需要 Seek, 全部排除时不创建迭代器
+    auto column_mask = GetColumnMask(columns);
+    std::vector<std::pair<FileMetaDataPtr, std::vector<Vin>>> files;
+    auto add_file = [&](const FileMetaDataPtr &f, const std::vector<Vin> &file_vins) {
+        std::vector<Vin> candidates;
+        for(auto &vin : file_vins) {
+            // memtable 中已经找到更新的行
+            auto iter = query.vin_map_.find(vin);
+            if(iter == query.vin_map_.end() || iter->second.timestamp < f->max_timestamp_) {
+                candidates.push_back(vin);
+            }
+        }
+        if(options_->use_bloom_filter_) {
+            std::vector<Vin> filtered;
+            table_cache_->FilterVins(f, candidates, &filtered);
+            candidates.swap(filtered);
+        }
+        if(!candidates.empty()) {
+            files.emplace_back(f, std::move(candidates));
+        }
+    };
+
+    for(auto &f : snapshot.files_[0]) {
+        add_file(f, vins);
+    }
+
+    // L1 及以上的文件有序且不重叠, vin 的最新一行只可能在 largest 不小于 (vin, MAX_TIMESTAMP) 的第一个文件中
+    for(int level = 1; level < K_NUM_LEVELS; level++) {
+        auto &level_files = snapshot.files_[level];
+        std::vector<std::vector<Vin>> file_vins(level_files.size());
+        auto file_iter = level_files.begin();
+        for(auto &vin : vins) {
+            InternalKey target(vin, MAX_TIMESTAMP);
+            file_iter = std::lower_bound(file_iter, level_files.end(), target,
+                                         [](const FileMetaDataPtr &f, const InternalKey &key) { return f->GetLargest() < key; });
+            if(file_iter == level_files.end()) {
+                break;
+            }
+            if(!(vin < (*file_iter)->GetSmallest().vin_)) {
+                file_vins[file_iter - level_files.begin()].push_back(vin);
+            }
+        }
+        for(size_t i = 0; i < level_files.size(); i++) {
+            if(!file_vins[i].empty()) {
+                add_file(level_files[i], file_vins[i]);
+            }
+        }
+    }
+
+    // 一次提交所有 sstable 需要读取的 block, 之后的查找直接命中 block cache
+    if(options_->batch_block_reads_) {
+        table_cache_->PrefetchBlocks(files, &column_mask);
+    }
+
+    for(auto &file : files) {
+        auto iter = table_cache_->NewTableIterator(file.first, &column_mask);
+        query_func(std::move(iter), file.second, query, file.first->max_timestamp_);
+    }
+
+    auto expire_timestamp = GetExpireTimestamp();
+    for(auto &row : query.vin_map_) {
+        if(row.second.timestamp >= expire_timestamp) {
+            pReadRes.push_back(row.second);
+        }
+    }
+}
+
+void TableShard::IndexLatestQuery(const std::vector<Vin> &vins, const std::set<std::string> &columns,
+                                  std::vector<Row> &pReadRes) {
+    // 持有分段的读锁时直接解码, 不复制整行数据
+    auto expire_timestamp = GetExpireTimestamp();
+    for(auto &vin : vins) {
+        latest_index_.Get(vin, [&](int64_t timestamp, std::string_view value) {
+            if(timestamp < expire_timestamp) {
+                return;
+            }
+            Row row = CodingUtil::DecodeRow(value.data(), schema_, &columns);
+            row.vin = vin;
+            row.timestamp = timestamp;
+            pReadRes.push_back(std::move(row));
+        });
+    }
+}
+
+auto TableShard::GetColumnMask(const std::set<std::string> &columns) const -> ColumnMask {
+    ColumnMask column_mask;
+    column_mask.reserve(schema_.columnTypeMap.size());
+    for(auto &column : schema_.columnTypeMap) {
+        column_mask.push_back(columns.count(column.first) != 0);
+    }
+    return column_mask;
+}
+
+auto TableShard::ExecuteTimeRangeQuery(const TimeRangeQueryRequest &trReadReq, std::vector<Row> &trReadRes) -> int {
+    // 过期的数据可能尚未被 compaction 删除
+    auto time_lower_bound = std::max(trReadReq.timeLowerBound, GetExpireTimestamp());
+    if(time_lower_bound >= trReadReq.timeUpperBound) {
+        return 0;
+    }
+    auto query = RangeQueryRequest(trReadReq.vin, time_lower_bound, trReadReq.timeUpperBound,
+                                   &trReadReq.requestedColumns, &trReadRes);
+    query.column_mask_ = GetColumnMask(trReadReq.requestedColumns);
+
+    // 按从新到旧的顺序排列需要查找的 memtable 与 sstable, 同一时间戳只保留最先找到的行
+    auto snapshot = GetQuerySnapshot();
+    std::vector<std::shared_ptr<MemTable>> mems;
+    if(snapshot.mem_ != nullptr) {
+        mems.push_back(snapshot.mem_);
+    }
+    mems.insert(mems.end(), snapshot.imm_.begin(), snapshot.imm_.end());
+    std::vector<FileMetaDataPtr> files;
+    for(auto &level_files : snapshot.files_) {
+        for(auto &f : level_files) {
+            if(FileOverlapsRange(f, query)) {
+                files.push_back(f);
+            }
+        }
+    }
+
+    auto source_count = mems.size() + files.size();
+    auto query_sources = [&](size_t begin, size_t end, RangeQueryRequest &req) {
+        req.batch_.Init(column_types_, &req.column_mask_);
+        for(size_t i = begin; i < end; i++) {
+            if(i < mems.size()) {
+                MemTableRangeQuery(req, mems[i]);
+            } else {
+                FileTableRangeQuery(files[i - mems.size()], req);
+            }
+        }
+    };
+
+    auto tasks = QueryTaskCount(source_count, K_MIN_QUERY_TASK_SOURCES);
+    if(tasks == 1) {
+        query_sources(0, source_count, query);
+        return 0;
+    }
+
+    // 每个子任务查找一段连续的数据源, 按顺序合并时更早的子任务中的时间戳优先
+    std::vector<std::vector<Row>> results(tasks);
+    options_->query_executor_->Run(tasks, [&](size_t i) {
+        auto req = RangeQueryRequest(query.vin_, query.time_lower_bound_, query.time_upper_bound_, query.columns_,
+                                     &results[i]);
+        req.column_mask_ = query.column_mask_;
+        query_sources(source_count * i / tasks, source_count * (i + 1) / tasks, req);
+    });
+    for(auto &rows : results) {
+        for(auto &row : rows) {
+            if(query.time_set_.insert(row.timestamp).second) {
+                trReadRes.push_back(std::move(row));
+            }
+        }
+    }
+    return 0;
+}
+
+
+auto TableShard::MemTableRangeQuery(TableShard::RangeQueryRequest &req, const std::shared_ptr<MemTable>& mem) -> void {
+    auto iter = mem->NewIterator();
+    iter->Seek(req.lower_bound_);
+    CollectRangeRows(iter.get(), req);
+}
+
+auto TableShard::FileOverlapsRange(const FileMetaDataPtr &fileMetaData, const TableShard::RangeQueryRequest &req) -> bool {
+    if(fileMetaData->largest_ < req.lower_bound_ || req.upper_bound_ < fileMetaData->smallest_
+    || req.upper_bound_ == fileMetaData->smallest_) {
+        return false;
+    }
+
+    // 文件中的时间戳与查询范围不相交, time window compaction 时大部分文件在这里排除
+    return !(fileMetaData->max_timestamp_ < req.time_lower_bound_ || fileMetaData->min_timestamp_ >= req.time_upper_bound_);
+}
+
+void TableShard::FileTableRangeQuery(const FileMetaDataPtr& fileMetaData, TableShard::RangeQueryRequest &req) {
+    if(options_->use_bloom_filter_ && !table_cache_->MayContain(fileMetaData, req.vin_)) {
+        return;
+    }
+
+    // 只读取查询的列, 根据 zone map 直接定位到第一个满足条件的 block
+    auto iter = table_cache_->NewTableRangeIterator(fileMetaData, req.lower_bound_, req.upper_bound_, &req.column_mask_);
+    sstable_probe_count_.fetch_add(1, std::memory_order_relaxed);
+    iter->Seek(req.lower_bound_);
+    CollectRangeRows(iter.get(), req);
+}
+
+void TableShard::CollectRangeRows(Iterator *iter, TableShard::RangeQueryRequest &req) {
+    // [lower_bound_, upper_bound_] 内的 key 都属于 req.vin_, 时间戳位于 [time_lower_bound_, time_upper_bound_]
+    auto &batch = req.batch_;
+    while(true) {
+        batch.Clear();
+        if(iter->NextBatch(K_ROW_BATCH_SIZE, &req.upper_bound_, &batch) == 0) {
+            break;
+        }
+
+        for(size_t i = 0; i < batch.Size(); i++) {
+            auto timestamp = batch.timestamps_[i];
+            if(timestamp >= req.time_upper_bound_ || !req.time_set_.insert(timestamp).second) {
+                continue;
+            }
+            Row row;
+            batch.GetRow(i, schema_, &row);
+            req.result_->push_back(std::move(row));
+        }
+    }
+}
+
+
+void TableShard::MaybeScheduleCompaction() {
+    // 达到上限时由正在执行的 compaction 完成后继续调度
+    if(bg_compaction_scheduled_ >= options_->max_background_compactions_) {
+        return;
+    }
+
+    table_meta_data_.SetExpireTimestamp(GetExpireTimestamp());
+    if(table_meta_data_.ExistCompactionTask() && !is_shutting_down_.load(std::memory_order_acquire)) {
+        bg_compaction_scheduled_++;
+        options_->bg_task_->Schedule(&TableShard::BGWork, this);
+    }
+}
+
+void TableShard::BGWork(void *table) {
+    reinterpret_cast<TableShard*>(table)->BackgroundCall();
+}
+
+void TableShard::BackgroundCall() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto compacted = BackgroundCompaction(lock);
+    bg_compaction_scheduled_--;
+
+    // 没有可执行的计划时不再调度, 与之冲突的 compaction 完成后会重新调度
+    if(compacted) {
+        table_meta_data_.Finalize();
+        MaybeScheduleCompaction();
+    }
+}
+
+auto TableShard::BackgroundCompaction(std::unique_lock<std::mutex> &lock) -> bool {
+    // Minor Compaction
+//    if(!imm_.empty()) {
+//        // TODO(lieck) 假设存在多个 immtable 应该同时压缩
+//        auto compaction_mem = imm_[0];
+//        is_compaction_running_ = true;
+//        lock.unlock();
+//
+//        // 开始压缩
+//        auto file_meta = CompactMemTable(compaction_mem);
+//
+//        lock.lock();
+//        is_compaction_running_ = false;
+//        cv_.notify_all();
+//
+//        // 更新元数据
+//        imm_.erase(imm_.begin());
+//        table_meta_data_.AddFileMetaData(0, {file_meta});
+//        LOG_DEBUG("Minor Compaction Done");
+//        return;
+//    }
+
+    // 退出时只允许压缩 memtable
+    if(is_shutting_down_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    if(DropExpiredFiles(lock)) {
+        return true;
+    }
+
+    // Manual Compaction
+    auto task = flushing_sequences_.empty() ? table_meta_data_.GenerateCompactionTask()
+                                            : table_meta_data_.GenerateCompactionTask(*flushing_sequences_.begin());
+    if(task == nullptr) {
+        return false;
+    }
+
+    task->expire_timestamp_ = table_meta_data_.GetExpireTimestamp();
+
+    // 其它线程可以同时执行与 task 不冲突的 compaction
+    table_meta_data_.Finalize();
+    MaybeScheduleCompaction();
+
+    compaction_thread_count_++;
+    lock.unlock();
+
+    auto result = DoManualCompaction(task);
+
+    lock.lock();
+    compaction_thread_count_--;
+    cv_.notify_all();
+    table_meta_data_.ReleaseCompactionTask(task);
+
+    if(result) {
+        table_meta_data_.RemoveFileMetaData(task->level_, task->input_files_[0]);
+        table_meta_data_.RemoveFileMetaData(task->level_ + 1, task->input_files_[1]);
+        table_meta_data_.AddFileMetaData(task->output_level_, task->output_files_);
+
+        if(task->type_ == CompactionType::SeekCompaction) {
+            table_meta_data_.ClearCompaction();
+        }
+
+        VersionEdit edit;
+        for(int i = 0; i < 2; i++) {
+            for(auto &file : task->input_files_[i]) {
+                edit.deleted_files_.emplace_back(task->level_ + i, file->GetFileNumber());
+            }
+        }
+        for(auto &file : task->output_files_) {
+            edit.added_files_.emplace_back(task->output_level_, file);
+        }
+        auto logged = LogVersionEdit(edit);
+
+        if(task->need_delete_) {
+            for(auto &files : task->input_files_) {
+                for(auto &file : files) {
+                    RemoveObsoleteFile(file, logged);
+                }
+            }
+        }
+    }
+
+    // 释放对输入文件的引用, 不在锁内删除文件
+    lock.unlock();
+    delete task;
+    lock.lock();
+    return true;
+}
+
+auto TableShard::DropExpiredFiles(std::unique_lock<std::mutex> &lock) -> bool {
+    auto expired = table_meta_data_.GetExpiredFiles();
+    if(expired.empty()) {
+        return false;
+    }
+
+    VersionEdit edit;
+    for(auto &file : expired) {
+        table_meta_data_.RemoveFileMetaData(file.first, {file.second});
+        edit.deleted_files_.emplace_back(file.first, file.second->GetFileNumber());
+    }
+    auto logged = LogVersionEdit(edit);
+    for(auto &file : expired) {
+        RemoveObsoleteFile(file.second, logged);
+    }
+    table_meta_data_.Finalize();
+    LOG_INFO("drop %zu expired sstables, expire timestamp: %ld", expired.size(), table_meta_data_.GetExpireTimestamp());
+
+    lock.unlock();
+    expired.clear();
+    lock.lock();
+    return true;
+}
+
+void TableShard::RemoveObsoleteFile(const FileMetaDataPtr &file, bool logged) {
+    if(logged) {
+        // 查询与迭代器仍可能持有 FileMetaDataPtr, 最后一个引用释放时删除
+        file->MarkObsolete(options_->table_cache_);
+    } else if(options_->manifest_ == nullptr) {
+        // 元数据只能通过 WriteMetaData 持久化, 文件保留到 EraseSSTableFile
+        table_meta_data_.GetEraseFileQueue().push(file->GetFileNumber());
+    }
+}
+
+auto TableShard::DoManualCompaction(CompactionTask *task) -> bool {
+    LOG_DEBUG("DoManualCompaction level: %d", task->level_);
+
+    if(task->input_files_[1].empty() && task->output_level_ != task->level_) {
+        // input files[0] 不存在重叠
+        std::sort(task->input_files_[0].begin(), task->input_files_[0].end());
+
+        bool overwrite = true;
+        for(size_t i = 1; i < task->input_files_[0].size(); i++) {
+            if(task->input_files_[0][i - 1]->GetLargest() > task->input_files_[0][i]->GetSmallest()) {
+                overwrite = false;
+                break;
+            }
+        }
+
+        if(overwrite) {
+            task->output_files_ = task->input_files_[0];
+            task->need_delete_ = false;
+            LOG_DEBUG("DoManualCompaction level: %d, no need to compact", task->level_);
+            return true;
+        }
+    }
+
+    // 按 key 范围拆分为多个 subcompaction, 在后台线程池中并行执行, 输出文件按范围顺序拼接
+    auto boundaries = GetSubcompactionBoundaries(task);
+    std::vector<std::vector<FileMetaDataPtr>> outputs(boundaries.size() + 1);
+    options_->bg_task_->Run(outputs.size(), [this, task, &boundaries, &outputs](size_t i) {
+        auto lower = i > 0 ? &boundaries[i - 1] : nullptr;
+        auto upper = i < boundaries.size() ? &boundaries[i] : nullptr;
+        DoSubcompaction(task, lower, upper, &outputs[i]);
+    });
+
+    for(auto &output : outputs) {
+        task->output_files_.insert(task->output_files_.end(), output.begin(), output.end());
+    }
+    LOG_DEBUG("DoManualCompaction level: %d, subcompactions: %zu, output_files size: %zu", task->level_,
+              outputs.size(), task->output_files_.size());
+
+    return true;
+}
+
+auto TableShard::GetSubcompactionBoundaries(CompactionTask *task) -> std::vector<InternalKey> {
+    uint64_t total_size = 0;
+    for(auto &files : task->input_files_) {
+        for(auto &file : files) {
+            total_size += file->GetFileSize();
+        }
+    }
+
+    auto count = std::min<uint64_t>(options_->max_subcompactions_, total_size / K_MIN_SUBCOMPACTION_SIZE);
+    if(count <= 1) {
+        return {};
+    }
+
+    // 以输入文件中每个 block 的 key 作为候选, 每个范围包含数量相近的 block
+    std::vector<InternalKey> keys;
+    for(auto &files : task->input_files_) {
+        for(auto &file : files) {
+            table_cache_->GetBlockKeys(file, &keys);
+        }
+    }
+    if(keys.empty()) {
+        return {};
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<InternalKey> boundaries;
+    for(uint64_t i = 1; i < count; i++) {
+        auto &key = keys[keys.size() * i / count];
+        if(boundaries.empty() || boundaries.back() < key) {
+            boundaries.push_back(key);
+        }
+    }
+    return boundaries;
+}
+
+auto TableShard::NewCompactionInputIterator(CompactionTask *task) -> std::unique_ptr<Iterator> {
+    std::vector<std::unique_ptr<Iterator>> input_iters;
+    input_iters.reserve(2);
+
+    // 生成迭代器
+    for(size_t i = 0; i < 2; i++) {
+        if(task->level_ == 0 && i == 0) {
+            // L0 的文件之间存在重叠, 按编号从新到旧排列, 相同 key 时返回最新的版本
+            auto files = task->input_files_[i];
+            SortNewestFirst(&files);
+            std::vector<std::unique_ptr<Iterator>> iters;
+            for(auto &file : files) {
+                iters.emplace_back(table_cache_->NewTableIterator(file));
+            }
+            input_iters.push_back(NewMergingIterator(std::move(iters)));
+        } else if(!task->input_files_[i].empty()) {
+            auto file_iter = NewFileMetaDataIterator(task->input_files_[i]);
+            input_iters.push_back(NewTwoLevelIterator(std::move(file_iter), GetFileIterator, options_->table_cache_));
+        }
+    }
+
+    if(input_iters.size() >= 2) {
+        return NewMergingIterator(std::move(input_iters));
+    }
+    return std::move(input_iters[0]);
+}
+
+void TableShard::DoSubcompaction(CompactionTask *task, const InternalKey *lower, const InternalKey *upper,
+                                 std::vector<FileMetaDataPtr> *outputs) {
+    auto input_iter = NewCompactionInputIterator(task);
+    if(lower != nullptr) {
+        input_iter->Seek(*lower);
+    } else {
+        input_iter->SeekToFirst();
+    }
+
+    SStableBuilder *builder = nullptr;
+    FileMetaData *file_meta_data = nullptr;
+    InternalKey largest;
+    int64_t min_timestamp = INT64_MAX;
+    int64_t max_timestamp = -1;
+
+    // 输出文件与输入文件中最新的数据属于同一个 sorted run
+    file_number_t sequence = 0;
+    for(auto &files : task->input_files_) {
+        for(auto &file : files) {
+            sequence = std::max(sequence, file->sequence_);
+        }
+    }
+
+    // 写入当前的 sstable 并加入 outputs
+    auto finish_file = [&]() {
+        auto sstable = builder->Builder();
+        file_meta_data->largest_ = largest;
+        file_meta_data->file_size_ = sstable->GetFileSize();
+        file_meta_data->min_timestamp_ = min_timestamp;
+        file_meta_data->max_timestamp_ = max_timestamp;
+        outputs->emplace_back(file_meta_data);
+        compaction_bytes_written_.fetch_add(file_meta_data->file_size_, std::memory_order_relaxed);
+
+        if(options_->table_cache_ != nullptr) {
+            options_->table_cache_->AddSSTable(std::move(sstable));
+        }
+
+        delete builder;
+        builder = nullptr;
+    };
+
+    bool has_key = false;
+    uint64_t dropped = 0;
+    uint64_t expired = 0;
+    while(input_iter->Valid()) {
+        const auto &key = input_iter->GetKey();
+        if(upper != nullptr && !(key < *upper)) {
+            break;
+        }
+
+        // 相同 key 时 merging iterator 先返回更新的版本, 之后的版本已被覆盖
+        if(has_key && key == largest) {
+            dropped++;
+            input_iter->Next();
+            continue;
+        }
+        if(key.timestamp_ < task->expire_timestamp_) {
+            expired++;
+            input_iter->Next();
+            continue;
+        }
+        has_key = true;
+
+        if(builder != nullptr && builder->EstimatedSize() >= MAX_FILE_SIZE) {
+            finish_file();
+        }
+        if(builder == nullptr) {
+            auto file_number = options_->NextFileNumber();
+            builder = new SStableBuilder(file_number, options_->block_cache_, schema_, options_->use_direct_io_);
+            file_meta_data = new FileMetaData();
+            file_meta_data->file_number_ = file_number;
+            file_meta_data->smallest_ = key;
+            file_meta_data->sequence_ = sequence;
+            min_timestamp = INT64_MAX;
+            max_timestamp = -1;
+        }
+
+        largest = key;
+        min_timestamp = std::min(min_timestamp, key.timestamp_);
+        max_timestamp = std::max(max_timestamp, key.timestamp_);
+        auto value = input_iter->GetValue();
+        builder->Add(largest, value);
+
+        input_iter->Next();
+    }
+
+    if(builder != nullptr) {
+        finish_file();
+    }
+    if(dropped > 0) {
+        LOG_DEBUG("DoSubcompaction level: %d, dropped %lu shadowed versions", task->level_, dropped);
+    }
+    if(expired > 0) {
+        LOG_DEBUG("DoSubcompaction level: %d, dropped %lu expired rows", task->level_, expired);
+    }
+}
+
+
+void TableShard::StartMemTableCompaction(const std::shared_ptr<MemTable> mem) {
+    compaction_thread_count_++;
+
+    // 持有锁时分配编号, L0 中编号越大的文件数据越新
+    auto file_number = options_->NextFileNumber();
+    flushing_sequences_.insert(file_number);
+    std::thread([this, mem, file_number] {
+        auto files = CompactMemTable(mem, file_number);
+
+        std::scoped_lock<std::mutex> lock(mutex_);
+        compaction_thread_count_--;
+        ASSERT(compaction_thread_count_ >= 0, "compaction_thread_count should");
+        cv_.notify_all();
+
+        // 更新元数据
+        auto iter = std::find(imm_.begin(), imm_.end(), mem);
+        imm_.erase(iter);
+        mem_log_numbers_.erase(mem.get());
+        flushing_sequences_.erase(file_number);
+        table_meta_data_.AddFileMetaData(0, files);
+        table_meta_data_.Finalize();
+
+        VersionEdit edit;
+        for(auto &file : files) {
+            edit.added_files_.emplace_back(0, file);
+        }
+        LogVersionEdit(edit);
+    }).detach();
+}
+
+auto TableShard::LogVersionEdit(VersionEdit &edit) -> bool {
+    if(options_->manifest_ == nullptr) {
+        return false;
+    }
+
+    edit.shard_id_ = shard_id_;
+    edit.next_file_number_ = options_->next_file_number_.load(std::memory_order_acquire);
+    edit.log_number_ = GetMinLogNumber();
+    try {
+        options_->manifest_->LogEdit(table_name_, edit);
+    } catch (Exception &e) {
+        LOG_ERROR("write manifest_log failed : %s", e.what());
+        return false;
+    }
+
+    // edit 落盘后删除数据已经写入 sstable 的 WAL
+    log_number_ = edit.log_number_;
+    auto iter = std::remove_if(log_numbers_.begin(), log_numbers_.end(), [this](file_number_t log_number) {
+        if(log_number >= log_number_) {
+            return false;
+        }
+        DiskManager::RemoveFile(GET_LOG_NAME(log_number));
+        return true;
+    });
+    log_numbers_.erase(iter, log_numbers_.end());
+    return true;
+}
+
+auto TableShard::GetMinLogNumber() const -> file_number_t {
+    auto result = static_cast<file_number_t>(options_->next_file_number_.load(std::memory_order_acquire));
+    for(auto &mem_log_number : mem_log_numbers_) {
+        result = std::min(result, mem_log_number.second);
+    }
+    return result;
+}
+
+
+
+auto TableShard::CompactMemTable(const std::shared_ptr<MemTable> &mem, file_number_t file_number)
+        -> std::vector<FileMetaDataPtr> {
+    LOG_INFO("Compact MemTable table");
+
+    // 输出文件, time window compaction 时每个时间窗口一个文件, 同一次 flush 的文件 sequence 相同
+    struct Output {
+        std::unique_ptr<SStableBuilder> builder_;
+        file_number_t file_number_;
+        InternalKey smallest_;
+        InternalKey largest_;
+        int64_t min_timestamp_{INT64_MAX};
+        int64_t max_timestamp_{INT64_MIN};
+    };
+    std::map<int64_t, Output> outputs;
+
+    auto iter = mem->NewIterator();
+    iter->SeekToFirst();
+
+    InternalKey last_key;
+    bool has_key = false;
+    auto expire_timestamp = GetExpireTimestamp();
+
+    while(iter->Valid()) {
+        // 相同 key 按 sequence 降序, 只保留第一个即最新的版本
+        const auto &key = iter->GetKey();
+        if((has_key && key == last_key) || key.timestamp_ < expire_timestamp) {
+            iter->Next();
+            continue;
+        }
+        has_key = true;
+        last_key = key;
+
+        auto window = options_->compaction_style_ == TimeWindowCompaction ? key.timestamp_ / options_->time_window_size_ : 0;
+        auto &output = outputs[window];
+        if(output.builder_ == nullptr) {
+            output.file_number_ = outputs.size() == 1 ? file_number : options_->NextFileNumber();
+            output.builder_ = std::make_unique<SStableBuilder>(output.file_number_, options_->block_cache_, schema_,
+                                                              options_->use_direct_io_);
+            output.smallest_ = key;
+        }
+        output.largest_ = key;
+        output.min_timestamp_ = std::min(output.min_timestamp_, key.timestamp_);
+        output.max_timestamp_ = std::max(output.max_timestamp_, key.timestamp_);
+        output.builder_->Add(key, iter->GetValue());
+        iter->Next();
+    }
+
+    std::vector<FileMetaDataPtr> files;
+    for(auto &window : outputs) {
+        auto &output = window.second;
+        auto sstable = output.builder_->Builder();
+        files.push_back(std::make_shared<FileMetaData>(output.file_number_, output.smallest_, output.largest_,
+                                                       sstable->GetFileSize(), output.min_timestamp_,
+                                                       output.max_timestamp_, file_number));
+        table_cache_->AddSSTable(std::move(sstable));
+    }
+
+    return files;
+}
+
+auto TableShard::Shutdown() -> int {
+    LOG_INFO("Shutdown table");
+    is_shutting_down_.store(true, std::memory_order_release);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // 等待写入队列为空
+    while(!write_queue_.empty()) {
+        cv_.wait(lock);
+    }
+
+    if(mem_ != nullptr) {
+        auto mem_table = mem_;
+        imm_.push_back(mem_);
+        mem_ = nullptr;
+        StartMemTableCompaction(mem_table);
+    }
+    log_.reset();
+
+    // 等待压缩任务完成
+    while(compaction_thread_count_ > 0) {
+        cv_.wait(lock);
+    }
+
+    return 0;
+}
+
+    auto TableShard::WriteMetaData(std::ofstream &file) const -> void {
+        char buffer[FILE_META_DATA_SIZE];
+
+        // 写入的 latest index 包含所有已经生成的 sstable 中的数据
+        CodingUtil::PutUint32(buffer, log_number_);
+        file.write(buffer, CodingUtil::LENGTH_SIZE);
+        CodingUtil::PutUint32(buffer, options_->next_file_number_.load(std::memory_order_acquire));
+        file.write(buffer, CodingUtil::LENGTH_SIZE);
+
+        // file number
+        for(const auto& level : table_meta_data_.files_) {
+            CodingUtil::PutUint32(buffer, level.size());
+            file.write(buffer, CodingUtil::LENGTH_SIZE);
+
+            for(auto &file_meta_data : level) {
+                std::string str;
+                file_meta_data->EncodeTo(&str);
+                file.write(str.data(), FILE_META_DATA_SIZE);
+            }
+        }
+
+        latest_index_.WriteTo(file);
+    }
+
+    auto TableShard::ReadMetaData(std::ifstream &file, bool schedule_compaction) -> void {
+        char buffer[FILE_META_DATA_SIZE];
+
+        file.read(buffer, CodingUtil::LENGTH_SIZE);
+        log_number_ = CodingUtil::DecodeUint32(buffer);
+        file.read(buffer, CodingUtil::LENGTH_SIZE);
+        index_file_number_ = CodingUtil::DecodeUint32(buffer);
+
+        // file number
+        for(auto & i : table_meta_data_.files_) {
+            uint32_t file_size;
+            file.read(buffer, CodingUtil::LENGTH_SIZE);
+            file_size = CodingUtil::DecodeUint32(buffer);
+            for(uint32_t j = 0; j < file_size; j++) {
+                std::string temp;
+                temp.resize(FILE_META_DATA_SIZE);
+                file.read(temp.data(), FILE_META_DATA_SIZE);
+
+                i.emplace_back(std::make_shared<FileMetaData>(temp));
+                UpdateNewestTimestamp(i.back()->max_timestamp_);
+            }
+        }
+
+        latest_index_.ReadFrom(file);
+
+        if(schedule_compaction) {
+            ScheduleCompaction();
+        }
+    }
+
+    void TableShard::ScheduleCompaction() {
+        std::scoped_lock<std::mutex> lock(mutex_);
+        table_meta_data_.Finalize();
+        MaybeScheduleCompaction();
+    }
+
+    auto TableShard::ApplyVersionEdit(const VersionEdit &edit) -> void {
+        std::scoped_lock<std::mutex> lock(mutex_);
+        for(auto &file : edit.deleted_files_) {
+            table_meta_data_.RemoveFileMetaData(file.first, file.second);
+        }
+        for(auto &file : edit.added_files_) {
+            table_meta_data_.AddFileMetaData(file.first, {file.second});
+            UpdateNewestTimestamp(file.second->max_timestamp_);
+        }
+        log_number_ = std::max(log_number_, edit.log_number_);
+    }
+
+    auto TableShard::ApplyLatestIndex(file_number_t index_file_number) -> void {
+        // 之前记录的文件已经被删除, 只读取最后记录的文件, 见 RecoverLatestIndex
+        index_file_number_ = index_file_number;
+        latest_index_file_ = index_file_number;
+        // 文件编号可能大于 manifest 中记录的 next_file_number, 避免之后覆盖该文件
+        auto next_file_number = static_cast<int32_t>(index_file_number) + 1;
+        if(next_file_number > options_->next_file_number_.load(std::memory_order_acquire)) {
+            options_->next_file_number_.store(next_file_number, std::memory_order_release);
+        }
+    }
+
+    auto TableShard::RecoverLatestIndex() -> void {
+        // 最后记录的文件包含快照中 latest index 的所有 vin, 合并后与该文件相同
+        if(latest_index_file_ != 0) {
+            auto file = DiskManager::OpenFile(GET_LATEST_INDEX_NAME(latest_index_file_));
+            std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if(!latest_index_.DecodeFrom(data)) {
+                throw Exception(ExceptionType::IO, "corrupted latest index file " + std::to_string(latest_index_file_));
+            }
+        }
+
+        std::vector<FileMetaDataPtr> files;
+        {
+            std::scoped_lock<std::mutex> lock(mutex_);
+            for(auto &level : table_meta_data_.files_) {
+                for(auto &file : level) {
+                    if(file->GetFileNumber() >= index_file_number_) {
+                        files.push_back(file);
+                    }
+                }
+            }
+        }
+
+        // 每个 vin 的第一个 key 时间戳最大
+        for(auto &file : files) {
+            LOG_INFO("recover latest index from sstable %u", file->GetFileNumber());
+            auto iter = table_cache_->NewTableIterator(file);
+            iter->SeekToFirst();
+            bool first = true;
+            Vin last_vin;
+            while(iter->Valid()) {
+                const auto &key = iter->GetKey();
+                if(first || key.vin_ != last_vin) {
+                    latest_index_.Update(key.vin_, key.timestamp_, iter->GetValue());
+                    last_vin = key.vin_;
+                    first = false;
+                }
+                iter->Next();
+            }
+        }
+        index_file_number_ = options_->next_file_number_.load(std::memory_order_acquire);
+    }
+
+    auto TableShard::LogLatestIndex() -> void {
+        if(options_->manifest_ == nullptr) {
+            return;
+        }
+        // 编号同时作为 index_file_number_, 之后生成的 sstable 编号都不小于它
+        auto index_file_number = static_cast<file_number_t>(options_->NextFileNumber());
+        std::string data;
+        latest_index_.EncodeTo(&data);
+        auto fd = DiskManager::CreateAppendableFile(GET_LATEST_INDEX_NAME(index_file_number));
+        try {
+            DiskManager::AppendFile(fd, data.data(), data.size());
+            DiskManager::SyncFile(fd);
+        } catch (Exception &e) {
+            DiskManager::CloseFile(fd);
+            throw;
+        }
+        DiskManager::CloseFile(fd);
+
+        options_->manifest_->LogLatestIndex(table_name_, shard_id_, index_file_number);
+        if(latest_index_file_ != 0) {
+            DiskManager::RemoveFile(GET_LATEST_INDEX_NAME(latest_index_file_));
+        }
+        index_file_number_ = index_file_number;
+        latest_index_file_ = index_file_number;
+    }
+
+    void TableShard::EraseSSTableFile() {
+        auto q = table_meta_data_.GetEraseFileQueue();
+        while(!q.empty()) {
+            DiskManager::RemoveSSTableFile(q.front());
+            q.pop();
+        }
+    }
+
+
+
+
+}  // namespace LindormContest
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "disk/aligned_buffer.h"
+#include "common/config.h"
+
+namespace LindormContest {
+
+namespace {
+
+// 按 2 的幂划分大小, 每个大小保留有限个空闲缓冲区
+// 超过最大大小的缓冲区直接释放
+class AlignedBufferPool {
+public:
+    static constexpr size_t MIN_SIZE = K_DIRECT_IO_ALIGNMENT;
+    static constexpr int NUM_CLASSES = 10;  // 4KB ~ 2MB
+    static constexpr size_t MAX_FREE_PER_CLASS = 32;
+
+    static auto RoundUp(size_t size) -> size_t {
+        size_t capacity = MIN_SIZE;
+        while(capacity < size) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    auto Allocate(size_t capacity) -> char * {
+        auto index = ClassIndex(capacity);
+        if(index >= 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto &list = free_lists_[index];
+            if(!list.empty()) {
+                auto buffer = list.back();
+                list.pop_back();
+                return buffer;
+            }
+        }
+        void *buffer = nullptr;
+        if(::posix_memalign(&buffer, K_DIRECT_IO_ALIGNMENT, capacity) != 0) {
+            throw std::bad_alloc();
+        }
+        return reinterpret_cast<char *>(buffer);
+    }
+
+    void Free(char *buffer, size_t capacity) {
+        auto index = ClassIndex(capacity);
+        if(index >= 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto &list = free_lists_[index];
+            if(list.size() < MAX_FREE_PER_CLASS) {
+                list.push_back(buffer);
+                return;
+            }
+        }
+        std::free(buffer);
+    }
+
+private:
+    static auto ClassIndex(size_t capacity) -> int {
+        int index = 0;
+        for(size_t size = MIN_SIZE; size < capacity; size <<= 1) {
+            index++;
+        }
+        return index < NUM_CLASSES ? index : -1;
+    }
+
+    std::mutex mutex_;
+    std::vector<char *> free_lists_[NUM_CLASSES];
+};
+
+auto GetPool() -> AlignedBufferPool & {
+    // 不析构, 避免静态对象析构后仍有缓冲区归还
+    static auto pool = new AlignedBufferPool();
+    return *pool;
+}
+
+}  // namespace
+
+void AlignedBuffer::Reserve(size_t size) {
+    if(size <= capacity_) {
+        return;
+    }
+    Release();
+    auto capacity = AlignedBufferPool::RoundUp(size);
+    data_ = GetPool().Allocate(capacity);
+    capacity_ = capacity;
+}
+
+void AlignedBuffer::Release() {
+    if(data_ != nullptr) {
+        GetPool().Free(data_, capacity_);
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+}
+
+}  // namespace LindormContest
@@ -0,0 +1,323 @@
+#include "disk/async_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "common/logger.h"
+#include "disk/disk_manager.h"
+
+namespace LindormContest {
+
+// 直接通过系统调用使用 io_uring, 不依赖 liburing
+// 同一时刻只有一个批次使用 ring, 由 mutex_ 保证
+class IoUringIO : public AsyncIO {
+public:
+    ~IoUringIO() override {
+        if(sqes_ != nullptr) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if(cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if(sq_ring_ != nullptr) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if(ring_fd_ >= 0) {
+            ::close(ring_fd_);
+        }
+    }
+
+    // 初始化失败时返回 false
+    auto Init(uint32_t entries) -> bool {
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if(ring_fd_ < 0) {
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+
+        sq_ring_ = MapRing(sq_ring_size_, IORING_OFF_SQ_RING);
+        if(sq_ring_ == nullptr) {
+            return false;
+        }
+        cq_ring_ = single_mmap ? sq_ring_ : MapRing(cq_ring_size_, IORING_OFF_CQ_RING);
+        if(cq_ring_ == nullptr) {
+            return false;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = reinterpret_cast<io_uring_sqe *>(MapRing(sqes_size_, IORING_OFF_SQES));
+        if(sqes_ == nullptr) {
+            return false;
+        }
+
+        auto sq = reinterpret_cast<char *>(sq_ring_);
+        sq_tail_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+        sq_entries_ = params.sq_entries;
+
+        auto cq = reinterpret_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // 返回前收割本批次的所有完成事件, 出错时也不会留下内核仍在写入的缓冲区或残留的完成事件
+    void ReadBatch(std::vector<ReadRequest> &requests) override {
+        std::scoped_lock<std::mutex> lock(mutex_);
+
+        size_t next = 0;
+        uint32_t unsubmitted = 0;   // 已写入提交队列, 内核尚未接收
+        uint32_t in_flight = 0;     // 内核已接收, 尚未完成
+        uint32_t tail = *sq_tail_;
+        std::exception_ptr error = nullptr;
+        while(true) {
+            // 出错后不再提交新的请求, 只等待已提交的请求完成
+            while(error == nullptr && next < requests.size() && unsubmitted + in_flight < sq_entries_) {
+                auto &request = requests[next];
+                auto index = tail & sq_mask_;
+                auto sqe = &sqes_[index];
+                std::memset(sqe, 0, sizeof(io_uring_sqe));
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = request.fd_;
+                sqe->addr = reinterpret_cast<uint64_t>(request.data_);
+                sqe->len = request.size_;
+                sqe->off = request.offset_;
+                sqe->user_data = next;
+                sq_array_[index] = index;
+
+                tail++;
+                next++;
+                unsubmitted++;
+            }
+            if(unsubmitted + in_flight == 0) {
+                break;
+            }
+            __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+            // 提交并等待至少一个请求完成, 内核可能只接收部分请求, 剩余的下一轮重新提交
+            auto ret = ::syscall(__NR_io_uring_enter, ring_fd_, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if(ret < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                if(unsubmitted == 0) {
+                    // 无法等待内核中的请求完成, 返回后缓冲区会被释放
+                    LOG_ERROR("io_uring_enter failed while waiting for %u reads: %s", in_flight, strerror(errno));
+                    std::abort();
+                }
+                if(error == nullptr) {
+                    error = std::make_exception_ptr(
+                            Exception(ExceptionType::IO, std::string("io_uring_enter failed: ") + strerror(errno)));
+                }
+                // 撤回内核尚未接收的请求
+                tail -= unsubmitted;
+                unsubmitted = 0;
+                __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+                continue;
+            }
+            unsubmitted -= static_cast<uint32_t>(ret);
+            in_flight += static_cast<uint32_t>(ret);
+
+            // 收割完成队列
+            uint32_t head = *cq_head_;
+            while(head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                auto &cqe = cqes_[head & cq_mask_];
+                auto &request = requests[cqe.user_data];
+                auto res = cqe.res;
+                head++;
+                in_flight--;
+
+                // 读取失败或不完整时同步读取剩余部分, 仍然失败时记录异常, 所有请求完成后抛出
+                if(res < 0 || static_cast<uint32_t>(res) < request.size_) {
+                    auto done = res < 0 ? 0U : static_cast<uint32_t>(res);
+                    try {
+                        DiskManager::ReadBlock(request.fd_, request.data_ + done, request.size_ - done, request.offset_ + done);
+                    } catch(...) {
+                        if(error == nullptr) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+
+        if(error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    auto Name() const -> const char * override { return "io_uring"; }
+
+private:
+    auto MapRing(size_t size, off_t offset) -> void * {
+        void *ring = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    std::mutex mutex_;
+    int ring_fd_{-1};
+
+    void *sq_ring_{nullptr};
+    void *cq_ring_{nullptr};
+    io_uring_sqe *sqes_{nullptr};
+    size_t sq_ring_size_{0};
+    size_t cq_ring_size_{0};
+    size_t sqes_size_{0};
+
+    uint32_t *sq_tail_{nullptr};
+    uint32_t *sq_array_{nullptr};
+    uint32_t sq_mask_{0};
+    uint32_t sq_entries_{0};
+
+    uint32_t *cq_head_{nullptr};
+    uint32_t *cq_tail_{nullptr};
+    uint32_t cq_mask_{0};
+    io_uring_cqe *cqes_{nullptr};
+};
+
+// 使用固定数量的线程执行 pread
+class ThreadPoolIO : public AsyncIO {
+public:
+    explicit ThreadPoolIO(uint32_t thread_count) {
+        for(uint32_t i = 0; i < thread_count; i++) {
+            threads_.emplace_back(&ThreadPoolIO::WorkerMain, this);
+        }
+    }
+
+    ~ThreadPoolIO() override {
+        {
+            std::scoped_lock<std::mutex> lock(mutex_);
+            is_shutting_down_ = true;
+        }
+        cv_.notify_all();
+        for(auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void ReadBatch(std::vector<ReadRequest> &requests) override {
+        if(requests.empty()) {
+            return;
+        }
+
+        Batch batch;
+        batch.remaining_ = requests.size();
+        {
+            std::scoped_lock<std::mutex> lock(mutex_);
+            for(auto &request : requests) {
+                tasks_.push({&request, &batch});
+            }
+        }
+        cv_.notify_all();
+
+        std::unique_lock<std::mutex> lock(batch.mutex_);
+        batch.cv_.wait(lock, [&batch] { return batch.remaining_ == 0; });
+        if(batch.error_ != nullptr) {
+            std::rethrow_exception(batch.error_);
+        }
+    }
+
+    auto Name() const -> const char * override { return "thread pool"; }
+
+private:
+    struct Batch {
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        size_t remaining_{0};
+        std::exception_ptr error_{nullptr};
+    };
+
+    struct Task {
+        ReadRequest *request_;
+        Batch *batch_;
+    };
+
+    void WorkerMain() {
+        while(true) {
+            Task task{};
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return is_shutting_down_ || !tasks_.empty(); });
+                if(tasks_.empty()) {
+                    return;
+                }
+                task = tasks_.front();
+                tasks_.pop();
+            }
+
+            std::exception_ptr error = nullptr;
+            try {
+                auto request = task.request_;
+                DiskManager::ReadBlock(request->fd_, request->data_, request->size_, request->offset_);
+            } catch(...) {
+                error = std::current_exception();
+            }
+
+            auto batch = task.batch_;
+            std::scoped_lock<std::mutex> lock(batch->mutex_);
+            if(error != nullptr) {
+                batch->error_ = error;
+            }
+            if(--batch->remaining_ == 0) {
+                batch->cv_.notify_all();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::queue<Task> tasks_;
+    bool is_shutting_down_{false};
+    std::vector<std::thread> threads_;
+};
+
+auto AsyncIO::NewIoUring(uint32_t queue_depth) -> std::unique_ptr<AsyncIO> {
+    auto io = std::make_unique<IoUringIO>();
+    if(!io->Init(queue_depth)) {
+        return nullptr;
+    }
+    return io;
+}
+
+auto AsyncIO::NewThreadPool(uint32_t thread_count) -> std::unique_ptr<AsyncIO> {
+    return std::make_unique<ThreadPoolIO>(thread_count);
+}
+
+auto AsyncIO::Default() -> AsyncIO * {
+    static std::unique_ptr<AsyncIO> io = [] {
+        auto uring = NewIoUring(K_ASYNC_IO_QUEUE_DEPTH);
+        if(uring != nullptr) {
+            return uring;
+        }
+        LOG_INFO("io_uring is not supported, use pread thread pool");
+        return NewThreadPool(K_ASYNC_IO_THREADS);
+    }();
+    return io.get();
+}
+
+}  // namespace LindormContest
@@ -1,9 +1,16 @@
 
 #include <string>
 #include <fstream>
+#include <filesystem>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "disk/disk_manager.h"
 #include "common/exception.h"
 #include "common/macros.h"
+#include "common/logger.h"
 
 namespace LindormContest {
 
@@ -13,14 +20,27 @@ void SetDatabaseDirectory(const std::string &directory) {
     db_directory = directory;
 }
 
-auto DiskManager::CreateSSTableFile(file_number_t file_number) -> std::ofstream {
-    std::string file_name = GET_SSTABLE_NAME(file_number);
-    return CreakWritableFile(file_name);
+auto DiskManager::CreateSSTableFile(file_number_t file_number, bool direct_io) -> std::unique_ptr<FileWriter> {
+    return std::make_unique<FileWriter>(db_directory + GET_SSTABLE_NAME(file_number), direct_io);
 }
 
-auto DiskManager::OpenSSTableFile(file_number_t file_number) -> std::ifstream {
-    std::string file_name = GET_SSTABLE_NAME(file_number);
-    return OpenFile(file_name);
+auto DiskManager::OpenSSTableFile(file_number_t file_number, bool *direct_io) -> int {
+    std::string file_name = db_directory + GET_SSTABLE_NAME(file_number);
+    int fd = -1;
+    if(direct_io != nullptr && *direct_io) {
+        fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if(fd < 0 && errno == EINVAL) {
+            LOG_WARN("O_DIRECT is not supported for %s, fall back to buffered read", file_name.c_str());
+            *direct_io = false;
+        }
+    }
+    if(fd < 0) {
+        fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if(fd < 0) {
+        throw Exception(ExceptionType::IO, "Could not open file: " + file_name);
+    }
+    return fd;
 }
 
 auto DiskManager::CreakWritableFile(const std::string& filename) -> std::ofstream {
@@ -51,11 +71,23 @@ void DiskManager::ReadBlock(std::ifstream &file, char *data, uint32_t size, uint
     }
 }
 
-void DiskManager::WriteBlock(std::ofstream &file, const char *data, uint32_t size) {
-    file.write(data, size);
-    if(file.bad()) {
-        throw Exception(ExceptionType::IO, "I/O error while writing file");
+void DiskManager::ReadBlocks(std::vector<ReadRequest> &requests) {
+    if(requests.empty()) {
+        return;
     }
+    AsyncIO::Default()->ReadBatch(requests);
+}
+
+auto DiskManager::MapFile(int fd, uint64_t size) -> const char * {
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if(data == MAP_FAILED) {
+        throw Exception(ExceptionType::IO, std::string("Could not mmap file: ") + strerror(errno));
+    }
+    return reinterpret_cast<const char *>(data);
+}
+
+void DiskManager::UnmapFile(const char *data, uint64_t size) {
+    ::munmap(const_cast<char *>(data), size);
 }
 
 auto DiskManager::GetFileSize(std::ifstream &file) -> uint64_t {
@@ -67,9 +99,43 @@ auto DiskManager::GetFileSize(std::ifstream &file) -> uint64_t {
     return file_size;
 }
 
-void DiskManager::ReadBlock(file_number_t file_number, char *data, uint32_t size, uint32_t offset) {
-    std::ifstream file = OpenSSTableFile(file_number);
-    ReadBlock(file, data, size, offset);
+void DiskManager::ReadBlock(int fd, char *data, uint32_t size, uint64_t offset) {
+    while(size > 0) {
+        auto n = ::pread(fd, data, size, static_cast<off_t>(offset));
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw Exception(ExceptionType::IO, std::string("I/O error while reading file: ") + strerror(errno));
+        }
+        if(n == 0) {
+            throw Exception(ExceptionType::IO, "unexpected end of file while reading");
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+}
+
+auto DiskManager::ReadDirect(int fd, char *data, uint32_t size, uint64_t offset, uint32_t min_size) -> uint32_t {
+    uint32_t done = 0;
+    while(done < size) {
+        auto n = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw Exception(ExceptionType::IO, std::string("I/O error while reading file: ") + strerror(errno));
+        }
+        if(n == 0) {
+            break;
+        }
+        done += n;
+    }
+    if(done < min_size) {
+        throw Exception(ExceptionType::IO, "unexpected end of file while reading");
+    }
+    return done;
 }
 
 auto DiskManager::RemoveSSTableFile(file_number_t file_number) -> bool {
@@ -77,5 +143,79 @@ auto DiskManager::RemoveSSTableFile(file_number_t file_number) -> bool {
     return RemoveFile(file_name);
 }
 
+auto DiskManager::CreateAppendableFile(const std::string &filename) -> int {
+    int fd = ::open((db_directory + filename).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        throw Exception(ExceptionType::IO, "Could not create file: " + db_directory + filename);
+    }
+    SyncDirectory();
+    return fd;
+}
+
+auto DiskManager::OpenAppendableFile(const std::string &filename) -> int {
+    int fd = ::open((db_directory + filename).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        throw Exception(ExceptionType::IO, "Could not open file: " + db_directory + filename);
+    }
+    return fd;
+}
+
+void DiskManager::TruncateFile(const std::string &filename, uint64_t size) {
+    if(::truncate((db_directory + filename).c_str(), static_cast<off_t>(size)) != 0) {
+        throw Exception(ExceptionType::IO, std::string("I/O error while truncating file: ") + strerror(errno));
+    }
+}
+
+void DiskManager::RenameFile(const std::string &from, const std::string &to) {
+    if(::rename((db_directory + from).c_str(), (db_directory + to).c_str()) != 0) {
+        throw Exception(ExceptionType::IO, std::string("I/O error while renaming file: ") + strerror(errno));
+    }
+}
+
+void DiskManager::AppendFile(int fd, const char *data, size_t size) {
+    while(size > 0) {
+        auto n = ::write(fd, data, size);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw Exception(ExceptionType::IO, std::string("I/O error while appending file: ") + strerror(errno));
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+void DiskManager::SyncFile(int fd) {
+    if(::fdatasync(fd) != 0) {
+        throw Exception(ExceptionType::IO, std::string("I/O error while syncing file: ") + strerror(errno));
+    }
+}
+
+void DiskManager::SyncDirectory() {
+    int fd = ::open(db_directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0) {
+        throw Exception(ExceptionType::IO, "Could not open directory: " + db_directory);
+    }
+    auto result = ::fsync(fd);
+    ::close(fd);
+    if(result != 0) {
+        throw Exception(ExceptionType::IO, std::string("I/O error while syncing directory: ") + strerror(errno));
+    }
+}
+
+void DiskManager::CloseFile(int fd) {
+    ::close(fd);
+}
+
+auto DiskManager::GetChildren() -> std::vector<std::string> {
+    std::vector<std::string> result;
+    std::error_code ec;
+    for(auto &entry : std::filesystem::directory_iterator(db_directory, ec)) {
+        result.push_back(entry.path().filename().string());
+    }
+    return result;
+}
+
 
 }  // namespace LindormContest
\ No newline at end of file
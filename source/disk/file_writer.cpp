@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "disk/file_writer.h"
+#include "common/config.h"
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace LindormContest {
+
+static auto AlignUp(uint64_t value) -> uint64_t {
+    return (value + K_DIRECT_IO_ALIGNMENT - 1) & ~(static_cast<uint64_t>(K_DIRECT_IO_ALIGNMENT) - 1);
+}
+
+FileWriter::FileWriter(const std::string &filename, bool direct_io)
+    : filename_(filename), direct_io_(direct_io), buffer_(K_FILE_WRITER_BUFFER_SIZE) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if(direct_io_) {
+        fd_ = ::open(filename_.c_str(), flags | O_DIRECT, 0644);
+        // 文件系统不支持 O_DIRECT 时退回普通写入
+        if(fd_ < 0 && errno == EINVAL) {
+            LOG_WARN("O_DIRECT is not supported for %s, fall back to buffered write", filename_.c_str());
+            direct_io_ = false;
+        }
+    }
+    if(!direct_io_) {
+        fd_ = ::open(filename_.c_str(), flags, 0644);
+    }
+    if(fd_ < 0) {
+        throw Exception(ExceptionType::IO, "Could not create file: " + filename_);
+    }
+}
+
+FileWriter::~FileWriter() {
+    if(fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void FileWriter::Append(const char *data, size_t size) {
+    ASSERT(fd_ >= 0, "append to a closed file");
+    file_size_ += size;
+    while(size > 0) {
+        auto n = std::min(size, buffer_.GetCapacity() - buffer_used_);
+        memcpy(buffer_.GetData() + buffer_used_, data, n);
+        buffer_used_ += n;
+        data += n;
+        size -= n;
+        if(buffer_used_ == buffer_.GetCapacity()) {
+            WriteBuffer(buffer_used_);
+            buffer_used_ = 0;
+        }
+    }
+}
+
+void FileWriter::Close() {
+    if(fd_ < 0) {
+        return;
+    }
+    if(buffer_used_ > 0) {
+        if(direct_io_) {
+            // 补齐到对齐大小后写入, 再截断多写的部分
+            auto size = AlignUp(buffer_used_);
+            memset(buffer_.GetData() + buffer_used_, 0, size - buffer_used_);
+            WriteBuffer(size);
+            if(::ftruncate(fd_, static_cast<off_t>(file_size_)) != 0) {
+                throw Exception(ExceptionType::IO, std::string("I/O error while truncating file: ") + strerror(errno));
+            }
+        } else {
+            WriteBuffer(buffer_used_);
+        }
+        buffer_used_ = 0;
+    }
+    if(::fdatasync(fd_) != 0) {
+        throw Exception(ExceptionType::IO, std::string("I/O error while syncing file: ") + strerror(errno));
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void FileWriter::WriteBuffer(size_t size) {
+    const char *data = buffer_.GetData();
+    while(size > 0) {
+        auto n = ::pwrite(fd_, data, size, static_cast<off_t>(write_offset_));
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw Exception(ExceptionType::IO, std::string("I/O error while writing file: ") + strerror(errno));
+        }
+        data += n;
+        size -= n;
+        write_offset_ += n;
+    }
+}
+
+}  // namespace LindormContest
@@ -0,0 +1,52 @@
+#include "mem_table/arena.h"
+
+namespace LindormContest {
+
+Arena::~Arena() {
+    for(auto block : blocks_) {
+        delete[] block;
+    }
+}
+
+auto Arena::AllocateFallback(size_t bytes) -> char* {
+    if(bytes > BLOCK_SIZE / 4) {
+        // 较大的对象单独分配, 避免浪费当前 block 的剩余空间
+        return AllocateNewBlock(bytes);
+    }
+
+    alloc_ptr_ = AllocateNewBlock(BLOCK_SIZE);
+    alloc_bytes_remaining_ = BLOCK_SIZE;
+
+    char *result = alloc_ptr_;
+    alloc_ptr_ += bytes;
+    alloc_bytes_remaining_ -= bytes;
+    return result;
+}
+
+auto Arena::AllocateAligned(size_t bytes) -> char* {
+    constexpr size_t align = alignof(void*);
+    size_t current_mod = reinterpret_cast<uintptr_t>(alloc_ptr_) & (align - 1);
+    size_t slop = (current_mod == 0 ? 0 : align - current_mod);
+    size_t needed = bytes + slop;
+
+    char *result;
+    if(needed <= alloc_bytes_remaining_) {
+        result = alloc_ptr_ + slop;
+        alloc_ptr_ += needed;
+        alloc_bytes_remaining_ -= needed;
+    } else {
+        // new[] 返回的内存已满足对齐要求
+        result = AllocateFallback(bytes);
+    }
+    ASSERT((reinterpret_cast<uintptr_t>(result) & (align - 1)) == 0, "arena memory is not aligned");
+    return result;
+}
+
+auto Arena::AllocateNewBlock(size_t block_bytes) -> char* {
+    char *result = new char[block_bytes];
+    blocks_.push_back(result);
+    memory_usage_.fetch_add(block_bytes + sizeof(char*), std::memory_order_relaxed);
+    return result;
+}
+
+}  // namespace LindormContest
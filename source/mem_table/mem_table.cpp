@@ -3,63 +3,49 @@
 
 namespace LindormContest {
 
+auto MemTable::KeyComparator::operator()(const char *a, const char *b) const -> int {
+    auto r = std::strncmp(a, b, VIN_LENGTH);
+    if(r != 0) {
+        return r;
+    }
 
-auto MemTable::Insert(const Row& row) -> bool {
-    approximate_size_ += INTERNAL_KEY_SIZE;
-
-    // 计算 value length
-    uint32_t value_len = 0;
-    for(auto &col : row.columns) {
-        if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_DOUBLE_FLOAT) {
-            value_len += 8;
-        } else if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_INTEGER) {
-            value_len += 4;
-        } else if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_STRING) {
-            std::pair<int32_t, const char *> value;
-            if(col.second.getStringValue(value) != 0) {
-                return false;
-            }
-            value_len += 4 + value.first;
-        }
+    // 相同 vin 按时间戳降序
+    auto a_timestamp = CodingUtil::DecodeInt64(a + VIN_LENGTH);
+    auto b_timestamp = CodingUtil::DecodeInt64(b + VIN_LENGTH);
+    if(a_timestamp != b_timestamp) {
+        return a_timestamp > b_timestamp ? -1 : 1;
     }
 
-    ASSERT(value_len < UINT32_MAX, "value_len < UINT32_MAX");
+    // 相同 key 按 sequence 降序
+    auto a_sequence = CodingUtil::DecodeFixed64(a + INTERNAL_KEY_SIZE);
+    auto b_sequence = CodingUtil::DecodeFixed64(b + INTERNAL_KEY_SIZE);
+    if(a_sequence != b_sequence) {
+        return a_sequence > b_sequence ? -1 : 1;
+    }
+    return 0;
+}
 
+auto MemTable::Insert(const Row& row) -> bool {
     std::string str_value;
-    str_value.resize(value_len);
-    char *buffer = str_value.data();
-    int32_t buffer_offset = 0;
-
-    for(auto &col : row.columns) {
-        if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_DOUBLE_FLOAT) {
-            memcpy(buffer + buffer_offset, col.second.columnData, 8);
-            buffer_offset += 8;
-        } else if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_INTEGER) {
-            memcpy(buffer + buffer_offset, col.second.columnData, 4);
-            buffer_offset += 4;
-        } else if(col.second.getColumnType() == LindormContest::COLUMN_TYPE_STRING) {
-            std::pair<int32_t, const char *> value;
-            if(col.second.getStringValue(value) != 0) {
-                return false;
-            }
-
-            memcpy(buffer + buffer_offset, &value.first, 4);
-            buffer_offset += 4;
-
-            memcpy(buffer + buffer_offset, value.second, value.first);
-            buffer_offset += value.first;
-        } else {
-            return false;
-        }
+    if(!CodingUtil::EncodeRowValue(row, &str_value)) {
+        return false;
     }
+    ASSERT(str_value.size() < UINT32_MAX, "value_len < UINT32_MAX");
 
-    data_.emplace(InternalKey(row.vin, row.timestamp), str_value);
+    Insert(InternalKey(row.vin, row.timestamp), str_value);
     return true;
 }
 
-auto MemTable::Clear() -> void {
-    data_.clear();
-    approximate_size_ = 0;
+auto MemTable::Insert(const InternalKey &key, std::string_view value) -> void {
+    char *buffer = arena_.Allocate(ENTRY_HEADER_SIZE + value.size());
+    std::memcpy(buffer, key.vin_.vin, VIN_LENGTH);
+    CodingUtil::PutInt64(buffer + VIN_LENGTH, key.timestamp_);
+    CodingUtil::EncodeValue(buffer + INTERNAL_KEY_SIZE, ++sequence_);
+    CodingUtil::PutUint32(buffer + INTERNAL_KEY_SIZE + SEQUENCE_SIZE, value.size());
+    std::memcpy(buffer + ENTRY_HEADER_SIZE, value.data(), value.size());
+
+    table_.Insert(buffer);
+    approximate_size_.fetch_add(INTERNAL_KEY_SIZE, std::memory_order_relaxed);
 }
 
 auto MemTable::NewIterator() -> std::unique_ptr<Iterator> {
@@ -67,30 +53,56 @@ auto MemTable::NewIterator() -> std::unique_ptr<Iterator> {
 }
 
 void MemTable::MemTableIterator::SeekToFirst() {
-    iter_ = mem_table_->data_.begin();
+    iter_.SeekToFirst();
+    DecodeKey();
 }
 
 void MemTable::MemTableIterator::Seek(const InternalKey &key) {
-    iter_ = mem_table_->data_.lower_bound(key);
+    // sequence 最大, 定位到该 key 最新的版本
+    char buffer[INTERNAL_KEY_SIZE + SEQUENCE_SIZE];
+    std::memcpy(buffer, key.vin_.vin, VIN_LENGTH);
+    CodingUtil::PutInt64(buffer + VIN_LENGTH, key.timestamp_);
+    CodingUtil::EncodeValue(buffer + INTERNAL_KEY_SIZE, UINT64_MAX);
+    iter_.Seek(buffer);
+    DecodeKey();
 }
 
-auto MemTable::MemTableIterator::GetKey() -> InternalKey {
-    return iter_->first;
+auto MemTable::MemTableIterator::GetKey() -> const InternalKey & {
+    return key_;
 }
 
-auto MemTable::MemTableIterator::GetValue() -> std::string {
-    return iter_->second;
+auto MemTable::MemTableIterator::GetValue() -> std::string_view {
+    const char *entry = iter_.key();
+    auto value_size = CodingUtil::DecodeUint32(entry + INTERNAL_KEY_SIZE + SEQUENCE_SIZE);
+    return {entry + ENTRY_HEADER_SIZE, value_size};
 }
 
 auto MemTable::MemTableIterator::Valid() -> bool {
-    return iter_ != mem_table_->data_.end();
+    return iter_.Valid();
 }
 
 void MemTable::MemTableIterator::Next() {
-    ++iter_;
+    // 跳过被覆盖的旧版本
+    const char *prev = iter_.key();
+    iter_.Next();
+    while(iter_.Valid() && std::strncmp(prev, iter_.key(), VIN_LENGTH) == 0
+          && CodingUtil::DecodeInt64(prev + VIN_LENGTH) == CodingUtil::DecodeInt64(iter_.key() + VIN_LENGTH)) {
+        iter_.Next();
+    }
+    DecodeKey();
 }
 
+auto MemTable::MemTableIterator::NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t {
+    size_t count = 0;
+    while(count < n && iter_.Valid()) {
+        if(limit != nullptr && *limit < key_) {
+            break;
+        }
+        batch->AppendRow(key_, iter_.key() + ENTRY_HEADER_SIZE);
+        count++;
+        MemTableIterator::Next();
+    }
+    return count;
+}
 
-
-
-}  // namespace LindormContest
\ No newline at end of file
+}  // namespace LindormContest
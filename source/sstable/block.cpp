@@ -9,63 +9,124 @@ namespace LindormContest {
 
 auto Block::NewIterator() -> std::unique_ptr<Iterator> {
     ASSERT(block_magic_ == BLOCK_MAGIC, "Block magic number is not correct");
-    return std::make_unique<BlockIterator>(data_, size_, num_entries_);
+    return std::make_unique<BlockIterator>(data_, size_);
 }
 
-Block::Block(char *data, uint32_t size) : data_(data), size_(size) {
+Block::Block(char *data, uint32_t size, bool owned) : data_(data), size_(size), owned_(owned) {
     auto offset = size_ - CodingUtil::LENGTH_SIZE;
     num_entries_ = CodingUtil::DecodeUint32(data_ + offset);
 }
 
-Block::BlockIterator::BlockIterator(const char *data, uint32_t size, uint32_t num_entries)
-    : data_(data), num_entries_(num_entries) {
-    entry_array_ = reinterpret_cast<const uint32_t*>(data + size - CodingUtil::LENGTH_SIZE * (num_entries_ + 1));
-    curr_idx_ = 0;
+Block::BlockIterator::BlockIterator(const char *data, uint32_t size) : data_(data) {
+    num_restarts_ = CodingUtil::DecodeUint32(data + size - CodingUtil::LENGTH_SIZE * 2);
+    restarts_ = size - CodingUtil::LENGTH_SIZE * (num_restarts_ + 2);
+    current_ = restarts_;
+    next_ = restarts_;
+    SeekToFirst();
+}
+
+auto Block::BlockIterator::GetRestartPoint(uint32_t index) const -> uint32_t {
+    return CodingUtil::DecodeUint32(data_ + restarts_ + index * CodingUtil::LENGTH_SIZE);
+}
+
+void Block::BlockIterator::SeekToRestartPoint(uint32_t index) {
+    next_ = num_restarts_ == 0 ? restarts_ : GetRestartPoint(index);
+}
+
+auto Block::BlockIterator::ParseNextKey() -> bool {
+    current_ = next_;
+    if(current_ >= restarts_) {
+        return false;
+    }
+
+    const char *p = data_ + current_;
+    const char *limit = data_ + restarts_;
+    auto shared = static_cast<uint8_t>(p[0]);
+    auto non_shared = static_cast<uint8_t>(p[1]);
+    p += 2;
+    ASSERT(shared + non_shared == VIN_LENGTH, "corrupted block entry");
+    std::memcpy(key_.vin_.vin + shared, p, non_shared);
+    p += non_shared;
+
+    // 与前一个 entry 共享 vin 前缀时保存时间戳的差值, 否则保存完整的时间戳
+    uint64_t timestamp;
+    uint64_t value_size;
+    bool ok = CodingUtil::GetVarint64(&p, limit, &timestamp) && CodingUtil::GetVarint64(&p, limit, &value_size);
+    ASSERT(ok, "corrupted block entry");
+    auto delta = CodingUtil::ZigZagDecode(timestamp);
+    key_.timestamp_ = shared == 0 ? delta
+                                  : static_cast<int64_t>(static_cast<uint64_t>(key_.timestamp_) + static_cast<uint64_t>(delta));
+
+    value_ = p;
+    value_size_ = value_size;
+    next_ = static_cast<uint32_t>(p - data_) + value_size_;
+    return true;
 }
 
 void Block::BlockIterator::SeekToFirst() {
-    curr_idx_ = 0;
+    SeekToRestartPoint(0);
+    ParseNextKey();
 }
 
 void Block::BlockIterator::Seek(const InternalKey &key) {
-    auto cmp = [this](uint32_t offset, const InternalKey &key) -> bool {
-        InternalKey a(data_ + offset);
-        return a < key;
-    };
+    if(num_restarts_ == 0) {
+        current_ = restarts_;
+        return;
+    }
 
+    // 找到最后一个 key 小于目标的 restart point
     uint32_t l = 0;
-    uint32_t r = num_entries_ - 1;
+    uint32_t r = num_restarts_ - 1;
     while(l < r) {
-        uint32_t mid = (l + r) >> 1;
-        if(cmp(entry_array_[mid], key)) {
-            l = mid + 1;
+        uint32_t mid = (l + r + 1) >> 1;
+        SeekToRestartPoint(mid);
+        ParseNextKey();
+        if(key_ < key) {
+            l = mid;
         } else {
-            r = mid;
+            r = mid - 1;
         }
     }
 
-    curr_idx_ = l;
+    // 顺序查找第一个 >= key 的 entry
+    SeekToRestartPoint(l);
+    while(ParseNextKey()) {
+        if(!(key_ < key)) {
+            return;
+        }
+    }
 }
 
-auto Block::BlockIterator::GetKey() -> InternalKey {
-    auto offset = entry_array_[curr_idx_];
-    return InternalKey(data_ + offset);
+auto Block::BlockIterator::GetKey() -> const InternalKey & {
+    ASSERT(Valid(), "block iterator is invalid");
+    return key_;
 }
 
-auto Block::BlockIterator::GetValue() -> std::string {
-    auto offset = entry_array_[curr_idx_] + INTERNAL_KEY_SIZE;
-
-    auto value_size = CodingUtil::DecodeUint32(data_ + offset);
-    offset += CodingUtil::LENGTH_SIZE;
-    return {data_ + offset, value_size};
+auto Block::BlockIterator::GetValue() -> std::string_view {
+    ASSERT(Valid(), "block iterator is invalid");
+    return {value_, value_size_};
 }
 
 auto Block::BlockIterator::Valid() -> bool {
-    return curr_idx_ < num_entries_;
+    return current_ < restarts_;
 }
 
 auto Block::BlockIterator::Next() -> void {
-    curr_idx_++;
+    ASSERT(Valid(), "block iterator is invalid");
+    ParseNextKey();
+}
+
+auto Block::BlockIterator::NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t {
+    size_t count = 0;
+    while(count < n && Valid()) {
+        if(limit != nullptr && *limit < key_) {
+            break;
+        }
+        batch->AppendRow(key_, value_);
+        count++;
+        ParseNextKey();
+    }
+    return count;
 }
 
 
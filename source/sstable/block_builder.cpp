@@ -3,6 +3,7 @@
 #include <memory>
 #include "sstable/block_builder.h"
 #include "common/macros.h"
+#include "util/coding.h"
 
 
 namespace LindormContest {
@@ -15,35 +16,58 @@ auto BlockBuilder::Add(const InternalKey &key, std::string_view value) -> bool {
     if(data_ == nullptr) {
         return false;
     }
+    ASSERT(num_entries_ == 0 || last_key_ < key || last_key_ == key, "BlockBuilder::Add key must be increasing");
+
+    // restart point 处保存完整的 vin
+    bool restart = num_entries_ % RESTART_INTERVAL == 0;
+    uint32_t shared = 0;
+    if(!restart) {
+        while(shared < VIN_LENGTH && last_key_.vin_.vin[shared] == key.vin_.vin[shared]) {
+            shared++;
+        }
+    }
+
+    // 共享 vin 前缀时保存时间戳的差值, 否则保存完整的时间戳
+    int64_t delta = key.timestamp_;
+    if(shared != 0) {
+        delta = static_cast<int64_t>(static_cast<uint64_t>(key.timestamp_) - static_cast<uint64_t>(last_key_.timestamp_));
+    }
 
-    uint32_t size = INTERNAL_KEY_SIZE + value.size() + ENTRY_LENGTH_SIZE;
+    entry_.clear();
+    entry_.push_back(static_cast<char>(shared));
+    entry_.push_back(static_cast<char>(VIN_LENGTH - shared));
+    entry_.append(key.vin_.vin + shared, VIN_LENGTH - shared);
+    CodingUtil::PutVarint64(&entry_, CodingUtil::ZigZagEncode(delta));
+    CodingUtil::PutVarint64(&entry_, value.size());
 
+    uint32_t size = entry_.size() + value.size() + (restart ? CodingUtil::LENGTH_SIZE : 0);
     if(curr_size_ + size > capacity_) {
         return false;
     }
-    entry_offsets_.push_back(offset_);
-
-    // 将 key 写入 data_ 中
-    std::memcpy(data_ + offset_, key.Encode().data(), INTERNAL_KEY_SIZE);
-    offset_ += INTERNAL_KEY_SIZE;
 
-    // 将 value_size 和 value 写入 data_ 中
-    CodingUtil::PutUint32(data_ + offset_, value.size());
-    offset_ += CodingUtil::LENGTH_SIZE;
+    if(restart) {
+        restarts_.push_back(offset_);
+    }
+    std::memcpy(data_ + offset_, entry_.data(), entry_.size());
+    offset_ += entry_.size();
     std::memcpy(data_ + offset_, value.data(), value.size());
     offset_ += value.size();
 
+    last_key_ = key;
+    num_entries_++;
     curr_size_ += size;
     return true;
 }
 
 auto BlockBuilder::Builder() -> std::unique_ptr<Block> {
-    for(auto offset : entry_offsets_) {
+    for(auto offset : restarts_) {
         CodingUtil::PutUint32(data_ + offset_, offset);
         offset_ += CodingUtil::LENGTH_SIZE;
     }
 
-    CodingUtil::PutUint32(data_ + offset_, entry_offsets_.size());
+    CodingUtil::PutUint32(data_ + offset_, restarts_.size());
+    offset_ += CodingUtil::LENGTH_SIZE;
+    CodingUtil::PutUint32(data_ + offset_, num_entries_);
     offset_ += CodingUtil::LENGTH_SIZE;
 
     auto block = std::make_unique<Block>(data_, offset_);
@@ -56,7 +80,8 @@ auto BlockBuilder::Init() -> void {
     data_ = new char[capacity_];
     offset_ = 0;
     curr_size_ = INITIAL_SIZE;
-    entry_offsets_ = {};
+    num_entries_ = 0;
+    restarts_.clear();
 }
 
 }  // namespace ljdb
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include "sstable/row_group.h"
+#include "util/coding.h"
+
+namespace LindormContest {
+
+RowGroupIterator::RowGroupIterator(const std::vector<ColumnType> *column_types, const char *keys, uint32_t num_rows,
+                                   std::vector<const char *> columns)
+    : column_types_(column_types), keys_(keys), num_rows_(num_rows), columns_(std::move(columns)) {
+    column_offsets_.resize(columns_.size(), 0);
+}
+
+void RowGroupIterator::SeekToFirst() {
+    curr_idx_ = 0;
+}
+
+void RowGroupIterator::Seek(const InternalKey &key) {
+    uint32_t l = 0;
+    uint32_t r = num_rows_;
+    while(l < r) {
+        uint32_t mid = (l + r) >> 1;
+        if(InternalKey(keys_ + mid * INTERNAL_KEY_SIZE) < key) {
+            l = mid + 1;
+        } else {
+            r = mid;
+        }
+    }
+    curr_idx_ = l;
+}
+
+auto RowGroupIterator::GetKey() -> const InternalKey & {
+    ASSERT(Valid(), "iterator is invalid");
+    key_ = InternalKey(keys_ + curr_idx_ * INTERNAL_KEY_SIZE);
+    return key_;
+}
+
+auto RowGroupIterator::GetValue() -> std::string_view {
+    ASSERT(Valid(), "iterator is invalid");
+    PositionColumns();
+
+    auto &value = value_;
+    value.clear();
+    for(size_t i = 0; i < columns_.size(); i++) {
+        auto type = (*column_types_)[i];
+        if(columns_[i] != nullptr) {
+            auto p = columns_[i] + column_offsets_[i];
+            value.append(p, ColumnValueSize(type, p));
+        } else {
+            // 默认值: 0 或空字符串
+            value.append(type == COLUMN_TYPE_DOUBLE_FLOAT ? 8 : 4, '\0');
+        }
+    }
+    return value;
+}
+
+auto RowGroupIterator::Valid() -> bool {
+    return curr_idx_ < num_rows_;
+}
+
+auto RowGroupIterator::Next() -> void {
+    curr_idx_++;
+}
+
+auto RowGroupIterator::NextBatch(size_t n, const InternalKey *limit, ColumnBatch *batch) -> size_t {
+    ASSERT(batch->columns_.size() == columns_.size(), "batch does not match schema");
+    if(!Valid()) {
+        return 0;
+    }
+
+    // key 有序, 先二分查找范围的结束位置, 再按列整段复制
+    auto end = static_cast<uint32_t>(std::min<size_t>(num_rows_, curr_idx_ + n));
+    if(limit != nullptr) {
+        uint32_t l = curr_idx_;
+        uint32_t r = end;
+        while(l < r) {
+            uint32_t mid = (l + r) >> 1;
+            if(*limit < InternalKey(keys_ + mid * INTERNAL_KEY_SIZE)) {
+                r = mid;
+            } else {
+                l = mid + 1;
+            }
+        }
+        end = l;
+    }
+    auto count = end - curr_idx_;
+    if(count == 0) {
+        return 0;
+    }
+
+    for(uint32_t idx = curr_idx_; idx < end; idx++) {
+        batch->AppendKey(InternalKey(keys_ + idx * INTERNAL_KEY_SIZE));
+    }
+
+    PositionColumns();
+    for(size_t i = 0; i < columns_.size(); i++) {
+        auto &column = batch->columns_[i];
+        auto type = (*column_types_)[i];
+        if(columns_[i] == nullptr) {
+            for(uint32_t idx = 0; column.read_ && idx < count; idx++) {
+                column.AppendDefault();
+            }
+            continue;
+        }
+
+        const char *p = columns_[i] + column_offsets_[i];
+        if(type != COLUMN_TYPE_STRING) {
+            if(column.read_) {
+                column.AppendFixed(p, count);
+            }
+            column_offsets_[i] += count * ColumnValueSize(type, nullptr);
+            continue;
+        }
+        // string 列需要逐个移动, 未读取时也移动偏移, 保证所有列停在同一行
+        for(uint32_t idx = 0; idx < count; idx++) {
+            if(column.read_) {
+                column.Append(p);
+            }
+            p += ColumnValueSize(type, p);
+        }
+        column_offsets_[i] = static_cast<uint32_t>(p - columns_[i]);
+    }
+    curr_idx_ = end;
+    column_idx_ = end;
+    return count;
+}
+
+void RowGroupIterator::PositionColumns() {
+    if(column_idx_ > curr_idx_) {
+        column_idx_ = 0;
+        std::fill(column_offsets_.begin(), column_offsets_.end(), 0);
+    }
+
+    for(size_t i = 0; i < columns_.size(); i++) {
+        if(columns_[i] == nullptr) {
+            continue;
+        }
+        auto type = (*column_types_)[i];
+        if(type == COLUMN_TYPE_STRING) {
+            for(uint32_t idx = column_idx_; idx < curr_idx_; idx++) {
+                column_offsets_[i] += ColumnValueSize(type, columns_[i] + column_offsets_[i]);
+            }
+        } else {
+            column_offsets_[i] = curr_idx_ * ColumnValueSize(type, nullptr);
+        }
+    }
+    column_idx_ = curr_idx_;
+}
+
+}  // namespace LindormContest
@@ -1,9 +1,14 @@
 
 #include <algorithm>
+#include <cstring>
+#include <memory>
+#include <set>
 #include "snappy/snappy.h"
 
 #include "sstable/sstable.h"
 #include "util/coding.h"
+#include "codec/column_codec.h"
+#include "common/exception.h"
 #include "common/macros.h"
 #include "disk/disk_manager.h"
 #include "common/two_level_iterator.h"
@@ -12,68 +17,379 @@
 namespace LindormContest {
 
 
-SSTable::SSTable(file_number_t file_number, uint64_t file_size, Cache<Block> *cache) : file_number_(file_number), file_size_(file_size), cache_(cache) {
+SSTable::SSTable(file_number_t file_number, uint64_t file_size, Cache<Block> *cache, bool use_mmap, bool direct_io)
+    : file_number_(file_number), file_size_(file_size), direct_io_(direct_io),
+      fd_(DiskManager::OpenSSTableFile(file_number, &direct_io_)), cache_(cache) {
+    if(use_mmap && !direct_io_) {
+        mapped_data_ = DiskManager::MapFile(fd_, file_size_);
+    }
+
     // read sstable footer
-    char footer_buffer[SSTABLE_FOOTER_LENGTH];
+    AlignedBuffer footer_buffer;
     auto footer_offset = file_size_ - SSTABLE_FOOTER_LENGTH;
-    DiskManager::ReadBlock(file_number_, footer_buffer, SSTABLE_FOOTER_LENGTH, footer_offset);
+    auto footer = ReadRaw(footer_offset, SSTABLE_FOOTER_LENGTH, &footer_buffer);
 
-    // read sstable index block
-    auto index_offset = CodingUtil::DecodeUint32(footer_buffer);
-    auto index_block_size = footer_offset - index_offset;
+    // read sstable filter, index block and column types
+    auto filter_offset = CodingUtil::DecodeUint32(footer);
+    auto index_offset = CodingUtil::DecodeUint32(footer + CodingUtil::LENGTH_SIZE);
+    auto column_offset = CodingUtil::DecodeUint32(footer + CodingUtil::LENGTH_SIZE * 2);
+    auto index_block_size = column_offset - index_offset;
     ASSERT(index_block_size > 0, "index block size must be positive");
 
-    char *index_buffer = new char[index_block_size];
-    DiskManager::ReadBlock(file_number_, index_buffer, index_block_size, index_offset);
+    auto filter_size = index_offset - filter_offset;
+    auto meta_size = footer_offset - filter_offset;
+    AlignedBuffer meta_buffer;
+    auto meta = ReadRaw(filter_offset, meta_size, &meta_buffer);
+
+    filter_.assign(meta, filter_size);
+
+    // column types
+    for(auto p = meta + filter_size + index_block_size; p < meta + meta_size; p++) {
+        column_types_.push_back(static_cast<ColumnType>(*p));
+    }
+
+    // 映射文件时 index block 直接引用映射的内存
+    if(IsMapped()) {
+        index_block_ = std::make_unique<Block>(const_cast<char *>(meta + filter_size), index_block_size, false);
+    } else {
+        char *index_buffer = new char[index_block_size];
+        memcpy(index_buffer, meta + filter_size, index_block_size);
+        index_block_ = std::make_unique<Block>(index_buffer, index_block_size);
+    }
+}
+
+SSTable::~SSTable() {
+    // index block 可能引用映射的内存, 需要先释放
+    index_block_.reset();
+    if(IsMapped()) {
+        DiskManager::UnmapFile(mapped_data_, file_size_);
+    }
+    DiskManager::CloseFile(fd_);
+}
+
+static auto AlignDown(uint64_t value) -> uint64_t {
+    return value & ~(static_cast<uint64_t>(K_DIRECT_IO_ALIGNMENT) - 1);
+}
 
-    index_block_ = std::make_unique<Block>(index_buffer, index_block_size);
+static auto AlignUp(uint64_t value) -> uint64_t {
+    return AlignDown(value + K_DIRECT_IO_ALIGNMENT - 1);
 }
 
-auto SSTable::NewIterator() -> std::unique_ptr<Iterator> {
+auto SSTable::ReadRaw(uint64_t offset, uint32_t size, AlignedBuffer *scratch) const -> const char * {
+    ASSERT(offset + size <= file_size_, "read out of sstable");
+    if(IsMapped()) {
+        return mapped_data_ + offset;
+    }
+    if(direct_io_) {
+        // 文件末尾不是对齐的, 只要求读到 offset + size
+        auto begin = AlignDown(offset);
+        auto length = static_cast<uint32_t>(AlignUp(offset + size) - begin);
+        scratch->Reserve(length);
+        DiskManager::ReadDirect(fd_, scratch->GetData(), length, begin, offset + size - begin);
+        return scratch->GetData() + (offset - begin);
+    }
+    scratch->Reserve(size);
+    DiskManager::ReadBlock(fd_, scratch->GetData(), size, offset);
+    return scratch->GetData();
+}
+
+auto SSTable::NewIterator(const ColumnMask *column_mask) -> std::unique_ptr<Iterator> {
     auto index_iterator = index_block_->NewIterator();
-    return NewTwoLevelIterator(std::move(index_iterator), ReadBlock, this);
+    if(!IsColumnar()) {
+        return NewTwoLevelIterator(std::move(index_iterator), ReadBlock, this);
+    }
+
+    auto arg = new RowGroupReadArg{this, column_mask != nullptr ? *column_mask : ColumnMask(column_types_.size(), true)};
+    auto iter = NewTwoLevelIterator(std::move(index_iterator), ReadRowGroup, arg);
+    iter->RegisterCleanup([](void *arg, void *) { delete reinterpret_cast<RowGroupReadArg *>(arg); }, arg, nullptr);
+    return iter;
 }
 
-auto SSTable::ReadBlock(void *arg, const std::string &key) -> std::unique_ptr<Iterator> {
+// 根据 zone map 过滤 index block 的迭代器
+// 第一个 key 大于 upper 的 block 之后不再有需要的 key, 直接结束;
+// lower 与 upper 属于同一个 vin 时, 只包含该 vin 且时间戳范围不相交的 block 也会被跳过
+class ZoneMapIndexIterator : public Iterator {
+public:
+    ZoneMapIndexIterator(std::unique_ptr<Iterator> index_iter, const InternalKey &lower, const InternalKey &upper)
+        : index_iter_(std::move(index_iter)), lower_(lower), upper_(upper) {}
+
+    auto SeekToFirst() -> void override {
+        index_iter_->SeekToFirst();
+        SkipBlocks();
+    }
+
+    void Seek(const InternalKey &key) override {
+        index_iter_->Seek(key);
+        SkipBlocks();
+    }
+
+    auto GetKey() -> const InternalKey & override { return index_iter_->GetKey(); }
+
+    auto GetValue() -> std::string_view override { return index_iter_->GetValue(); }
+
+    auto Valid() -> bool override { return !done_ && index_iter_->Valid(); }
+
+    auto Next() -> void override {
+        index_iter_->Next();
+        SkipBlocks();
+    }
+
+private:
+    void SkipBlocks() {
+        done_ = false;
+        while(index_iter_->Valid()) {
+            const auto &end_key = index_iter_->GetKey();
+            ZoneMap zone_map(index_iter_->GetValue());
+            if(upper_ < zone_map.first_key_) {
+                done_ = true;
+                return;
+            }
+
+            bool single_vin = lower_.vin_ == upper_.vin_ && zone_map.first_key_.vin_ == lower_.vin_ && end_key.vin_ == lower_.vin_;
+            if(!single_vin || (zone_map.max_timestamp_ >= upper_.timestamp_ && zone_map.min_timestamp_ <= lower_.timestamp_)) {
+                return;
+            }
+            index_iter_->Next();
+        }
+    }
+
+    std::unique_ptr<Iterator> index_iter_;
+    InternalKey lower_;
+    InternalKey upper_;
+    bool done_{false};
+};
+
+auto SSTable::NewRangeIterator(const InternalKey &lower, const InternalKey &upper,
+                               const ColumnMask *column_mask) -> std::unique_ptr<Iterator> {
+    auto index_iterator = std::make_unique<ZoneMapIndexIterator>(index_block_->NewIterator(), lower, upper);
+    if(!IsColumnar()) {
+        return NewTwoLevelIterator(std::move(index_iterator), ReadBlock, this);
+    }
+
+    auto arg = new RowGroupReadArg{this, column_mask != nullptr ? *column_mask : ColumnMask(column_types_.size(), true)};
+    auto iter = NewTwoLevelIterator(std::move(index_iterator), ReadRowGroup, arg);
+    iter->RegisterCleanup([](void *arg, void *) { delete reinterpret_cast<RowGroupReadArg *>(arg); }, arg, nullptr);
+    return iter;
+}
+
+auto SSTable::ReadBlock(void *arg, std::string_view key) -> std::unique_ptr<Iterator> {
     auto *sstable = reinterpret_cast<SSTable *>(arg);
     BlockHeader block_header(key);
 
+    CacheHandle<Block> *handle;
+    auto block = sstable->LoadBlock(block_header.offset_, block_header.size_, K_DATA_BLOCK, &handle);
+    auto iter = block->NewIterator();
+    sstable->RegisterBlockCleanup(iter.get(), block, handle);
+    return iter;
+}
+
+auto SSTable::ReadRowGroup(void *arg, std::string_view key) -> std::unique_ptr<Iterator> {
+    auto read_arg = reinterpret_cast<RowGroupReadArg *>(arg);
+    auto sstable = read_arg->sstable_;
+    auto column_count = sstable->column_types_.size();
+    ASSERT(key.size() == CodingUtil::FIXED_64_SIZE + CodingUtil::LENGTH_SIZE * (column_count + 1) + ZoneMap::SIZE,
+           "invalid row group index");
+
+    std::vector<std::pair<Block *, CacheHandle<Block> *>> blocks;
+
+    // key chunk
+    uint64_t offset = CodingUtil::DecodeFixed64(key.data());
+    const char *p = key.data() + CodingUtil::FIXED_64_SIZE;
+    uint32_t size = CodingUtil::DecodeUint32(p);
+    p += CodingUtil::LENGTH_SIZE;
+
+    CacheHandle<Block> *handle;
+    auto key_block = sstable->LoadBlock(offset, size, K_KEY_CHUNK, &handle);
+    blocks.emplace_back(key_block, handle);
+    offset += size;
+
+    // 只读取需要的列
+    std::vector<const char *> columns(column_count, nullptr);
+    for(size_t i = 0; i < column_count; i++) {
+        size = CodingUtil::DecodeUint32(p);
+        p += CodingUtil::LENGTH_SIZE;
+        if(read_arg->column_mask_[i]) {
+            auto column_block = sstable->LoadBlock(offset, size, static_cast<int>(i), &handle);
+            blocks.emplace_back(column_block, handle);
+            columns[i] = column_block->GetData();
+        }
+        offset += size;
+    }
+
+    auto iter = std::make_unique<RowGroupIterator>(&sstable->column_types_, key_block->GetData(),
+                                                   key_block->GetEntrySize(), std::move(columns));
+    for(auto &block : blocks) {
+        sstable->RegisterBlockCleanup(iter.get(), block.first, block.second);
+    }
+    return iter;
+}
+
+auto SSTable::LoadBlock(uint64_t offset, uint64_t size, int column, CacheHandle<Block> **handle) -> Block * {
     // 读取 cache
-    if(sstable->cache_ != nullptr) {
-        auto cache_id = sstable->GetBlockCacheID(block_header.offset_);
-        auto handle = sstable->cache_->Lookup(cache_id);
-        if(handle != nullptr) {
-            auto iter = handle->value_->NewIterator();
-            iter->RegisterCleanup(IteratorCleanupBlockCache, sstable->cache_, handle);
-            return iter;
+    if(cache_ != nullptr) {
+        *handle = cache_->Lookup(GetBlockCacheID(offset));
+        if(*handle != nullptr) {
+            return (*handle)->value_.get();
         }
     }
 
     // cache 不存在, 从磁盘中读取
-    char *disk_buffer = new char[block_header.size_];
-    DiskManager::ReadBlock(sstable->file_number_, disk_buffer, block_header.size_, block_header.offset_);
+    block_read_count_.fetch_add(1, std::memory_order_relaxed);
+    AlignedBuffer disk_buffer;
+    auto raw = ReadRaw(offset, size, &disk_buffer);
+    auto block = DecodeBlock(raw, size, column);
 
-    // 解压
-    std::string uncompressed;
-    snappy::Uncompress(disk_buffer, block_header.size_, &uncompressed);
-    delete[] disk_buffer;
+    if(cache_ != nullptr) {
+        // 插入到 cache 中, 当前引用计数为1, 按解码后的大小计费
+        *handle = cache_->Insert(GetBlockCacheID(offset), std::unique_ptr<Block>(block), block->GetDataSize());
+    } else {
+        *handle = nullptr;
+    }
+    return block;
+}
 
-    char *block_buffer = new char[uncompressed.size()];
-    std::copy(uncompressed.begin(), uncompressed.end(), block_buffer);
+void SSTable::CollectPrefetch(const std::vector<Vin> &vins, const ColumnMask *column_mask,
+                              std::vector<BlockPrefetch> *prefetches) {
+    if(cache_ == nullptr || IsMapped()) {
+        return;
+    }
 
-    auto block = new Block(block_buffer, uncompressed.size());
-    auto iter = block->NewIterator();
+    std::set<uint64_t> offsets;
+    auto add_block = [&](uint64_t offset, uint32_t size, int column) {
+        if(!offsets.insert(offset).second) {
+            return;
+        }
+        auto handle = cache_->Lookup(GetBlockCacheID(offset));
+        if(handle != nullptr) {
+            cache_->Release(handle);
+            return;
+        }
+
+        if(!direct_io_) {
+            BlockPrefetch prefetch{this, offset, size, column, AlignedBuffer(size), 0, {}};
+            prefetch.request_ = ReadRequest{fd_, prefetch.buffer_.GetData(), size, offset};
+            prefetches->push_back(std::move(prefetch));
+            return;
+        }
+
+        // O_DIRECT 按对齐范围读取, 超出文件末尾的 block 读取时会读不满, 留给 LoadBlock 读取
+        auto begin = AlignDown(offset);
+        auto end = AlignUp(offset + size);
+        if(end > file_size_) {
+            return;
+        }
+        auto length = static_cast<uint32_t>(end - begin);
+        BlockPrefetch prefetch{this, offset, size, column, AlignedBuffer(length), static_cast<uint32_t>(offset - begin), {}};
+        prefetch.request_ = ReadRequest{fd_, prefetch.buffer_.GetData(), length, begin};
+        prefetches->push_back(std::move(prefetch));
+    };
+
+    auto index_iter = index_block_->NewIterator();
+    for(auto &vin : vins) {
+        index_iter->Seek(InternalKey(vin, MAX_TIMESTAMP));
+        if(!index_iter->Valid()) {
+            continue;
+        }
+
+        auto value = index_iter->GetValue();
+        if(!IsColumnar()) {
+            BlockHeader header(value);
+            add_block(header.offset_, header.size_, K_DATA_BLOCK);
+            continue;
+        }
+
+        // row group 的 key chunk 与需要读取的 column chunk
+        uint64_t offset = CodingUtil::DecodeFixed64(value.data());
+        const char *p = value.data() + CodingUtil::FIXED_64_SIZE;
+        uint32_t size = CodingUtil::DecodeUint32(p);
+        add_block(offset, size, K_KEY_CHUNK);
+        offset += size;
+        for(size_t i = 0; i < column_types_.size(); i++) {
+            p += CodingUtil::LENGTH_SIZE;
+            size = CodingUtil::DecodeUint32(p);
+            if(column_mask == nullptr || (*column_mask)[i]) {
+                add_block(offset, size, static_cast<int>(i));
+            }
+            offset += size;
+        }
+    }
+}
+
+void SSTable::InstallPrefetch(BlockPrefetch &prefetch) {
+    ASSERT(prefetch.sstable_ == this, "prefetch belongs to another sstable");
+    block_read_count_.fetch_add(1, std::memory_order_relaxed);
+    auto block = DecodeBlock(prefetch.buffer_.GetData() + prefetch.skip_, prefetch.size_, prefetch.column_);
+    auto handle = cache_->Insert(GetBlockCacheID(prefetch.offset_), std::unique_ptr<Block>(block), block->GetDataSize());
+    cache_->Release(handle);
+}
+
+void SSTable::EvictBlocks() {
+    if(cache_ == nullptr) {
+        return;
+    }
+
+    auto index_iter = index_block_->NewIterator();
+    for(index_iter->SeekToFirst(); index_iter->Valid(); index_iter->Next()) {
+        auto value = index_iter->GetValue();
+        if(!IsColumnar()) {
+            cache_->Erase(GetBlockCacheID(BlockHeader(value).offset_));
+            continue;
+        }
 
-    if(sstable->cache_ != nullptr) {
-        // 插入到 cache 中, 当前引用计数为1
-        auto cache_id = sstable->GetBlockCacheID(block_header.offset_);
-        auto handle = sstable->cache_->Insert(cache_id, std::unique_ptr<Block>(block), 1);
-        iter->RegisterCleanup(IteratorCleanupBlockCache, sstable->cache_, handle);
+        // row group 的 key chunk 与每一列的 column chunk
+        uint64_t offset = CodingUtil::DecodeFixed64(value.data());
+        const char *p = value.data() + CodingUtil::FIXED_64_SIZE;
+        for(size_t i = 0; i <= column_types_.size(); i++) {
+            cache_->Erase(GetBlockCacheID(offset));
+            offset += CodingUtil::DecodeUint32(p);
+            p += CodingUtil::LENGTH_SIZE;
+        }
+    }
+}
+
+void SSTable::GetBlockKeys(std::vector<InternalKey> *keys) const {
+    auto index_iter = index_block_->NewIterator();
+    for(index_iter->SeekToFirst(); index_iter->Valid(); index_iter->Next()) {
+        keys->push_back(index_iter->GetKey());
+    }
+}
+
+auto SSTable::DecodeBlock(const char *raw, uint64_t size, int column) -> Block * {
+    // 先得到解码后的长度, 直接解码到 block 持有的 buffer 中
+    size_t length;
+    bool ok;
+    if(column == K_DATA_BLOCK) {
+        ok = snappy::GetUncompressedLength(raw, size, &length);
+    } else if(column == K_KEY_CHUNK) {
+        ok = ColumnCodec::GetKeyChunkLength(raw, size, &length);
     } else {
-        iter->RegisterCleanup(IteratorCleanupBlock, nullptr, block);
+        ok = ColumnCodec::GetColumnChunkLength(column_types_[column], raw, size, &length);
     }
 
-    return iter;
+    std::unique_ptr<char[]> block_buffer;
+    if(ok) {
+        block_buffer.reset(new char[length]);
+        if(column == K_DATA_BLOCK) {
+            ok = snappy::RawUncompress(raw, size, block_buffer.get());
+        } else if(column == K_KEY_CHUNK) {
+            ok = ColumnCodec::DecodeKeyChunk(raw, size, block_buffer.get(), length);
+        } else {
+            ok = ColumnCodec::DecodeColumnChunk(column_types_[column], raw, size, block_buffer.get(), length);
+        }
+    }
+    if(!ok) {
+        throw Exception(ExceptionType::IO, "corrupted block in sstable " + std::to_string(file_number_));
+    }
+
+    return new Block(block_buffer.release(), length);
+}
+
+void SSTable::RegisterBlockCleanup(Iterator *iter, Block *block, CacheHandle<Block> *handle) {
+    if(handle != nullptr) {
+        iter->RegisterCleanup(IteratorCleanupBlockCache, cache_, handle);
+    } else {
+        iter->RegisterCleanup(IteratorCleanupBlock, nullptr, block);
+    }
 }
 
 auto SSTable::GetBlockCacheID(block_id_t block_id) -> cache_id_t {
@@ -81,4 +397,4 @@ auto SSTable::GetBlockCacheID(block_id_t block_id) -> cache_id_t {
 }
 
 
-}  // namespace LindormContest
\ No newline at end of file
+}  // namespace LindormContest
@@ -3,11 +3,30 @@
 #include "common/macros.h"
 #include "common/exception.h"
 #include "util/coding.h"
+#include "codec/column_codec.h"
+#include "util/bloom.h"
 
 namespace LindormContest {
 
-auto SStableBuilder::Add(const InternalKey &key, std::string &value) -> void {
+SStableBuilder::SStableBuilder(file_number_t file_number, Cache<Block> *block_cache, const Schema &schema, bool direct_io,
+                               int bloom_bits_per_key, uint32_t row_group_size)
+    : file_number_(file_number), direct_io_(direct_io), file_(DiskManager::CreateSSTableFile(file_number, direct_io)),
+      block_cache_(block_cache),
+      block_builder_(SSTABLE_BLOCK_CAPACITY), row_group_size_(row_group_size), bloom_bits_per_key_(bloom_bits_per_key) {
+    for(auto &column : schema.columnTypeMap) {
+        column_types_.push_back(column.second);
+    }
+    column_chunks_.resize(column_types_.size());
+}
+
+auto SStableBuilder::Add(const InternalKey &key, std::string_view value) -> void {
     ASSERT(end_key_ < key || end_key_ == key, "SStableBuilder::Add key must be increasing");
+    AddFilterKey(key);
+    if(!column_types_.empty()) {
+        AddToRowGroup(key, value);
+        return;
+    }
+
     if(!block_builder_.Add(key, value)) {
         FlushBlock();
 
@@ -21,9 +40,19 @@ auto SStableBuilder::Add(const InternalKey &key, std::string &value) -> void {
     }
 
     end_key_ = key;
+    zone_map_.Add(key);
     estimated_size_ += INTERNAL_KEY_SIZE + value.size() + 8;
 }
 
+auto SStableBuilder::AddFilterKey(const InternalKey &key) -> void {
+    if(bloom_bits_per_key_ <= 0) {
+        return;
+    }
+    if(filter_keys_.empty() || end_key_.vin_ != key.vin_) {
+        filter_keys_.append(key.vin_.vin, VIN_LENGTH);
+    }
+}
+
 auto SStableBuilder::FlushBlock() -> void {
     if(!block_builder_.Empty()) {
         auto block = block_builder_.Builder();
@@ -35,12 +64,13 @@ auto SStableBuilder::FlushBlock() -> void {
         // 压缩并写入
         std::string compressed;
         snappy::Compress(block->GetData(), block->GetDataSize(), &compressed);
-        DiskManager::WriteBlock(file_, compressed.data(), compressed.size());
+        file_->Append(compressed.data(), compressed.size());
 
         auto block_id = offset_;
 
         // update block meta
-        block_meta_.emplace_back(offset_, compressed.size(), end_key_);
+        block_meta_.emplace_back(offset_, compressed.size(), end_key_, zone_map_);
+        zone_map_ = ZoneMap();
         offset_ += compressed.size();
 
         // block cache
@@ -54,43 +84,153 @@ auto SStableBuilder::FlushBlock() -> void {
     }
 }
 
+auto SStableBuilder::AddToRowGroup(const InternalKey &key, std::string_view value) -> void {
+    if(row_group_rows_ > 0 && row_group_bytes_ + value.size() + INTERNAL_KEY_SIZE > row_group_size_) {
+        FlushRowGroup();
+        estimated_size_ += 8 + INTERNAL_KEY_SIZE;
+    }
+
+    // 将整行拆分到各列
+    key_chunk_.append(key.Encode());
+    const char *p = value.data();
+    for(size_t i = 0; i < column_types_.size(); i++) {
+        auto size = ColumnValueSize(column_types_[i], p);
+        ASSERT(p + size <= value.data() + value.size(), "row value does not match schema");
+        column_chunks_[i].append(p, size);
+        p += size;
+    }
+    row_group_rows_++;
+    row_group_bytes_ += INTERNAL_KEY_SIZE + value.size();
+
+    end_key_ = key;
+    zone_map_.Add(key);
+    estimated_size_ += INTERNAL_KEY_SIZE + value.size() + 8;
+}
+
+auto SStableBuilder::WriteChunk(std::string &chunk, int column) -> uint32_t {
+    char buffer[CodingUtil::LENGTH_SIZE];
+    CodingUtil::PutUint32(buffer, row_group_rows_);
+    chunk.append(buffer, CodingUtil::LENGTH_SIZE);
+
+    // 每个 chunk 单独选择编码方式
+    std::string compressed;
+    if(column < 0) {
+        ColumnCodec::EncodeKeyChunk(chunk, &compressed);
+    } else {
+        ColumnCodec::EncodeColumnChunk(column_types_[column], chunk, &compressed);
+    }
+    file_->Append(compressed.data(), compressed.size());
+
+    // block cache
+    if(block_cache_ != nullptr) {
+        auto chunk_size = static_cast<uint32_t>(chunk.size());
+        char *data = new char[chunk_size];
+        std::copy(chunk.begin(), chunk.end(), data);
+        auto bh = block_cache_->Insert(GetBlockCacheID(offset_), std::make_unique<Block>(data, chunk_size), chunk_size);
+        block_cache_->Release(bh);
+    }
+
+    offset_ += compressed.size();
+    chunk.clear();
+    return compressed.size();
+}
+
+auto SStableBuilder::FlushRowGroup() -> void {
+    if(row_group_rows_ == 0) {
+        return;
+    }
+
+    // index value: | offset (8) | key chunk size (4) | column chunk size (4) | ... |
+    std::string index_value(CodingUtil::FIXED_64_SIZE + CodingUtil::LENGTH_SIZE * (column_types_.size() + 1), '\0');
+    auto group_offset = offset_;
+    CodingUtil::EncodeValue(index_value.data(), static_cast<uint64_t>(offset_));
+
+    char *p = index_value.data() + CodingUtil::FIXED_64_SIZE;
+    CodingUtil::PutUint32(p, WriteChunk(key_chunk_, -1));
+    for(size_t i = 0; i < column_chunks_.size(); i++) {
+        p += CodingUtil::LENGTH_SIZE;
+        CodingUtil::PutUint32(p, WriteChunk(column_chunks_[i], static_cast<int>(i)));
+    }
+
+    block_meta_.emplace_back(group_offset, offset_ - group_offset, end_key_, zone_map_);
+    zone_map_ = ZoneMap();
+    row_group_index_.push_back(std::move(index_value));
+    row_group_rows_ = 0;
+    row_group_bytes_ = 0;
+}
+
 auto SStableBuilder::Builder() -> std::unique_ptr<SSTable> {
     FlushBlock();
+    FlushRowGroup();
+
+    // write filter
+    std::string filter;
+    if(!filter_keys_.empty()) {
+        std::vector<std::string_view> keys;
+        keys.reserve(filter_keys_.size() / VIN_LENGTH);
+        for(size_t i = 0; i < filter_keys_.size(); i += VIN_LENGTH) {
+            keys.emplace_back(filter_keys_.data() + i, VIN_LENGTH);
+        }
+        BloomFilter::CreateFilter(keys, bloom_bits_per_key_, &filter);
+        file_->Append(filter.data(), filter.size());
+    }
+    auto filter_offset = offset_;
+    offset_ += filter.size();
 
     // calculate index block size
     uint32_t size = block_meta_.size() * (BlockBuilder::ENTRY_LENGTH_SIZE + BLOCK_HEADER_SIZE  +
-            INTERNAL_KEY_SIZE) + 400;
+            INTERNAL_KEY_SIZE + CodingUtil::LENGTH_SIZE * (column_types_.size() + 1) + ZoneMap::SIZE) + 400;
 
     // write index block
     BlockBuilder builder(size);
     builder.Init();
 
     char buffer[BLOCK_HEADER_SIZE];
-    for(auto &meta : block_meta_) {
-        BlockHeader value(meta.offset_, meta.size_);
-        value.EncodeTo(buffer);
+    std::string value;
+    for(size_t i = 0; i < block_meta_.size(); i++) {
+        auto &meta = block_meta_[i];
+        if(column_types_.empty()) {
+            BlockHeader header(meta.offset_, meta.size_);
+            header.EncodeTo(buffer);
+            value.assign(buffer, BLOCK_HEADER_SIZE);
+        } else {
+            value = row_group_index_[i];
+        }
+        meta.zone_map_.EncodeTo(&value);
 
-        if(!builder.Add(meta.end_key_, std::string_view(buffer, BLOCK_HEADER_SIZE))) {
+        if(!builder.Add(meta.end_key_, value)) {
             throw Exception("SStableBuilder failed to add");
         }
     }
 
     auto index_block = builder.Builder();
-    DiskManager::WriteBlock(file_, index_block->GetData(), index_block->GetDataSize());
+    file_->Append(index_block->GetData(), index_block->GetDataSize());
     ASSERT(index_block->GetDataSize() > 0, "index block size must be greater than 0");
 
-    // write meta block offset
-    CodingUtil::PutUint32(buffer, offset_);
+    // write column types
+    auto index_offset = offset_;
     offset_ += index_block->GetDataSize();
+    auto column_offset = offset_;
+    for(auto type : column_types_) {
+        buffer[0] = static_cast<char>(type);
+        file_->Append(buffer, 1);
+    }
+    offset_ += column_types_.size();
 
-    DiskManager::WriteBlock(file_, buffer, CodingUtil::LENGTH_SIZE);
-    offset_ += CodingUtil::LENGTH_SIZE;
+    // write footer
+    CodingUtil::PutUint32(buffer, filter_offset);
+    CodingUtil::PutUint32(buffer + CodingUtil::LENGTH_SIZE, index_offset);
+    CodingUtil::PutUint32(buffer + CodingUtil::LENGTH_SIZE * 2, column_offset);
+    file_->Append(buffer, SSTABLE_FOOTER_LENGTH);
+    offset_ += SSTABLE_FOOTER_LENGTH;
 
-    file_.flush();
-    file_.close();
+    // 文件内容与目录项落盘后才能写入 manifest_log 并删除 WAL
+    file_->Close();
+    DiskManager::SyncDirectory();
 
     estimated_size_ = 0;
-    return std::make_unique<SSTable>(file_number_, offset_, std::move(index_block), block_cache_);
+    return std::make_unique<SSTable>(file_number_, offset_, std::move(index_block), block_cache_, std::move(column_types_),
+                                    std::move(filter), direct_io_);
 }
 
 auto SStableBuilder::GetBlockCacheID(block_id_t block_id) -> cache_id_t {
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "codec/column_codec.h"
+#include "sstable/row_group.h"
+#include "util/coding.h"
+#include "test_util.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 生成未编码的 chunk: | values | num rows |
+    template<typename T>
+    static auto MakeFixedChunk(const std::vector<T> &values) -> std::string {
+        std::string chunk;
+        char buffer[sizeof(T)];
+        for(auto value : values) {
+            CodingUtil::EncodeValue(buffer, value);
+            chunk.append(buffer, sizeof(T));
+        }
+        CodingUtil::PutUint32(buffer, values.size());
+        chunk.append(buffer, CodingUtil::LENGTH_SIZE);
+        return chunk;
+    }
+
+    static auto MakeStringChunk(const std::vector<std::string> &values) -> std::string {
+        std::string chunk;
+        char buffer[CodingUtil::LENGTH_SIZE];
+        for(auto &value : values) {
+            CodingUtil::PutUint32(buffer, value.size());
+            chunk.append(buffer, CodingUtil::LENGTH_SIZE);
+            chunk.append(value);
+        }
+        CodingUtil::PutUint32(buffer, values.size());
+        chunk.append(buffer, CodingUtil::LENGTH_SIZE);
+        return chunk;
+    }
+
+    static auto MakeKeyChunk(const std::vector<InternalKey> &keys) -> std::string {
+        std::string chunk;
+        for(auto &key : keys) {
+            chunk.append(key.Encode());
+        }
+        char buffer[CodingUtil::LENGTH_SIZE];
+        CodingUtil::PutUint32(buffer, keys.size());
+        chunk.append(buffer, CodingUtil::LENGTH_SIZE);
+        return chunk;
+    }
+
+    static void CheckRoundTrip(ColumnType type, CodecType codec, const std::string &chunk) {
+        std::string encoded;
+        ASSERT_TRUE(ColumnCodec::EncodeColumnChunk(type, codec, chunk, &encoded));
+        std::string decoded;
+        ASSERT_TRUE(ColumnCodec::DecodeColumnChunk(type, encoded.data(), encoded.size(), &decoded));
+        ASSERT_EQ(decoded, chunk);
+
+        // 直接解码到预先分配的 buffer 中, 长度不符时返回 false
+        size_t length;
+        ASSERT_TRUE(ColumnCodec::GetColumnChunkLength(type, encoded.data(), encoded.size(), &length));
+        ASSERT_EQ(length, chunk.size());
+        std::string buffer(length, '\0');
+        ASSERT_TRUE(ColumnCodec::DecodeColumnChunk(type, encoded.data(), encoded.size(), buffer.data(), length));
+        ASSERT_EQ(buffer, chunk);
+        ASSERT_FALSE(ColumnCodec::DecodeColumnChunk(type, encoded.data(), encoded.size(), buffer.data(), length - 1));
+    }
+
+    // 各编码方式的正确性, 包括边界值
+    TEST(ColumnCodecTest, RoundTrip) {
+        std::vector<int32_t> ints{0, 1, -1, std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(), 42};
+        for(int i = 0; i < 1000; i++) {
+            ints.push_back(rand() - RAND_MAX / 2);
+        }
+        for(auto codec : {CodecType::SNAPPY, CodecType::DELTA_VARINT}) {
+            CheckRoundTrip(COLUMN_TYPE_INTEGER, codec, MakeFixedChunk(ints));
+            CheckRoundTrip(COLUMN_TYPE_INTEGER, codec, MakeFixedChunk(std::vector<int32_t>{}));
+        }
+
+        std::vector<double> doubles{0.0, -0.0, 1.5, std::numeric_limits<double>::infinity(), std::nan(""),
+                                    std::numeric_limits<double>::denorm_min(), 1.5, 1.5};
+        for(int i = 0; i < 1000; i++) {
+            doubles.push_back(static_cast<double>(rand()) / 7.0);
+        }
+        for(auto codec : {CodecType::SNAPPY, CodecType::GORILLA}) {
+            CheckRoundTrip(COLUMN_TYPE_DOUBLE_FLOAT, codec, MakeFixedChunk(doubles));
+            CheckRoundTrip(COLUMN_TYPE_DOUBLE_FLOAT, codec, MakeFixedChunk(std::vector<double>{3.25}));
+        }
+
+        std::vector<std::string> strings{"", "a", "", "running", "running", "running", "idle"};
+        for(int i = 0; i < 1000; i++) {
+            strings.push_back("state_" + std::to_string(rand() % 5));
+        }
+        for(auto codec : {CodecType::SNAPPY, CodecType::DICTIONARY_RLE}) {
+            CheckRoundTrip(COLUMN_TYPE_STRING, codec, MakeStringChunk(strings));
+        }
+
+        // 不适用的编码方式
+        std::string encoded;
+        ASSERT_FALSE(ColumnCodec::EncodeColumnChunk(COLUMN_TYPE_INTEGER, CodecType::GORILLA, MakeFixedChunk(ints), &encoded));
+
+        std::vector<InternalKey> keys;
+        for(int v = 0; v < 20; v++) {
+            for(int64_t t = 100; t > 0; t--) {
+                keys.emplace_back(GenerateVin(v), t * 1000 + (t % 3 == 0 ? -7 : 0));
+            }
+        }
+        keys.emplace_back(GenerateVin(100), std::numeric_limits<int64_t>::max());
+        keys.emplace_back(GenerateVin(101), std::numeric_limits<int64_t>::min());
+        auto key_chunk = MakeKeyChunk(keys);
+        std::string key_encoded;
+        ColumnCodec::EncodeKeyChunk(key_chunk, &key_encoded);
+        ASSERT_EQ(static_cast<CodecType>(key_encoded[0]), CodecType::KEY_DELTA);
+        std::string key_decoded;
+        ASSERT_TRUE(ColumnCodec::DecodeKeyChunk(key_encoded.data(), key_encoded.size(), &key_decoded));
+        ASSERT_EQ(key_decoded, key_chunk);
+
+        // 截断的数据
+        std::string decoded;
+        ASSERT_FALSE(ColumnCodec::DecodeKeyChunk(key_encoded.data(), key_encoded.size() / 2, &decoded));
+    }
+
+    // 车联网数据下各编码方式与 snappy 的压缩率和解码速度
+    TEST(ColumnCodecTest, CompressionBenchmark) {
+        const int rows = 4096;
+
+        std::vector<InternalKey> keys;
+        std::vector<int32_t> speeds;
+        std::vector<double> temperatures;
+        std::vector<std::string> states;
+        int32_t speed = 60;
+        double temperature = 36.5;
+        for(int i = 0; i < rows; i++) {
+            // 每辆车 64 行, 时间戳间隔 1s, 倒序
+            keys.emplace_back(GenerateVin(i / 64), 1700000000000LL - (i % 64) * 1000);
+            speed = std::max(0, speed + rand() % 5 - 2);
+            speeds.push_back(speed);
+            temperature += (rand() % 3 - 1) * 0.5;
+            temperatures.push_back(temperature);
+            states.emplace_back(i % 200 < 150 ? "driving" : "parking");
+        }
+
+        struct Case {
+            const char *name_;
+            ColumnType type_;
+            CodecType codec_;
+            std::string chunk_;
+        };
+        std::vector<Case> cases{
+            {"timestamp", COLUMN_TYPE_UNINITIALIZED, CodecType::KEY_DELTA, MakeKeyChunk(keys)},
+            {"int", COLUMN_TYPE_INTEGER, CodecType::DELTA_VARINT, MakeFixedChunk(speeds)},
+            {"double", COLUMN_TYPE_DOUBLE_FLOAT, CodecType::GORILLA, MakeFixedChunk(temperatures)},
+            {"string", COLUMN_TYPE_STRING, CodecType::DICTIONARY_RLE, MakeStringChunk(states)},
+        };
+
+        for(auto &c : cases) {
+            for(auto codec : {CodecType::SNAPPY, c.codec_}) {
+                std::string encoded;
+                ASSERT_TRUE(ColumnCodec::EncodeColumnChunk(c.type_, codec, c.chunk_, &encoded));
+
+                const int loops = 50;
+                std::string decoded;
+                auto start_time = std::chrono::high_resolution_clock::now();
+                for(int i = 0; i < loops; i++) {
+                    ASSERT_TRUE(ColumnCodec::DecodeColumnChunk(c.type_, encoded.data(), encoded.size(), &decoded));
+                }
+                auto end_time = std::chrono::high_resolution_clock::now();
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+                ASSERT_EQ(decoded, c.chunk_);
+
+                LOG_INFO("%-9s codec = %d, ratio = %.2f, decode = %.2f GB/s", c.name_, static_cast<int>(codec),
+                         static_cast<double>(c.chunk_.size()) / static_cast<double>(encoded.size()),
+                         static_cast<double>(c.chunk_.size()) * loops / static_cast<double>(duration));
+            }
+
+            // 采样选择的编码方式应当是专用编码
+            ASSERT_EQ(ColumnCodec::ChooseCodec(c.type_, c.chunk_), c.codec_) << c.name_;
+        }
+    }
+
+} // namespace LindormContest
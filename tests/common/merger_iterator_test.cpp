@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include "common/merger_iterator.h"
+#include "common/logger.h"
+#include "mem_table/mem_table.h"
+#include "test_util.h"
+
+namespace LindormContest {
+
+    // 将 row_count 个有序的 key 轮流插入 fan_in 个 memtable
+    static auto GenerateChildren(int fan_in, int row_count, std::vector<std::unique_ptr<MemTable>> *mems,
+                                 std::vector<InternalKey> *keys) -> std::vector<std::unique_ptr<Iterator>> {
+        for(int i = 0; i < fan_in; i++) {
+            mems->emplace_back(std::make_unique<MemTable>());
+        }
+        for(int i = 0; i < row_count; i++) {
+            InternalKey key(GenerateVin(i / 16), 15 - i % 16);
+            (*mems)[i % fan_in]->Insert(key, std::to_string(i));
+            keys->push_back(key);
+        }
+        std::sort(keys->begin(), keys->end());
+
+        std::vector<std::unique_ptr<Iterator>> children;
+        for(auto &mem : *mems) {
+            children.emplace_back(mem->NewIterator());
+        }
+        return children;
+    }
+
+    TEST(MergingIteratorTest, MergeAndSeek) {
+        std::vector<std::unique_ptr<MemTable>> mems;
+        std::vector<InternalKey> keys;
+        auto iter = NewMergingIterator(GenerateChildren(7, 1000, &mems, &keys));
+
+        size_t count = 0;
+        for(iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            ASSERT_TRUE(iter->GetKey() == keys[count]);
+            count++;
+        }
+        ASSERT_EQ(count, keys.size());
+
+        iter->Seek(keys[500]);
+        for(size_t i = 500; i < keys.size(); i++) {
+            ASSERT_TRUE(iter->Valid());
+            ASSERT_TRUE(iter->GetKey() == keys[i]);
+            iter->Next();
+        }
+        ASSERT_FALSE(iter->Valid());
+
+        auto empty = NewMergingIterator({});
+        empty->SeekToFirst();
+        ASSERT_FALSE(empty->Valid());
+    }
+
+    // 多个 children 包含相同的 key 时先返回靠前的 child
+    TEST(MergingIteratorTest, EqualKeysInChildOrder) {
+        std::vector<std::unique_ptr<MemTable>> mems;
+        std::vector<std::unique_ptr<Iterator>> children;
+        for(int i = 0; i < 5; i++) {
+            mems.emplace_back(std::make_unique<MemTable>());
+            for(int key = 0; key < 10; key++) {
+                mems.back()->Insert(InternalKey(GenerateVin(key), 0), std::to_string(i));
+            }
+            children.emplace_back(mems.back()->NewIterator());
+        }
+
+        auto iter = NewMergingIterator(std::move(children));
+        iter->SeekToFirst();
+        for(int key = 0; key < 10; key++) {
+            for(int i = 0; i < 5; i++) {
+                ASSERT_TRUE(iter->Valid());
+                ASSERT_TRUE(iter->GetKey() == InternalKey(GenerateVin(key), 0));
+                ASSERT_EQ(iter->GetValue(), std::to_string(i));
+                iter->Next();
+            }
+        }
+        ASSERT_FALSE(iter->Valid());
+    }
+
+    // 归并吞吐量随 children 数量的变化, 与 compaction 一样每行读取 key 与 value
+    TEST(MergingIteratorTest, FanInThroughput) {
+        const int row_count = 1 << 18;
+
+        for(int fan_in : {2, 4, 8, 16, 32, 64}) {
+            std::vector<std::unique_ptr<MemTable>> mems;
+            std::vector<InternalKey> keys;
+            auto iter = NewMergingIterator(GenerateChildren(fan_in, row_count, &mems, &keys));
+
+            auto start_time = std::chrono::high_resolution_clock::now();
+            size_t count = 0;
+            size_t value_size = 0;
+            for(iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                auto key = iter->GetKey();
+                value_size += iter->GetValue().size() + key.timestamp_;
+                count++;
+            }
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+            LOG_INFO("fan-in = %d, rows = %zu, time = %ld us, throughput = %.2f M rows/s", fan_in, count, duration,
+                     static_cast<double>(count) / static_cast<double>(duration));
+            ASSERT_EQ(count, static_cast<size_t>(row_count));
+            ASSERT_GT(value_size, 0);
+        }
+    }
+
+} // namespace LindormContest
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "db/background.h"
+
+namespace LindormContest {
+
+    // 后台任务中再拆分子任务, 所有线程都忙时不会死锁, 同时执行的任务数量不超过线程池大小
+    TEST(BackgroundTaskTest, NestedRun) {
+        const int thread_count = 2;
+        const int task_count = 4;
+        auto bg_task = new BackgroundTask(thread_count);
+
+        std::atomic<int> running{0};
+        std::atomic<int> max_running{0};
+        std::vector<std::vector<std::atomic<int>>> runs(task_count);
+        for(auto &task_runs : runs) {
+            task_runs = std::vector<std::atomic<int>>(8);
+        }
+
+        struct Arg {
+            BackgroundTask *bg_task_;
+            std::atomic<int> *running_;
+            std::atomic<int> *max_running_;
+            std::vector<std::atomic<int>> *runs_;
+        };
+        std::vector<Arg> args;
+        for(int i = 0; i < task_count; i++) {
+            args.push_back({bg_task, &running, &max_running, &runs[i]});
+        }
+
+        for(auto &arg : args) {
+            bg_task->Schedule([](void *p) {
+                auto arg = reinterpret_cast<Arg *>(p);
+                arg->bg_task_->Run(arg->runs_->size(), [arg](size_t i) {
+                    auto now = arg->running_->fetch_add(1) + 1;
+                    auto max = arg->max_running_->load();
+                    while(now > max && !arg->max_running_->compare_exchange_weak(max, now)) {
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    (*arg->runs_)[i].fetch_add(1);
+                    arg->running_->fetch_sub(1);
+                });
+            }, &arg);
+        }
+        bg_task->WaitForEmptyQueue();
+
+        for(auto &task_runs : runs) {
+            for(auto &run : task_runs) {
+                ASSERT_EQ(run.load(), 1);
+            }
+        }
+        ASSERT_LE(max_running.load(), thread_count);
+
+        // 子任务的异常在调用线程中重新抛出
+        std::atomic<int> done{0};
+        ASSERT_THROW(bg_task->Run(8, [&](size_t i) {
+            done++;
+            if(i == 5) {
+                throw std::runtime_error("subcompaction failed");
+            }
+        }), std::runtime_error);
+        ASSERT_EQ(done.load(), 8);
+
+        bg_task->WaitForEmptyQueue();
+        bg_task->Shutdown();
+    }
+
+} // namespace LindormContest
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
 
 #include "TSDBEngineImpl.h"
+#include "common/logger.h"
 #include "test_util.h"
 #include "table_operator.h"
 
@@ -156,4 +161,87 @@ namespace LindormContest {
         delete engine;
     }
 
+    // 多表并发写入, 同时有查询线程, 写入不经过引擎级别的锁
+    // 与改为 copy-on-write 之前的加锁方式比较吞吐量: 写入在持有引擎锁时执行, 查询只在查找表时持有引擎锁
+    TEST(DBWriterTest, MultiTableConcurrentIngest) {
+        const int thread_count = 16;
+        const int write_count = 50;
+
+        for(int table_count : {1, 4, 16}) {
+            double throughput[2];
+            for(bool engine_mutex : {true, false}) {
+                auto engine = CreateTestTSDBEngine();
+                ASSERT_EQ(engine->connect(), 0);
+
+                std::vector<std::unique_ptr<TestTableOperator>> tests;
+                for(int i = 0; i < table_count; i++) {
+                    auto name = "test" + std::to_string(i);
+                    tests.emplace_back(std::make_unique<TestTableOperator>(name, TestSchemaType::Basic));
+                    ASSERT_EQ(engine->createTable(name, GenerateSchema(TestSchemaType::Basic)), 0);
+                }
+
+                // 提前生成写请求, 避免 TestTableOperator 的锁影响测试结果
+                std::vector<std::vector<WriteRequest>> requests(thread_count);
+                for(int t = 0; t < thread_count; t++) {
+                    for(int i = 0; i < write_count; i++) {
+                        auto wr = tests[t % table_count]->GenerateWriteRequest(t * 20, 20, i);
+                        wr.tableName = "test" + std::to_string(t % table_count);
+                        requests[t].push_back(std::move(wr));
+                    }
+                }
+
+                std::mutex mutex;
+                std::atomic_bool stop{false};
+                std::thread reader([&]() {
+                    int i = 0;
+                    while(!stop.load(std::memory_order_acquire)) {
+                        LatestQueryRequest qr;
+                        qr.tableName = "test" + std::to_string(i++ % table_count);
+                        if(engine_mutex) {
+                            std::scoped_lock<std::mutex> lock(mutex);
+                        }
+                        std::vector<Row> results;
+                        ASSERT_EQ(engine->executeLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+                    }
+                });
+
+                auto start_time = std::chrono::high_resolution_clock::now();
+                std::vector<std::thread> threads;
+                for(int t = 0; t < thread_count; t++) {
+                    threads.emplace_back([&, t]() {
+                        for(auto &wr : requests[t]) {
+                            std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+                            if(engine_mutex) {
+                                lock.lock();
+                            }
+                            ASSERT_EQ(engine->upsert(wr), 0) << "Upsert failed";
+                        }
+                    });
+                }
+                for(auto &t : threads) {
+                    t.join();
+                }
+                auto end_time = std::chrono::high_resolution_clock::now();
+                stop.store(true, std::memory_order_release);
+                reader.join();
+
+                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+                throughput[engine_mutex] = static_cast<double>(thread_count) * write_count * 20 * 1e6 / static_cast<double>(duration);
+
+                for(int i = 0; i < table_count; i++) {
+                    auto qr = tests[i]->GenerateLatestQueryRequest(0, thread_count * 20);
+                    qr.tableName = "test" + std::to_string(i);
+                    std::vector<Row> results;
+                    ASSERT_EQ(engine->executeLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+                    tests[i]->CheckLastQuery(results, qr, true);
+                }
+
+                ASSERT_EQ(engine->shutdown(), 0);
+                delete engine;
+            }
+            LOG_INFO("tables = %d, threads = %d, engine mutex = %.0f rows/s, copy-on-write = %.0f rows/s, ratio = %.2f",
+                     table_count, thread_count, throughput[true], throughput[false], throughput[false] / throughput[true]);
+        }
+    }
+
 } // namespace LindormContest
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+
+#include "TSDBEngineImpl.h"
+#include "db/db_options.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 未调用 shutdown 的情况下, 重新打开数据库后数据不丢失
+    TEST(WalTest, RecoverWithoutShutdown) {
+        TestTableOperator test("test", TestSchemaType::Complex);
+        TSDBEngine *engine = CreateTestTSDBEngine();
+        ASSERT_EQ(engine->connect(), 0);
+        ASSERT_EQ(engine->createTable("test", GenerateSchema(TestSchemaType::Complex)), 0);
+
+        for(int i = 1; i <= 50; i++) {
+            auto wr = test.GenerateWriteRequest(rand() % 100, 100, i);
+            ASSERT_EQ(engine->upsert(wr), 0) << "Upsert failed";
+        }
+
+        // 模拟崩溃: 不调用 shutdown, 直接打开新的实例
+        uint64_t last_log_size = 0;
+        for(int c = 0; c < 3; c++) {
+            auto recover_engine = new TSDBEngineImpl("./db");
+            ASSERT_EQ(recover_engine->connect(), 0);
+
+            auto qr = test.GenerateLatestQueryRequest(0, 200);
+            std::vector<Row> results;
+            ASSERT_EQ(recover_engine->executeLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            test.CheckLastQuery(results, qr, true);
+
+            for(int key = 0; key < 200; key += 7) {
+                auto rq = test.GenerateTimeRangeQueryRequest(key, 0, 100);
+                std::vector<Row> range_results;
+                ASSERT_EQ(recover_engine->executeTimeRangeQuery(rq, range_results), 0) << "ExecuteRangeQuery failed";
+                test.CheckRangeQuery(range_results, rq, true);
+            }
+
+            // 第二次打开前正常关闭, WAL 的数据写入 sstable
+            if(c == 0) {
+                ASSERT_EQ(recover_engine->shutdown(), 0);
+            }
+            delete recover_engine;
+        }
+        delete engine;
+    }
+
+    static auto CountFiles(const std::string &prefix) -> int {
+        int count = 0;
+        for(auto &entry : std::filesystem::directory_iterator("./db")) {
+            if(entry.path().filename().string().compare(0, prefix.size(), prefix) == 0) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // shutdown 只追加 manifest_log, 之后未调用 shutdown 时通过 manifest_log 与 WAL 恢复
+    TEST(WalTest, RecoverFromManifestLog) {
+        TestTableOperator test("test", TestSchemaType::Complex);
+        TSDBEngine *engine = CreateTestTSDBEngine();
+        ASSERT_EQ(engine->connect(), 0);
+        ASSERT_EQ(engine->createTable("test", GenerateSchema(TestSchemaType::Complex)), 0);
+        for(int i = 1; i <= 50; i++) {
+            auto wr = test.GenerateWriteRequest(rand() % 100, 100, i);
+            ASSERT_EQ(engine->upsert(wr), 0) << "Upsert failed";
+        }
+        ASSERT_EQ(engine->shutdown(), 0);
+        delete engine;
+
+        // flush 的结果已经写入 manifest_log, 不需要快照与 WAL
+        ASSERT_FALSE(std::filesystem::exists("./db/manifest_file"));
+        ASSERT_TRUE(std::filesystem::exists("./db/manifest_log"));
+        ASSERT_EQ(CountFiles("ljdb_wal"), 0);
+
+        // 写入新的数据后崩溃
+        auto crash_engine = new TSDBEngineImpl("./db");
+        ASSERT_EQ(crash_engine->connect(), 0);
+        for(int i = 51; i <= 80; i++) {
+            auto wr = test.GenerateWriteRequest(rand() % 150, 100, i);
+            ASSERT_EQ(crash_engine->upsert(wr), 0) << "Upsert failed";
+        }
+        delete crash_engine;
+
+        uint64_t last_log_size = 0;
+        for(int c = 0; c < 3; c++) {
+            auto recover_engine = new TSDBEngineImpl("./db");
+            ASSERT_EQ(recover_engine->connect(), 0);
+
+            auto qr = test.GenerateLatestQueryRequest(0, 250);
+            std::vector<Row> results;
+            ASSERT_EQ(recover_engine->executeLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            test.CheckLastQuery(results, qr, true);
+
+            for(int key = 0; key < 250; key += 7) {
+                auto rq = test.GenerateTimeRangeQueryRequest(key, 0, 100);
+                std::vector<Row> range_results;
+                ASSERT_EQ(recover_engine->executeTimeRangeQuery(rq, range_results), 0) << "ExecuteRangeQuery failed";
+                test.CheckRangeQuery(range_results, rq, true);
+            }
+
+            ASSERT_EQ(recover_engine->shutdown(), 0);
+            delete recover_engine;
+            ASSERT_EQ(CountFiles("ljdb_wal"), 0);
+
+            // latest index 写入单独的文件, 每次 shutdown 只在 manifest_log 中追加编号, 旧的文件被删除
+            ASSERT_EQ(CountFiles("ljdb_latest_index"), 1);
+            auto log_size = std::filesystem::file_size("./db/manifest_log");
+            LOG_INFO("shutdown %d, manifest_log size = %lu", c, log_size);
+            if(c > 0) {
+                ASSERT_LT(log_size - last_log_size, 1024);
+            }
+            last_log_size = log_size;
+        }
+    }
+
+    // group commit 的吞吐量, 一个写入组只执行一次 fdatasync
+    TEST(WalTest, GroupCommitThroughput) {
+        const int thread_count = 32;
+        const int write_count = 40;
+
+        for(int group_size : {1, 4, 16, 64}) {
+            auto options = NewDBOptions();
+            options->max_write_group_size_ = group_size;
+
+            TestTableOperator test("test", TestSchemaType::Complex);
+            auto table = test.GenerateTable(options);
+
+            auto start_time = std::chrono::high_resolution_clock::now();
+            std::vector<std::thread> threads;
+            for(int t = 0; t < thread_count; t++) {
+                threads.emplace_back([&, t]() {
+                    for(int i = 0; i < write_count; i++) {
+                        auto wr = test.GenerateWriteRequest(t * 100, 20, i);
+                        ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+                    }
+                });
+            }
+            for(auto &t : threads) {
+                t.join();
+            }
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+            auto requests = thread_count * write_count;
+            auto syncs = table->TestGetLogSyncCount();
+            LOG_INFO("max group size = %d, requests = %d, syncs = %lu, avg group size = %.2f, throughput = %.0f rows/s",
+                     group_size, requests, syncs, static_cast<double>(requests) / static_cast<double>(syncs),
+                     static_cast<double>(requests) * 20 * 1e6 / static_cast<double>(duration));
+            ASSERT_LE(syncs, static_cast<uint64_t>(requests));
+
+            auto qr = test.GenerateLatestQueryRequest(0, thread_count * 100);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            test.CheckLastQuery(results, qr, true);
+
+            table->Shutdown();
+            table->EraseLogFile();
+            options->bg_task_->WaitForEmptyQueue();
+        }
+    }
+
+} // namespace LindormContest
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "disk/disk_manager.h"
+#include "disk/async_io.h"
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // io_uring 与线程池读取的数据与 pread 一致, 并比较批量读取与逐个读取的耗时
+    TEST(AsyncIOTest, ReadBatch) {
+        const std::string file_name = "async_io_test_file";
+        const uint32_t block_size = 4096;
+        const int block_count = 1024;
+
+        std::string content(block_size * block_count, '\0');
+        for(size_t i = 0; i < content.size(); i++) {
+            content[i] = static_cast<char>(rand());
+        }
+        int fd = ::open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+        DiskManager::AppendFile(fd, content.data(), content.size());
+
+        std::vector<uint64_t> offsets;
+        for(int i = 0; i < 2000; i++) {
+            offsets.push_back(rand() % (content.size() - block_size));
+        }
+        std::vector<char> buffer(block_size * offsets.size());
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for(size_t i = 0; i < offsets.size(); i++) {
+            DiskManager::ReadBlock(fd, buffer.data() + i * block_size, block_size, offsets[i]);
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        LOG_INFO("%zu reads one by one: %ld us", offsets.size(),
+                 std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+
+        std::vector<std::unique_ptr<AsyncIO>> backends;
+        backends.push_back(AsyncIO::NewThreadPool(K_ASYNC_IO_THREADS));
+        auto uring = AsyncIO::NewIoUring(K_ASYNC_IO_QUEUE_DEPTH);
+        if(uring != nullptr) {
+            backends.push_back(std::move(uring));
+        }
+
+        for(auto &io : backends) {
+            std::fill(buffer.begin(), buffer.end(), 0);
+            std::vector<ReadRequest> requests;
+            for(size_t i = 0; i < offsets.size(); i++) {
+                requests.push_back({fd, buffer.data() + i * block_size, block_size, offsets[i]});
+            }
+
+            start_time = std::chrono::high_resolution_clock::now();
+            io->ReadBatch(requests);
+            end_time = std::chrono::high_resolution_clock::now();
+            LOG_INFO("%zu reads in one batch (%s): %ld us", offsets.size(), io->Name(),
+                     std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+
+            for(size_t i = 0; i < offsets.size(); i++) {
+                ASSERT_EQ(std::string_view(buffer.data() + i * block_size, block_size),
+                          std::string_view(content.data() + offsets[i], block_size));
+            }
+
+            // 超出文件末尾的读取抛出异常
+            std::vector<ReadRequest> bad_requests{{fd, buffer.data(), block_size, content.size() - 10}};
+            ASSERT_THROW(io->ReadBatch(bad_requests), Exception);
+
+            // 批次中间的请求失败时, 抛出异常前已提交的请求全部完成, 返回后缓冲区不再被写入
+            std::fill(buffer.begin(), buffer.end(), 0);
+            std::vector<ReadRequest> mixed_requests;
+            for(size_t i = 0; i < offsets.size(); i++) {
+                mixed_requests.push_back({fd, buffer.data() + i * block_size, block_size, offsets[i]});
+            }
+            auto bad_idx = offsets.size() / 3;
+            mixed_requests[bad_idx].offset_ = content.size() - 10;
+            ASSERT_THROW(io->ReadBatch(mixed_requests), Exception);
+            auto snapshot = buffer;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ASSERT_TRUE(snapshot == buffer);
+
+            // 之后的批次不受残留的完成事件影响
+            std::vector<char> next_buffer(block_size * 4);
+            std::vector<ReadRequest> next_requests;
+            for(size_t i = 0; i < 4; i++) {
+                next_requests.push_back({fd, next_buffer.data() + i * block_size, block_size, offsets[i]});
+            }
+            io->ReadBatch(next_requests);
+            for(size_t i = 0; i < 4; i++) {
+                ASSERT_EQ(std::string_view(next_buffer.data() + i * block_size, block_size),
+                          std::string_view(content.data() + offsets[i], block_size));
+            }
+        }
+
+        ::close(fd);
+        ::unlink(file_name.c_str());
+    }
+
+} // namespace LindormContest
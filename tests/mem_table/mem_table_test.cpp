@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <thread>
+#include <atomic>
 #include "mem_table/mem_table.h"
 #include "test_util.h"
 
@@ -27,5 +29,73 @@ TEST(MemTableTest, BasicAssertions) {
     delete mem;
 }
 
+// 相同 key 多次写入, 只能读到最新的版本
+TEST(MemTableTest, Overwrite) {
+    MemTable mem;
+    for(int i = 0; i < 100; i++) {
+        for(int version = 0; version < 3; version++) {
+            Row row = GenerateRow(i);
+            row.columns["c1"] = ColumnValue(version);
+            mem.Insert(row);
+        }
+    }
+
+    auto iter = mem.NewIterator();
+    iter->SeekToFirst();
+    int count = 0;
+    while(iter->Valid()) {
+        ASSERT_EQ(CodingUtil::DecodeInteger(iter->GetValue().data()), 2);
+        iter->Next();
+        count++;
+    }
+    ASSERT_EQ(count, 100);
+
+    iter->Seek(GenerateKey(42));
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(iter->GetKey(), GenerateKey(42));
+    ASSERT_EQ(CodingUtil::DecodeInteger(iter->GetValue().data()), 2);
+}
+
+// 一个线程写入, 多个线程在不加锁的情况下读取
+TEST(MemTableTest, ConcurrentRead) {
+    MemTable mem;
+    const int write_count = 20000;
+    std::atomic<int> written{0};
+
+    std::thread writer([&]() {
+        for(int i = 0; i < write_count; i++) {
+            Row row = GenerateRow(i);
+            row.timestamp = i;
+            mem.Insert(row);
+            written.store(i + 1, std::memory_order_release);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for(int t = 0; t < 4; t++) {
+        readers.emplace_back([&]() {
+            while(written.load(std::memory_order_acquire) < write_count) {
+                int visible = written.load(std::memory_order_acquire);
+                if(visible == 0) {
+                    continue;
+                }
+
+                // 已写入的 key 一定可见
+                int key = rand() % visible;
+                auto iter = mem.NewIterator();
+                iter->Seek(InternalKey(GenerateVin(key), MAX_TIMESTAMP));
+                ASSERT_TRUE(iter->Valid());
+                ASSERT_EQ(iter->GetKey(), InternalKey(GenerateVin(key), key));
+                ASSERT_EQ(CodingUtil::DecodeInteger(iter->GetValue().data()), key);
+            }
+        });
+    }
+
+    writer.join();
+    for(auto &t : readers) {
+        t.join();
+    }
+}
+
 
 } // namespace LindormContest
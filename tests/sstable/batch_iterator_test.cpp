@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "disk/disk_manager.h"
+#include "mem_table/mem_table.h"
+#include "sstable/sstable_builder.h"
+#include "test_util.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    static auto GetColumnTypes(const Schema &schema) -> std::vector<ColumnType> {
+        std::vector<ColumnType> column_types;
+        for(auto &column : schema.columnTypeMap) {
+            column_types.push_back(column.second);
+        }
+        return column_types;
+    }
+
+    // 从 lower 开始按批读取到 limit, 结果与逐行读取一致
+    static void CheckBatches(Iterator *iter, const std::map<InternalKey, std::string> &data, const Schema &schema,
+                             const std::set<std::string> &columns, const ColumnMask &column_mask,
+                             const InternalKey &lower, const InternalKey &limit, size_t batch_size) {
+        ColumnBatch batch;
+        batch.Init(GetColumnTypes(schema), &column_mask);
+
+        auto map_iter = data.lower_bound(lower);
+        iter->Seek(lower);
+        size_t rows = 0;
+        while(true) {
+            batch.Clear();
+            auto count = iter->NextBatch(batch_size, &limit, &batch);
+            ASSERT_EQ(count, batch.Size());
+            if(count == 0) {
+                break;
+            }
+            ASSERT_LE(count, batch_size);
+            for(size_t i = 0; i < count; i++, map_iter++) {
+                ASSERT_NE(map_iter, data.end());
+                ASSERT_FALSE(limit < map_iter->first);
+                ASSERT_TRUE(batch.vins_[i] == map_iter->first.vin_);
+                ASSERT_EQ(batch.timestamps_[i], map_iter->first.timestamp_);
+
+                Row row;
+                batch.GetRow(i, schema, &row);
+                auto expected = CodingUtil::DecodeRow(map_iter->second.data(), const_cast<Schema &>(schema), &columns);
+                ASSERT_EQ(row.columns.size(), columns.size());
+                for(auto &column : row.columns) {
+                    ASSERT_EQ(column.second, expected.columns[column.first]);
+                }
+                rows++;
+            }
+        }
+        ASSERT_TRUE(map_iter == data.end() || limit < map_iter->first) << "stopped early after " << rows << " rows";
+
+        // 停止后迭代器位于第一个大于 limit 的 key
+        if(map_iter != data.end()) {
+            ASSERT_TRUE(iter->Valid());
+            ASSERT_EQ(iter->GetKey(), map_iter->first);
+        }
+    }
+
+    TEST(BatchIteratorTest, MatchesRowIteration) {
+        int32_t test_file_number = 15;
+        auto schema = GenerateSchema(TestSchemaType::Long);
+        std::set<std::string> columns{"col_double_3", "col_integer_7", "col_string_2", "col_string_5"};
+        ColumnMask column_mask;
+        for(auto &column : schema.columnTypeMap) {
+            column_mask.push_back(columns.count(column.first) != 0);
+        }
+
+        std::map<InternalKey, std::string> data;
+        for(int key = 0; key < 20; key++) {
+            for(int64_t t = 0; t < 300; t++) {
+                Row row;
+                GenerateRandomRow(schema, row);
+                data[InternalKey(GenerateVin(key), t)] = CodingUtil::EncodeRow(row);
+            }
+        }
+
+        MemTable mem;
+        for(auto &item : data) {
+            mem.Insert(item.first, item.second);
+        }
+
+        for(bool columnar : {false, true}) {
+            DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+            auto builder = columnar ? std::make_unique<SStableBuilder>(test_file_number, nullptr, schema)
+                                    : std::make_unique<SStableBuilder>(test_file_number);
+            for(auto &item : data) {
+                builder->Add(item.first, item.second);
+            }
+            auto file_size = builder->Builder()->GetFileSize();
+            SSTable sstable(test_file_number, file_size);
+
+            for(size_t batch_size : {1UL, 7UL, 256UL, 100000UL}) {
+                for(int i = 0; i < 20; i++) {
+                    auto vin = GenerateVin(rand() % 20);
+                    int64_t a = rand() % 300;
+                    int64_t b = rand() % 300;
+                    InternalKey lower(vin, std::max(a, b));
+                    InternalKey limit(vin, std::min(a, b));
+
+                    auto table_iter = sstable.NewIterator(&column_mask);
+                    CheckBatches(table_iter.get(), data, schema, columns, column_mask, lower, limit, batch_size);
+                    auto mem_iter = mem.NewIterator();
+                    CheckBatches(mem_iter.get(), data, schema, columns, column_mask, lower, limit, batch_size);
+                }
+
+                // 跨越多个 block 读取到结尾
+                auto table_iter = sstable.NewIterator(&column_mask);
+                auto last = data.rbegin()->first;
+                CheckBatches(table_iter.get(), data, schema, columns, column_mask, data.begin()->first, last, batch_size);
+            }
+            DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+        }
+    }
+
+    // 列式 sstable 的整表扫描, 比较逐行解码与按批读取求一个 int 列的和
+    TEST(BatchIteratorTest, ColumnarScanThroughput) {
+        int32_t test_file_number = 15;
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+
+        auto schema = GenerateSchema(TestSchemaType::Long);
+        SStableBuilder builder(test_file_number, nullptr, schema);
+        std::map<InternalKey, std::string> data;
+        for(int i = 0; i < 20000; i++) {
+            Row row;
+            GenerateRandomRow(schema, row);
+            data[InternalKey(GenerateVin(i / 100), i % 100)] = CodingUtil::EncodeRow(row);
+        }
+        for(auto &item : data) {
+            builder.Add(item.first, item.second);
+        }
+        auto sstable = builder.Builder();
+
+        std::set<std::string> columns{"col_integer_7"};
+        ColumnMask column_mask;
+        for(auto &column : schema.columnTypeMap) {
+            column_mask.push_back(columns.count(column.first) != 0);
+        }
+
+        int64_t row_sum = 0;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for(int c = 0; c < 5; c++) {
+            auto iter = sstable->NewIterator(&column_mask);
+            for(iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                auto row = CodingUtil::DecodeRow(iter->GetValue().data(), schema, &columns);
+                int32_t value;
+                row.columns.begin()->second.getIntegerValue(value);
+                row_sum += value;
+            }
+        }
+        auto row_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start_time).count();
+
+        auto column_idx = static_cast<size_t>(std::distance(schema.columnTypeMap.begin(), schema.columnTypeMap.find("col_integer_7")));
+        ColumnBatch batch;
+        batch.Init(GetColumnTypes(schema), &column_mask);
+        int64_t batch_sum = 0;
+        start_time = std::chrono::high_resolution_clock::now();
+        for(int c = 0; c < 5; c++) {
+            auto iter = sstable->NewIterator(&column_mask);
+            iter->SeekToFirst();
+            while(true) {
+                batch.Clear();
+                if(iter->NextBatch(K_ROW_BATCH_SIZE, nullptr, &batch) == 0) {
+                    break;
+                }
+                for(auto value : batch.columns_[column_idx].ints_) {
+                    batch_sum += value;
+                }
+            }
+        }
+        auto batch_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start_time).count();
+
+        ASSERT_EQ(row_sum, batch_sum);
+        LOG_INFO("rows = %zu, row-at-a-time scan = %ld us, batch scan = %ld us", data.size(), row_time / 5, batch_time / 5);
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+    }
+
+} // namespace LindormContest
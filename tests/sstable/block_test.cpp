@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include "sstable/block_builder.h"
 #include "test_util.h"
+#include "common/logger.h"
 
 
 namespace LindormContest {
@@ -34,4 +36,66 @@ TEST(BlockTest, BasicAssertions) {
 }
 
 
+// 跨越多个 restart point 的顺序读取与 Seek
+TEST(BlockTest, RestartPointSeek) {
+    BlockBuilder builder(SSTABLE_BLOCK_CAPACITY * 4);
+    builder.Init();
+
+    std::vector<InternalKey> keys;
+    for(int key = 0; key < 10; key++) {
+        for(int64_t t = 30; t > 0; t--) {
+            keys.emplace_back(GenerateVin(key), t * 1000 + key);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    for(size_t i = 0; i < keys.size(); i++) {
+        ASSERT_TRUE(builder.Add(keys[i], "value" + std::to_string(i)));
+    }
+
+    auto block = builder.Builder();
+    ASSERT_EQ(block->GetEntrySize(), keys.size());
+
+    auto iter = block->NewIterator();
+    for(size_t i = 0; i < keys.size(); i++) {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(iter->GetKey(), keys[i]);
+        ASSERT_EQ(iter->GetValue(), "value" + std::to_string(i));
+        iter->Next();
+    }
+    ASSERT_FALSE(iter->Valid());
+
+    for(size_t i = 0; i < keys.size(); i++) {
+        iter->Seek(keys[i]);
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(iter->GetKey(), keys[i]);
+
+        // 不存在的 key 定位到下一个 key
+        iter->Seek(InternalKey(keys[i].vin_, keys[i].timestamp_ + 1));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(iter->GetKey(), keys[i]);
+    }
+
+    iter->Seek(InternalKey(keys.back().vin_, keys.back().timestamp_ - 1));
+    ASSERT_FALSE(iter->Valid());
+}
+
+// 一个 block 能容纳的行数, 同一 vin 的连续行共享 vin 前缀并对时间戳做差值编码
+TEST(BlockTest, PrefixCompression) {
+    std::string value(40, 'v');
+    BlockBuilder builder(SSTABLE_BLOCK_CAPACITY);
+    builder.Init();
+
+    size_t rows = 0;
+    int64_t timestamp = 1694000000000;
+    while(builder.Add(InternalKey(GenerateVin(rows / 100), timestamp - static_cast<int64_t>(rows % 100) * 1000), value)) {
+        rows++;
+    }
+
+    // 不压缩时每行需要 key (25) + value 长度 (4) + value + offset (4)
+    size_t plain_rows = (SSTABLE_BLOCK_CAPACITY - 4) / (INTERNAL_KEY_SIZE + 8 + value.size());
+    LOG_INFO("rows per %u bytes block: plain = %zu, prefix compressed = %zu", SSTABLE_BLOCK_CAPACITY, plain_rows, rows);
+    ASSERT_GT(rows, plain_rows);
+}
+
+
 }  // namespace ljdb
\ No newline at end of file
@@ -1,9 +1,12 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <thread>
+#include <chrono>
+#include <filesystem>
 #include "disk/disk_manager.h"
 #include "sstable/sstable_builder.h"
 #include "test_util.h"
+#include "common/logger.h"
 
 namespace LindormContest {
 
@@ -138,4 +141,338 @@ TEST(SSTableTest, HardWriteSSTable) {
 
 
 
-}  // namespace LindormContest
\ No newline at end of file
+    // 列式 sstable 读取全部列与部分列
+    TEST(SSTableTest, ColumnarSSTable) {
+        int32_t test_file_number = 14;
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+
+        auto schema = GenerateSchema(TestSchemaType::Long);
+        SStableBuilder builder(test_file_number, nullptr, schema);
+
+        std::map<InternalKey, Row> data;
+        for(int i = 0; i < 2000; i++) {
+            Row row;
+            GenerateRandomRow(schema, row);
+            data[GenerateKey(i)] = row;
+        }
+
+        for(auto &item : data) {
+            auto value = CodingUtil::EncodeRow(item.second);
+            builder.Add(item.first, value);
+        }
+
+        auto sstable = builder.Builder();
+        ASSERT_TRUE(sstable->IsColumnar());
+
+        // 全部列
+        auto iter = sstable->NewIterator();
+        for(auto &item : data) {
+            ASSERT_EQ(iter->Valid(), true);
+            ASSERT_EQ(iter->GetKey(), item.first);
+            ASSERT_EQ(iter->GetValue(), CodingUtil::EncodeRow(item.second));
+            iter->Next();
+        }
+        ASSERT_EQ(iter->Valid(), false);
+
+        // 部分列, 重新打开文件
+        SSTable reopen(test_file_number, sstable->GetFileSize());
+        ASSERT_TRUE(reopen.IsColumnar());
+
+        std::set<std::string> columns{"col_double_3", "col_integer_7", "col_string_2"};
+        ColumnMask column_mask;
+        for(auto &column : schema.columnTypeMap) {
+            column_mask.push_back(columns.count(column.first) != 0);
+        }
+
+        for(int i = 0; i < 200; i++) {
+            int start = rand() % 2000;
+            auto map_iter = data.lower_bound(GenerateKey(start));
+            auto column_iter = reopen.NewIterator(&column_mask);
+            column_iter->Seek(GenerateKey(start));
+
+            for(int j = 0; j < 20 && map_iter != data.end(); j++, map_iter++) {
+                ASSERT_EQ(column_iter->Valid(), true);
+                ASSERT_EQ(column_iter->GetKey(), map_iter->first);
+                auto row = CodingUtil::DecodeRow(column_iter->GetValue().data(), schema, &columns);
+                ASSERT_EQ(row.columns.size(), columns.size());
+                for(auto &column : row.columns) {
+                    ASSERT_EQ(column.second, map_iter->second.columns[column.first]);
+                }
+                column_iter->Next();
+            }
+        }
+
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+    }
+
+    // 列式 sstable 的扫描耗时与查询列数的关系
+    TEST(SSTableTest, ColumnarProjectionScan) {
+        int32_t test_file_number = 14;
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+
+        auto schema = GenerateSchema(TestSchemaType::Long);
+        SStableBuilder builder(test_file_number, nullptr, schema);
+        std::map<InternalKey, std::string> data;
+        for(int i = 0; i < 5000; i++) {
+            Row row;
+            GenerateRandomRow(schema, row);
+            data[GenerateKey(i)] = CodingUtil::EncodeRow(row);
+        }
+        for(auto &item : data) {
+            builder.Add(item.first, item.second);
+        }
+        auto sstable = builder.Builder();
+
+        for(size_t column_count : {2UL, 15UL, 60UL}) {
+            ColumnMask column_mask(schema.columnTypeMap.size(), false);
+            for(size_t i = 0; i < column_count; i++) {
+                column_mask[i * column_mask.size() / column_count] = true;
+            }
+
+            auto start_time = std::chrono::high_resolution_clock::now();
+            size_t rows = 0;
+            for(int c = 0; c < 5; c++) {
+                auto iter = sstable->NewIterator(&column_mask);
+                for(iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                    rows += iter->GetValue().empty() ? 0 : 1;
+                }
+            }
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+            ASSERT_EQ(rows, 5 * 5000UL);
+            LOG_INFO("columns = %zu / %zu, full scan time = %ld us", column_count, column_mask.size(), duration / 5);
+        }
+
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+    }
+
+    // zone map 跳过时间范围外的 block, 窄时间窗口只读取少量 block
+    TEST(SSTableTest, ZoneMapRangeScan) {
+        int32_t test_file_number = 14;
+        const int64_t history = 20000;
+
+        for(bool columnar : {false, true}) {
+            DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+            auto schema = GenerateSchema(TestSchemaType::Complex);
+            auto builder = columnar ? std::make_unique<SStableBuilder>(test_file_number, nullptr, schema)
+                                    : std::make_unique<SStableBuilder>(test_file_number);
+
+            // 3 个 vin, 中间的 vin 有很长的历史
+            std::map<InternalKey, std::string> data;
+            for(int key = 0; key < 3; key++) {
+                for(int64_t t = 0; t < (key == 1 ? history : 100); t++) {
+                    Row row;
+                    GenerateRandomRow(schema, row);
+                    data[InternalKey(GenerateVin(key), t)] = CodingUtil::EncodeRow(row);
+                }
+            }
+            for(auto &item : data) {
+                builder->Add(item.first, item.second);
+            }
+            auto file_size = builder->Builder()->GetFileSize();
+
+            auto vin = GenerateVin(1);
+            for(int64_t lower : {0L, history / 2, history - 50}) {
+                int64_t upper = lower + 50;
+                InternalKey lower_key(vin, upper);
+                InternalKey upper_key(vin, lower);
+
+                // 不使用 zone map: 从 vin 的第一行开始扫描
+                SSTable full_table(test_file_number, file_size);
+                auto full_iter = full_table.NewIterator();
+                size_t full_rows = 0;
+                for(full_iter->Seek(InternalKey(vin, MAX_TIMESTAMP)); full_iter->Valid(); full_iter->Next()) {
+                    auto key = full_iter->GetKey();
+                    if(key.vin_ != vin) {
+                        break;
+                    }
+                    full_rows += key.timestamp_ >= lower && key.timestamp_ < upper ? 1 : 0;
+                }
+
+                SSTable zone_table(test_file_number, file_size);
+                auto zone_iter = zone_table.NewRangeIterator(lower_key, upper_key);
+                size_t zone_rows = 0;
+                for(zone_iter->Seek(lower_key); zone_iter->Valid(); zone_iter->Next()) {
+                    auto key = zone_iter->GetKey();
+                    if(key.vin_ != vin || key.timestamp_ < lower) {
+                        break;
+                    }
+                    if(key.timestamp_ < upper) {
+                        ASSERT_EQ(zone_iter->GetValue(), data[key]);
+                        zone_rows++;
+                    }
+                }
+
+                ASSERT_EQ(full_rows, 50U);
+                ASSERT_EQ(zone_rows, 50U);
+                ASSERT_LT(zone_table.TestGetBlockReadCount(), full_table.TestGetBlockReadCount());
+                LOG_INFO("columnar = %d, window = [%ld, %ld), block reads: scan = %lu, zone map = %lu", columnar, lower, upper,
+                         full_table.TestGetBlockReadCount(), zone_table.TestGetBlockReadCount());
+            }
+        }
+
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+    }
+
+    // 冷缓存下的随机 block 读取: 每次读取都打开文件与复用文件描述符 pread
+    TEST(SSTableTest, ColdRandomBlockRead) {
+        int32_t test_file_number = 14;
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+
+        SStableBuilder builder(test_file_number);
+        std::map<InternalKey, std::string> data;
+        for(int i = 0; i < 5000; i++) {
+            data[GenerateKey(i)] = CodingUtil::EncodeRow(GenerateRow(i));
+        }
+        for(auto &item : data) {
+            builder.Add(item.first, item.second);
+        }
+        auto file_size = builder.Builder()->GetFileSize();
+
+        const int read_count = 5000;
+        std::vector<uint64_t> offsets;
+        for(int i = 0; i < read_count; i++) {
+            offsets.push_back(rand() % (file_size - SSTABLE_BLOCK_CAPACITY));
+        }
+        std::vector<char> buffer(SSTABLE_BLOCK_CAPACITY);
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for(auto offset : offsets) {
+            auto file = DiskManager::OpenFile(GET_SSTABLE_NAME(test_file_number));
+            DiskManager::ReadBlock(file, buffer.data(), SSTABLE_BLOCK_CAPACITY, offset);
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto open_duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+        int fd = DiskManager::OpenSSTableFile(test_file_number);
+        start_time = std::chrono::high_resolution_clock::now();
+        for(auto offset : offsets) {
+            DiskManager::ReadBlock(fd, buffer.data(), SSTABLE_BLOCK_CAPACITY, offset);
+        }
+        end_time = std::chrono::high_resolution_clock::now();
+        auto pread_duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+        DiskManager::CloseFile(fd);
+
+        LOG_INFO("%d random %u bytes reads: ifstream per read = %ld us, pread = %ld us", read_count, SSTABLE_BLOCK_CAPACITY,
+                 open_duration, pread_duration);
+
+        // 不使用 block cache 时每次 Seek 都从磁盘读取, 多个线程共享同一个文件描述符
+        SSTable sstable(test_file_number, file_size);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; t++) {
+            threads.emplace_back([&]() {
+                for(int i = 0; i < 500; i++) {
+                    auto item = data.find(GenerateKey(rand() % 5000));
+                    auto iter = sstable.NewIterator();
+                    iter->Seek(item->first);
+                    ASSERT_TRUE(iter->Valid());
+                    ASSERT_EQ(iter->GetKey(), item->first);
+                    ASSERT_EQ(iter->GetValue(), item->second);
+                }
+            });
+        }
+        for(auto &thread : threads) {
+            thread.join();
+        }
+
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+    }
+
+    // mmap 与 pread 读取的结果一致, 以及冷缓存下随机 Seek 的耗时
+    TEST(SSTableTest, MmapRead) {
+        int32_t test_file_number = 14;
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+
+        auto schema = GenerateSchema(TestSchemaType::Complex);
+        for(bool columnar : {false, true}) {
+            auto builder = columnar ? std::make_unique<SStableBuilder>(test_file_number, nullptr, schema)
+                                    : std::make_unique<SStableBuilder>(test_file_number);
+            std::map<InternalKey, std::string> data;
+            for(int i = 0; i < 5000; i++) {
+                Row row;
+                GenerateRandomRow(schema, row);
+                data[GenerateKey(i)] = CodingUtil::EncodeRow(row);
+            }
+            for(auto &item : data) {
+                builder->Add(item.first, item.second);
+            }
+            auto file_size = builder->Builder()->GetFileSize();
+
+            std::vector<InternalKey> keys;
+            for(int i = 0; i < 1000; i++) {
+                keys.push_back(GenerateKey(rand() % 5000));
+            }
+
+            for(bool use_mmap : {false, true}) {
+                SSTable sstable(test_file_number, file_size, nullptr, use_mmap);
+                ASSERT_EQ(sstable.IsMapped(), use_mmap);
+
+                auto start_time = std::chrono::high_resolution_clock::now();
+                for(auto &key : keys) {
+                    auto iter = sstable.NewIterator();
+                    iter->Seek(key);
+                    ASSERT_TRUE(iter->Valid());
+                    ASSERT_EQ(iter->GetKey(), key);
+                    ASSERT_EQ(iter->GetValue(), data[key]);
+                }
+                auto end_time = std::chrono::high_resolution_clock::now();
+                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+                LOG_INFO("columnar = %d, use mmap = %d, %zu uncached seeks = %ld us", columnar, use_mmap, keys.size(), duration);
+            }
+            DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+        }
+    }
+
+    // O_DIRECT 写入的文件与普通写入相同, 两种方式写入的文件都可以用两种方式读取
+    TEST(SSTableTest, DirectIO) {
+        int32_t test_file_number = 15;
+        DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+
+        auto schema = GenerateSchema(TestSchemaType::Complex);
+        std::map<InternalKey, std::string> data;
+        for(int i = 0; i < 5000; i++) {
+            Row row;
+            GenerateRandomRow(schema, row);
+            data[GenerateKey(i)] = CodingUtil::EncodeRow(row);
+        }
+        std::vector<InternalKey> keys;
+        for(int i = 0; i < 1000; i++) {
+            keys.push_back(GenerateKey(rand() % 5000));
+        }
+
+        for(bool columnar : {false, true}) {
+            for(bool direct_write : {false, true}) {
+                auto builder = columnar ? std::make_unique<SStableBuilder>(test_file_number, nullptr, schema, direct_write)
+                                        : std::make_unique<SStableBuilder>(test_file_number, nullptr, SSTABLE_BLOCK_CAPACITY,
+                                                                           direct_write);
+                for(auto &item : data) {
+                    builder->Add(item.first, item.second);
+                }
+                auto file_size = builder->Builder()->GetFileSize();
+                ASSERT_EQ(std::filesystem::file_size("." + GET_SSTABLE_NAME(test_file_number)), file_size);
+
+                for(bool direct_read : {false, true}) {
+                    SSTable sstable(test_file_number, file_size, nullptr, true, direct_read);
+                    ASSERT_EQ(sstable.IsDirectIO(), direct_read);
+                    ASSERT_EQ(sstable.IsMapped(), !direct_read);
+
+                    for(auto &key : keys) {
+                        auto iter = sstable.NewIterator();
+                        iter->Seek(key);
+                        ASSERT_TRUE(iter->Valid());
+                        ASSERT_EQ(iter->GetKey(), key);
+                        ASSERT_EQ(iter->GetValue(), data[key]);
+                    }
+
+                    // 最后一个 block 不是对齐的, 读取到文件末尾
+                    auto iter = sstable.NewIterator();
+                    iter->Seek(data.rbegin()->first);
+                    ASSERT_TRUE(iter->Valid());
+                    ASSERT_EQ(iter->GetValue(), data.rbegin()->second);
+                }
+                DiskManager::RemoveFile(GET_SSTABLE_NAME(test_file_number));
+            }
+        }
+    }
+
+}  // namespace LindormContest
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include "db/db_options.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 逐层查找 latest query 时批量读取 block 与逐个读取的结果一致, 并比较冷缓存下的耗时
+    TEST(BatchReadTest, LatestQuery) {
+        auto options = NewDBOptions();
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        // 每个阶段写入不同的 vin 并在关闭时生成一个 sstable
+        const int phase_count = K_L0_COMPACTION_TRIGGER - 1;
+        for(int phase = 0; phase < phase_count; phase++) {
+            auto table = test.GenerateTable(options);
+            if(phase > 0) {
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->ReadMetaData(manifest_file);
+            }
+            for(int i = 0; i < 20; i++) {
+                auto wr = test.GenerateWriteRequest(phase * 300, 300, i);
+                ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+            }
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+            delete table;
+        }
+
+        // mmap 读取时结果与 pread 相同
+        std::vector<Row> batch_results[2][2];
+        for(bool use_mmap : {false, true}) {
+            for(bool batch : {false, true}) {
+                // 新的 block cache, 所有 block 都需要从磁盘读取
+                auto read_options = NewDBOptions();
+                read_options->use_latest_index_ = false;
+                read_options->batch_block_reads_ = batch;
+                read_options->use_mmap_reads_ = use_mmap;
+
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                auto table = test.GenerateTable(read_options);
+                table->ReadMetaData(manifest_file);
+
+                auto qr = test.GenerateLatestQueryRequest(0, 300 * phase_count);
+                auto start_time = std::chrono::high_resolution_clock::now();
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+                auto end_time = std::chrono::high_resolution_clock::now();
+                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+                LOG_INFO("mmap reads = %d, batch block reads = %d, %zu vins, cold cache latency = %ld us",
+                         use_mmap, batch, qr.vins.size(), duration);
+
+                test.CheckLastQuery(results, qr, true);
+                std::sort(results.begin(), results.end());
+                batch_results[use_mmap][batch] = std::move(results);
+                delete table;
+            }
+        }
+        ASSERT_EQ(batch_results[0][0], batch_results[0][1]);
+        ASSERT_EQ(batch_results[0][0], batch_results[1][0]);
+        ASSERT_EQ(batch_results[0][0], batch_results[1][1]);
+
+        std::ifstream manifest_file("manifest");
+        auto table = test.GenerateTable(options);
+        table->ReadMetaData(manifest_file);
+        table->EraseSSTableFile();
+        delete table;
+    }
+
+} // namespace LindormContest
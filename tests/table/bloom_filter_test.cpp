@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include "db/db_options.h"
+#include "util/bloom.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 布隆过滤器没有漏判, 误判率接近理论值
+    TEST(BloomFilterTest, FalsePositiveRate) {
+        std::vector<std::string> vins;
+        for(int i = 0; i < 10000; i++) {
+            auto vin = GenerateVin(i);
+            vins.emplace_back(vin.vin, VIN_LENGTH);
+        }
+        std::vector<std::string_view> keys(vins.begin(), vins.end());
+        std::string filter;
+        BloomFilter::CreateFilter(keys, K_BLOOM_BITS_PER_KEY, &filter);
+
+        for(auto &key : keys) {
+            ASSERT_TRUE(BloomFilter::KeyMayMatch(key, filter));
+        }
+
+        int false_positive = 0;
+        for(int i = 10000; i < 20000; i++) {
+            auto vin = GenerateVin(i);
+            if(BloomFilter::KeyMayMatch(std::string_view(vin.vin, VIN_LENGTH), filter)) {
+                false_positive++;
+            }
+        }
+        LOG_INFO("bits per key = %d, false positive rate = %.4f", K_BLOOM_BITS_PER_KEY, false_positive / 10000.0);
+        ASSERT_LT(false_positive, 300);
+
+        // 空的 filter 不排除任何 key
+        ASSERT_TRUE(BloomFilter::KeyMayMatch(vins[0], ""));
+    }
+
+    // 开启与关闭布隆过滤器时的 sstable 查找次数与查询耗时
+    TEST(BloomFilterTest, SSTableProbe) {
+        auto options = NewDBOptions();
+        options->use_latest_index_ = false;
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        // 每个阶段写入不同的 vin 并在关闭时生成一个 sstable, 每个 sstable 只包含部分 vin
+        const int phase_count = K_L0_COMPACTION_TRIGGER - 1;
+        for(int phase = 0; phase < phase_count; phase++) {
+            auto table = test.GenerateTable(options);
+            if(phase > 0) {
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->ReadMetaData(manifest_file);
+            }
+            for(int i = 0; i < 20; i++) {
+                auto wr = test.GenerateWriteRequest(phase * 200, 200, i);
+                ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+            }
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+            delete table;
+        }
+
+        std::ifstream manifest_file("manifest");
+        ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+        auto table = test.GenerateTable(options);
+        table->ReadMetaData(manifest_file);
+        ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), static_cast<size_t>(phase_count));
+
+        auto qr = test.GenerateLatestQueryRequest(0, 200 * phase_count);
+        std::vector<TimeRangeQueryRequest> range_requests;
+        for(int key = 0; key < 200 * phase_count; key += 3) {
+            range_requests.push_back(test.GenerateTimeRangeQueryRequest(key, 0, 20));
+        }
+
+        // 先预热 block cache, 两种方式都在缓存命中的情况下比较
+        {
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            for(auto &rq : range_requests) {
+                results.clear();
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteRangeQuery failed";
+            }
+        }
+
+        std::vector<Row> filter_results[2];
+        uint64_t latest_probes[2];
+        uint64_t range_probes[2];
+        for(bool use_filter : {false, true}) {
+            options->use_bloom_filter_ = use_filter;
+
+            // latest query
+            auto probe_count = table->TestGetSSTableProbeCount();
+            auto start_time = std::chrono::high_resolution_clock::now();
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            auto latest_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - start_time).count();
+            latest_probes[use_filter] = table->TestGetSSTableProbeCount() - probe_count;
+            test.CheckLastQuery(results, qr, true);
+
+            // range query
+            std::vector<std::vector<Row>> range_results(range_requests.size());
+            probe_count = table->TestGetSSTableProbeCount();
+            start_time = std::chrono::high_resolution_clock::now();
+            for(size_t i = 0; i < range_requests.size(); i++) {
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(range_requests[i], range_results[i]), 0) << "ExecuteRangeQuery failed";
+            }
+            auto range_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - start_time).count();
+            range_probes[use_filter] = table->TestGetSSTableProbeCount() - probe_count;
+            for(size_t i = 0; i < range_requests.size(); i++) {
+                test.CheckRangeQuery(range_results[i], range_requests[i], true);
+                results.insert(results.end(), range_results[i].begin(), range_results[i].end());
+            }
+
+            LOG_INFO("use bloom filter = %d, latest query of %zu vins: sstable probes = %lu, latency = %ld us; "
+                     "%zu range queries: sstable probes = %lu, latency = %ld us",
+                     use_filter, qr.vins.size(), latest_probes[use_filter], latest_time,
+                     range_requests.size(), range_probes[use_filter], range_time);
+            std::sort(results.begin(), results.end());
+            filter_results[use_filter] = std::move(results);
+        }
+        ASSERT_EQ(filter_results[0], filter_results[1]);
+        ASSERT_LT(latest_probes[1], latest_probes[0]);
+        ASSERT_LT(range_probes[1], range_probes[0]);
+
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseSSTableFile();
+    }
+
+} // namespace LindormContest
@@ -59,4 +59,37 @@ TEST(CacheTest, BasicAssertions) {
 }
 
 
+
+TEST(CacheTest, Erase) {
+    LRUCache<size_t> cache;
+    cache.SetCapacity(10);
+
+    for(size_t i = 0; i < 3; ++i) {
+        InsertCache(cache, i);
+    }
+
+    // 未被引用的节点立即删除
+    cache.Erase(0);
+    QueryCache(cache, 0, false);
+
+    // 被引用的节点在 Release 之前仍然可以访问
+    auto handle = cache.Lookup(1);
+    ASSERT_TRUE(handle != nullptr);
+    cache.Erase(1);
+    QueryCache(cache, 1, false);
+    ASSERT_EQ(*handle->value_, 1);
+    cache.Release(handle);
+
+    // 重复插入返回的节点释放后不会进入 lru, 淘汰时不影响已有的节点
+    handle = cache.Insert(2, std::make_unique<size_t>(2), 1);
+    cache.Release(handle);
+    handle = cache.Lookup(2);
+    for(size_t i = 3; i <= 12; ++i) {
+        InsertCache(cache, i);
+    }
+    cache.Release(handle);
+    QueryCache(cache, 2, true);
+    QueryCache(cache, 3, false);
+}
+
 } // namespace ljdb
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <set>
+#include "db/db_options.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 批量写入大量 L0 sstable 后重新打开, 比较单线程 compaction 与线程池 + subcompaction 追平 L0 的时间
+    TEST(CompactionTest, CatchUpAfterBulkLoad) {
+        const int phase_count = 3 * K_L0_COMPACTION_TRIGGER;
+        const int vin_count = 4000;
+        const int timestamp_count = 10;
+
+        for(int thread_count : {1, K_COMPACTION_THREAD_COUNT}) {
+            auto options = NewDBOptions(thread_count);
+            options->max_background_compactions_ = thread_count;
+            options->max_subcompactions_ = thread_count;
+            TestTableOperator test("test", TestSchemaType::Complex);
+
+            // 每个阶段生成一个 L0 sstable, 读取元数据时不触发 compaction
+            for(int phase = 0; phase < phase_count; phase++) {
+                auto table = test.GenerateTable(options);
+                if(phase > 0) {
+                    std::ifstream manifest_file("manifest");
+                    ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                    table->ReadMetaData(manifest_file, false);
+                }
+                for(int i = 0; i < timestamp_count; i++) {
+                    auto wr = test.GenerateWriteRequest(0, vin_count, phase * timestamp_count + i);
+                    ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+                }
+                table->Shutdown();
+                options->bg_task_->WaitForEmptyQueue();
+
+                std::ofstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->WriteMetaData(manifest_file);
+                manifest_file.close();
+                table->EraseLogFile();
+                delete table;
+            }
+
+            auto table = test.GenerateTable(options);
+            std::ifstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->ReadMetaData(manifest_file, false);
+            ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), phase_count);
+            auto l0_size = table->TestGetTableMetaData().TotalFileSize(0);
+
+            auto start_time = std::chrono::high_resolution_clock::now();
+            table->ScheduleCompaction();
+            options->bg_task_->WaitForEmptyQueue();
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+            std::string levels;
+            for(int level = 0; level < K_NUM_LEVELS; level++) {
+                levels += " " + std::to_string(table->TestGetTableMetaData().GetFileMetaData(level).size());
+            }
+            LOG_INFO("compaction threads = %d, subcompactions = %d, l0 size = %lu KB, catch-up time = %ld ms, files per level:%s",
+                     thread_count, thread_count, l0_size / 1024, duration, levels.c_str());
+            ASSERT_LT(table->TestGetTableMetaData().GetFileMetaData(0).size(), K_L0_COMPACTION_TRIGGER);
+
+            // 每层 (除 L0 外) 的文件互不重叠
+            for(int level = 1; level < K_NUM_LEVELS; level++) {
+                auto files = table->TestGetTableMetaData().GetFileMetaData(level);
+                for(size_t i = 1; i < files.size(); i++) {
+                    ASSERT_TRUE(files[i - 1]->GetLargest() < files[i]->GetSmallest());
+                }
+            }
+
+            for(int key = 0; key < vin_count; key += 97) {
+                auto rq = test.GenerateTimeRangeQueryRequest(key, 0, phase_count * timestamp_count);
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+                test.CheckRangeQuery(results, rq, true);
+            }
+
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+            table->EraseSSTableFile();
+            table->EraseLogFile();
+            delete table;
+        }
+    }
+
+    // 每个阶段覆盖写入相同的 key, flush 与 compaction 只保留最新的版本
+    TEST(CompactionTest, DropShadowedVersions) {
+        const int phase_count = K_L0_COMPACTION_TRIGGER;
+        const int vin_count = 500;
+        const int timestamp_count = 10;
+
+        auto options = NewDBOptions();
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        for(int phase = 0; phase < phase_count; phase++) {
+            auto table = test.GenerateTable(options);
+            if(phase > 0) {
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->ReadMetaData(manifest_file, false);
+            }
+            // 同一个 memtable 中也存在被覆盖的版本
+            for(int round = 0; round < 2; round++) {
+                for(int i = 0; i < timestamp_count; i++) {
+                    auto wr = test.GenerateWriteRequest(0, vin_count, i);
+                    ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+                }
+            }
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+            delete table;
+        }
+
+        auto table = test.GenerateTable(options);
+        std::ifstream manifest_file("manifest");
+        ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+        table->ReadMetaData(manifest_file, false);
+        table->ScheduleCompaction();
+        options->bg_task_->WaitForEmptyQueue();
+        ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), 0);
+
+        int count = 0;
+        for(auto &file : table->TestGetTableMetaData().GetFileMetaData(1)) {
+            auto iter = options->table_cache_->NewTableIterator(file);
+            for(iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                count++;
+            }
+        }
+        ASSERT_EQ(count, vin_count * timestamp_count);
+
+        for(int key = 0; key < vin_count; key += 7) {
+            auto rq = test.GenerateTimeRangeQueryRequest(key, 0, timestamp_count);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+            test.CheckRangeQuery(results, rq, true);
+        }
+
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseSSTableFile();
+        table->EraseLogFile();
+        delete table;
+    }
+
+    // 按时间顺序写入, 比较 leveled compaction 与 time window compaction 的写放大
+    TEST(CompactionTest, TimeWindowCompaction) {
+        const int phase_count = 3 * K_L0_COMPACTION_TRIGGER;
+        const int vin_count = 2000;
+        const int timestamp_count = 10;
+        const int64_t time_window_size = 2 * timestamp_count;
+
+        uint64_t bytes_written[2]{};
+        for(auto style : {LeveledCompaction, TimeWindowCompaction}) {
+            auto options = NewDBOptions();
+            options->compaction_style_ = style;
+            options->time_window_size_ = time_window_size;
+            TestTableOperator test("test", TestSchemaType::Complex);
+
+            // 每个阶段写入新的时间范围, 打开时触发 compaction
+            for(int phase = 0; phase < phase_count; phase++) {
+                auto table = test.GenerateTable(options);
+                if(phase > 0) {
+                    std::ifstream manifest_file("manifest");
+                    ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                    table->ReadMetaData(manifest_file);
+                }
+                for(int i = 0; i < timestamp_count; i++) {
+                    auto wr = test.GenerateWriteRequest(0, vin_count, phase * timestamp_count + i);
+                    ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+                }
+                table->Shutdown();
+                options->bg_task_->WaitForEmptyQueue();
+                bytes_written[style] += table->TestGetCompactionBytesWritten();
+
+                std::ofstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->WriteMetaData(manifest_file);
+                manifest_file.close();
+                table->EraseLogFile();
+                delete table;
+            }
+
+            auto table = test.GenerateTable(options);
+            std::ifstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->ReadMetaData(manifest_file);
+            options->bg_task_->WaitForEmptyQueue();
+            bytes_written[style] += table->TestGetCompactionBytesWritten();
+
+            uint64_t total_size = 0;
+            for(int level = 0; level < K_NUM_LEVELS; level++) {
+                total_size += table->TestGetTableMetaData().TotalFileSize(level);
+            }
+            LOG_INFO("compaction style = %s, data size = %lu KB, compaction bytes written = %lu KB",
+                     style == LeveledCompaction ? "leveled" : "time window", total_size / 1024,
+                     bytes_written[style] / 1024);
+
+            if(style == TimeWindowCompaction) {
+                // 所有文件位于 L0, 每个文件只包含一个窗口的数据, 旧的窗口已经合并为一个 sorted run
+                auto files = table->TestGetTableMetaData().GetFileMetaData(0);
+                std::map<int64_t, std::set<file_number_t>> runs;
+                std::map<int64_t, size_t> window_files;
+                for(auto &file : files) {
+                    ASSERT_EQ(file->min_timestamp_ / time_window_size, file->max_timestamp_ / time_window_size);
+                    runs[file->max_timestamp_ / time_window_size].insert(file->sequence_);
+                    window_files[file->max_timestamp_ / time_window_size]++;
+                }
+                for(int level = 1; level < K_NUM_LEVELS; level++) {
+                    ASSERT_TRUE(table->TestGetTableMetaData().GetFileMetaData(level).empty());
+                }
+                for(auto it = runs.begin(); std::next(it) != runs.end(); it++) {
+                    ASSERT_EQ(it->second.size(), 1);
+                }
+
+                // 查询一个窗口时只读取该窗口的文件
+                auto probes = table->TestGetSSTableProbeCount();
+                auto rq = test.GenerateTimeRangeQueryRequest(7, time_window_size, 2 * time_window_size);
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+                test.CheckRangeQuery(results, rq, true);
+                ASSERT_LE(table->TestGetSSTableProbeCount() - probes, window_files[1]);
+            }
+
+            for(int key = 0; key < vin_count; key += 97) {
+                auto rq = test.GenerateTimeRangeQueryRequest(key, 0, phase_count * timestamp_count);
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+                test.CheckRangeQuery(results, rq, true);
+            }
+
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+            table->EraseSSTableFile();
+            table->EraseLogFile();
+            delete table;
+        }
+        ASSERT_LT(bytes_written[TimeWindowCompaction], bytes_written[LeveledCompaction]);
+    }
+
+    // 两个重叠的 memtable 同时 flush 且新的先完成, 旧的 flush 完成前 L0 compaction 不选择新的文件
+    TEST(CompactionTest, OutOfOrderFlush) {
+        auto new_file = [](file_number_t sequence) {
+            return std::make_shared<FileMetaData>(sequence, InternalKey(GenerateVin(0), 100),
+                                                  InternalKey(GenerateVin(100), 0), 1024, 0, 100);
+        };
+
+        TableMetaData meta_data;
+        for(file_number_t sequence = 1; sequence < K_L0_COMPACTION_TRIGGER; sequence++) {
+            meta_data.AddFileMetaData(0, {new_file(sequence)});
+        }
+
+        // memtable 10 与 11 正在 flush, 11 先完成
+        const file_number_t older = 10;
+        const file_number_t newer = 11;
+        meta_data.AddFileMetaData(0, {new_file(newer)});
+        meta_data.Finalize();
+
+        auto task = meta_data.GenerateCompactionTask(older);
+        ASSERT_NE(task, nullptr);
+        ASSERT_EQ(task->input_files_[0].size(), K_L0_COMPACTION_TRIGGER - 1);
+        file_number_t output_sequence = 0;
+        for(auto &file : task->input_files_[0]) {
+            ASSERT_LT(file->sequence_, older);
+            output_sequence = std::max(output_sequence, file->sequence_);
+        }
+
+        // compaction 完成后 10 的 flush 才完成
+        meta_data.ReleaseCompactionTask(task);
+        meta_data.RemoveFileMetaData(0, task->input_files_[0]);
+        auto output = new_file(20);
+        output->sequence_ = output_sequence;
+        meta_data.AddFileMetaData(1, {output});
+        delete task;
+        meta_data.AddFileMetaData(0, {new_file(older)});
+        meta_data.Finalize();
+
+        // L0 中的数据都比 L1 中重叠的数据新
+        for(auto &file : meta_data.GetFileMetaData(0)) {
+            ASSERT_GT(file->sequence_, output_sequence);
+        }
+
+        // 没有正在执行的 flush 时两个文件都可以合并
+        meta_data.AddFileMetaData(0, {new_file(12), new_file(13)});
+        meta_data.Finalize();
+        task = meta_data.GenerateCompactionTask();
+        ASSERT_NE(task, nullptr);
+        std::set<file_number_t> inputs;
+        for(auto &file : task->input_files_[0]) {
+            inputs.insert(file->sequence_);
+        }
+        ASSERT_EQ(inputs.count(older), 1);
+        ASSERT_EQ(inputs.count(newer), 1);
+        meta_data.ReleaseCompactionTask(task);
+        delete task;
+    }
+
+    // L0 积压超过一次 compaction 的大小上限时, 重叠的旧文件先进入 L1, 留在 L0 的数据都比 L1 中的新
+    TEST(CompactionTest, L0Backlog) {
+        // 越新的文件 smallest 越小, 按 key 选择时会先选中最新的文件
+        const file_number_t file_count = K_L0_COMPACTION_TRIGGER + 2;
+        TableMetaData meta_data;
+        for(file_number_t sequence = 1; sequence <= file_count; sequence++) {
+            meta_data.AddFileMetaData(0, {std::make_shared<FileMetaData>(
+                    sequence, InternalKey(GenerateVin(500 - sequence * 10), 100), InternalKey(GenerateVin(900), 0),
+                    MAX_FILE_SIZE, 0, 100)});
+        }
+        meta_data.Finalize();
+
+        auto task = meta_data.GenerateCompactionTask();
+        ASSERT_NE(task, nullptr);
+        ASSERT_EQ(task->input_files_[0].size(), 2);
+        std::set<file_number_t> inputs;
+        for(auto &file : task->input_files_[0]) {
+            inputs.insert(file->sequence_);
+        }
+        ASSERT_EQ(inputs, (std::set<file_number_t>{1, 2}));
+
+        // 输出覆盖所有输入的 key 范围
+        meta_data.ReleaseCompactionTask(task);
+        meta_data.RemoveFileMetaData(0, task->input_files_[0]);
+        auto output = std::make_shared<FileMetaData>(file_count + 1, InternalKey(GenerateVin(480), 100),
+                                                     InternalKey(GenerateVin(900), 0), MAX_FILE_SIZE, 0, 100, 2);
+        meta_data.AddFileMetaData(1, {output});
+        delete task;
+        meta_data.Finalize();
+
+        for(auto &file : meta_data.GetFileMetaData(0)) {
+            ASSERT_GT(file->sequence_, output->sequence_);
+        }
+
+        // 下一次 compaction 继续选择最旧的文件
+        task = meta_data.GenerateCompactionTask();
+        ASSERT_NE(task, nullptr);
+        inputs.clear();
+        for(auto &file : task->input_files_[0]) {
+            inputs.insert(file->sequence_);
+        }
+        ASSERT_EQ(inputs, (std::set<file_number_t>{3, 4}));
+        ASSERT_EQ(task->input_files_[1].size(), 1);
+        meta_data.ReleaseCompactionTask(task);
+        delete task;
+    }
+
+} // namespace LindormContest
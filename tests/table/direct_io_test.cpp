@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include "db/db_options.h"
+#include "disk/disk_manager.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 进程常驻内存, 单位 KB
+    static auto GetResidentSize() -> uint64_t {
+        std::ifstream statm("/proc/self/statm");
+        uint64_t size = 0, resident = 0;
+        statm >> size >> resident;
+        return resident * ::sysconf(_SC_PAGESIZE) / 1024;
+    }
+
+    // 系统 page cache 大小, 单位 KB
+    static auto GetPageCacheSize() -> uint64_t {
+        std::ifstream meminfo("/proc/meminfo");
+        std::string name;
+        uint64_t value;
+        std::string unit;
+        while(meminfo >> name >> value >> unit) {
+            if(name == "Cached:") {
+                return value;
+            }
+        }
+        return 0;
+    }
+
+    // 后台 compaction 期间持续执行 range query, 比较普通读写与 O_DIRECT 的内存占用与 p99 延迟
+    // block cache 小于数据量, block cache 的内存占用不超过容量
+    TEST(DirectIOTest, RangeQueryDuringCompaction) {
+        const int phase_count = K_L0_COMPACTION_TRIGGER;
+        const int vin_count = 2000;
+        const uint64_t block_cache_size = 4 << 20;
+
+        for(bool direct_io : {false, true}) {
+            auto options = NewDBOptions();
+            options->use_direct_io_ = direct_io;
+            delete options->block_cache_;
+            options->block_cache_ = new Cache<Block>(block_cache_size);
+            TestTableOperator test("test", TestSchemaType::Complex);
+
+            // 每个阶段生成一个 L0 sstable, 关闭时不会触发 compaction
+            for(int phase = 0; phase < phase_count; phase++) {
+                auto table = test.GenerateTable(options);
+                if(phase > 0) {
+                    std::ifstream manifest_file("manifest");
+                    ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                    table->ReadMetaData(manifest_file);
+                }
+                for(int i = 0; i < 20; i++) {
+                    auto wr = test.GenerateWriteRequest(0, vin_count, phase * 20 + i);
+                    ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+                }
+                table->Shutdown();
+                options->bg_task_->WaitForEmptyQueue();
+
+                std::ofstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->WriteMetaData(manifest_file);
+                manifest_file.close();
+                table->EraseLogFile();
+                delete table;
+            }
+
+            auto rss_before = GetResidentSize();
+            auto cached_before = GetPageCacheSize();
+
+            // 读取 manifest 后 L0 达到阈值, 在后台开始 compaction
+            auto table = test.GenerateTable(options);
+            std::ifstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->ReadMetaData(manifest_file);
+
+            std::atomic<bool> compaction_done{false};
+            std::vector<int64_t> latencies;
+            std::thread reader([&]() {
+                while(!compaction_done.load() || latencies.size() < 200) {
+                    auto rq = test.GenerateTimeRangeQueryRequest(rand() % vin_count, 0, phase_count * 20);
+                    auto start_time = std::chrono::high_resolution_clock::now();
+                    std::vector<Row> results;
+                    ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+                    auto end_time = std::chrono::high_resolution_clock::now();
+                    latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+                    test.CheckRangeQuery(results, rq, true);
+                }
+            });
+            options->bg_task_->WaitForEmptyQueue();
+            compaction_done.store(true);
+            reader.join();
+
+            // compaction 之后的结果不变
+            ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), 0);
+            for(int key = 0; key < vin_count; key += 7) {
+                auto rq = test.GenerateTimeRangeQueryRequest(key, 0, phase_count * 20);
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+                test.CheckRangeQuery(results, rq, true);
+            }
+
+            uint64_t data_size = 0;
+            for(int level = 0; level < K_NUM_LEVELS; level++) {
+                for(auto &file : table->TestGetTableMetaData().GetFileMetaData(level)) {
+                    data_size += file->GetFileSize();
+                }
+            }
+            auto rss_after = GetResidentSize();
+            auto cached_after = GetPageCacheSize();
+            auto block_cache_usage = options->block_cache_->GetUsage();
+            std::sort(latencies.begin(), latencies.end());
+            LOG_INFO("direct io = %d, %zu range queries, p50 = %ld us, p99 = %ld us, sstables = %lu KB, "
+                     "block cache = %lu / %lu KB, rss = %lu -> %lu KB, page cache delta = %ld KB",
+                     direct_io, latencies.size(), latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+                     data_size / 1024, block_cache_usage / 1024, block_cache_size / 1024, rss_before, rss_after,
+                     static_cast<int64_t>(cached_after) - static_cast<int64_t>(cached_before));
+            ASSERT_LE(block_cache_usage, block_cache_size);
+
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+            table->EraseSSTableFile();
+            table->EraseLogFile();
+            delete table;
+        }
+    }
+
+} // namespace LindormContest
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include "db/db_options.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // latest index 与逐层查找的结果一致, 并且在元数据持久化后仍然有效
+    TEST(LatestIndexTest, MatchScanAndRecover) {
+        auto options = NewDBOptions();
+        options->table_shard_count_ = 2;
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        {
+            auto table = test.GenerateTable(options);
+            for(int i = 0; i < 300; i++) {
+                auto wr = test.GenerateWriteRequest(rand() % 500, 50, rand() % 1000);
+                ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+            }
+            options->bg_task_->WaitForEmptyQueue();
+
+            auto qr = test.GenerateLatestQueryRequest(0, 600);
+            std::vector<Row> index_results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, index_results), 0) << "ExecuteLatestQuery failed";
+            test.CheckLastQuery(index_results, qr, true);
+
+            options->use_latest_index_ = false;
+            std::vector<Row> scan_results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, scan_results), 0) << "ExecuteLatestQuery failed";
+            options->use_latest_index_ = true;
+            std::sort(index_results.begin(), index_results.end());
+            std::sort(scan_results.begin(), scan_results.end());
+            ASSERT_EQ(index_results, scan_results);
+            for(size_t i = 0; i < index_results.size(); i++) {
+                ASSERT_EQ(index_results[i].columns, scan_results[i].columns);
+            }
+
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+        }
+
+        {
+            std::ifstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            auto table = test.GenerateTable(options);
+            table->ReadMetaData(manifest_file);
+
+            auto qr = test.GenerateLatestQueryRequest(0, 600);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            test.CheckLastQuery(results, qr, true);
+
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+            table->EraseSSTableFile();
+        }
+    }
+
+    // latest index 与逐层查找的查询耗时
+    TEST(LatestIndexTest, QueryLatency) {
+        auto options = NewDBOptions();
+        TestTableOperator test("test", TestSchemaType::Basic);
+        auto table = test.GenerateTable(options);
+
+        for(int i = 0; i < 200; i++) {
+            auto wr = test.GenerateWriteRequest(0, 1000, i);
+            ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+        }
+        options->bg_task_->WaitForEmptyQueue();
+
+        auto qr = test.GenerateLatestQueryRequest(0, 1000);
+        for(bool use_index : {false, true}) {
+            options->use_latest_index_ = use_index;
+            auto start_time = std::chrono::high_resolution_clock::now();
+            for(int i = 0; i < 10; i++) {
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+                ASSERT_EQ(results.size(), 1000U);
+            }
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+            LOG_INFO("use latest index = %d, 1000 vins per query, avg latency = %ld us", use_index, duration / 10);
+        }
+
+        table->Shutdown();
+        table->EraseLogFile();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseSSTableFile();
+    }
+
+} // namespace LindormContest
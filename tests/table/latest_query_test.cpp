@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <set>
+#include "db/db_options.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 逐层查找 latest query 时请求中的 vin 乱序且重复, L1 及以上每层每个 vin 最多查找一个文件
+    TEST(LatestQueryTest, SortedSweep) {
+        const int phase_count = 2 * K_L0_COMPACTION_TRIGGER;
+        const int vin_count = 10000;
+        const int timestamp_count = 5;
+
+        auto options = NewDBOptions();
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        for(int phase = 0; phase < phase_count; phase++) {
+            auto table = test.GenerateTable(options);
+            if(phase > 0) {
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->ReadMetaData(manifest_file, false);
+            }
+            for(int i = 0; i < timestamp_count; i++) {
+                auto wr = test.GenerateWriteRequest(0, vin_count, phase * timestamp_count + i);
+                ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+            }
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+            delete table;
+        }
+
+        options->use_latest_index_ = false;
+        options->use_bloom_filter_ = false;
+        auto table = test.GenerateTable(options);
+        std::ifstream manifest_file("manifest");
+        ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+        table->ReadMetaData(manifest_file, false);
+        table->ScheduleCompaction();
+        options->bg_task_->WaitForEmptyQueue();
+
+        auto &meta_data = table->TestGetTableMetaData();
+        size_t l0_files = meta_data.GetFileMetaData(0).size();
+        size_t levels = 0;
+        size_t total_files = l0_files;
+        for(int level = 1; level < K_NUM_LEVELS; level++) {
+            auto files = meta_data.GetFileMetaData(level);
+            levels += !files.empty();
+            total_files += files.size();
+        }
+        ASSERT_GT(total_files, l0_files + levels);
+
+        std::mt19937 rng(0);
+        for(int count : {100, 1000, 10000}) {
+            auto qr = test.GenerateLatestQueryRequest(0, count);
+            qr.vins.insert(qr.vins.end(), qr.vins.begin(), qr.vins.begin() + count / 10);
+            std::shuffle(qr.vins.begin(), qr.vins.end(), rng);
+
+            auto probes = table->TestGetSSTableProbeCount();
+            auto start_time = std::chrono::high_resolution_clock::now();
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+            probes = table->TestGetSSTableProbeCount() - probes;
+
+            LOG_INFO("%d vins, %zu sstables, sstable probes = %lu, latency = %ld us", count, total_files, probes, duration);
+            test.CheckLastQuery(results, qr, true);
+            ASSERT_LE(probes, static_cast<uint64_t>(count) * (l0_files + levels));
+        }
+
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseSSTableFile();
+    }
+
+} // namespace LindormContest
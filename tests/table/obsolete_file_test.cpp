@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include "db/db_options.h"
+#include "db/manifest.h"
+#include "disk/disk_manager.h"
+#include "test_util.h"
+#include "table_operator.h"
+
+namespace LindormContest {
+
+    static auto SSTableExists(file_number_t file_number) -> bool {
+        for(auto &name : DiskManager::GetChildren()) {
+            if("/" + name == GET_SSTABLE_NAME(file_number)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // compaction 的输入文件在最后一个引用释放后立即删除, 并从 block cache 中移除
+    TEST(ObsoleteFileTest, DeleteAfterLastReference) {
+        const int phase_count = K_L0_COMPACTION_TRIGGER;
+        const int vin_count = 200;
+
+        auto options = NewDBOptions();
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        // 每个阶段生成一个 L0 sstable
+        for(int phase = 0; phase < phase_count; phase++) {
+            auto table = test.GenerateTable(options);
+            if(phase > 0) {
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->ReadMetaData(manifest_file);
+            }
+            for(int i = 0; i < 20; i++) {
+                auto wr = test.GenerateWriteRequest(0, vin_count, phase * 20 + i);
+                ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+            }
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+            delete table;
+        }
+
+        // compaction 的结果写入 manifest_log 后才能删除输入文件
+        Manifest manifest;
+        manifest.Recover([](ManifestRecordType, const std::string &, std::string_view) {});
+        options->manifest_ = &manifest;
+
+        auto table = test.GenerateTable(options);
+        std::ifstream manifest_file("manifest");
+        ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+        table->ReadMetaData(manifest_file, false);
+
+        auto inputs = table->TestGetTableMetaData().GetFileMetaData(0);
+        ASSERT_EQ(inputs.size(), phase_count);
+        std::vector<file_number_t> input_numbers;
+        for(auto &file : inputs) {
+            input_numbers.push_back(file->GetFileNumber());
+        }
+        auto pinned = inputs[0];
+        auto pinned_number = pinned->GetFileNumber();
+        auto iter = options->table_cache_->NewTableIterator(pinned);
+        iter->SeekToFirst();
+        ASSERT_TRUE(iter->Valid());
+        inputs.clear();
+
+        table->ScheduleCompaction();
+        options->bg_task_->WaitForEmptyQueue();
+        ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), 0);
+
+        // 没有引用的输入文件已经删除, 仍被引用的文件保留且迭代器可以继续读取
+        for(size_t i = 1; i < input_numbers.size(); i++) {
+            ASSERT_FALSE(SSTableExists(input_numbers[i]));
+        }
+        ASSERT_TRUE(SSTableExists(pinned_number));
+        int count = 0;
+        for(; iter->Valid(); iter->Next()) {
+            count++;
+        }
+        ASSERT_GT(count, 0);
+
+        iter.reset();
+        pinned.reset();
+        ASSERT_FALSE(SSTableExists(pinned_number));
+        ASSERT_EQ(options->block_cache_->Lookup(static_cast<cache_id_t>(pinned_number) << 32), nullptr);
+
+        // 不在 TableCache 中的 sstable 不会为了移除 block 被重新打开, 文件已经不存在也不抛出异常
+        FileMetaData uncached;
+        uncached.file_number_ = pinned_number;
+        ASSERT_NO_THROW(options->table_cache_->EvictSSTable(uncached));
+
+        for(auto &file : table->TestGetTableMetaData().GetFileMetaData(1)) {
+            ASSERT_TRUE(SSTableExists(file->GetFileNumber()));
+        }
+
+        for(int key = 0; key < vin_count; key += 7) {
+            auto rq = test.GenerateTimeRangeQueryRequest(key, 0, phase_count * 20);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+            test.CheckRangeQuery(results, rq, true);
+        }
+
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseLogFile();
+        delete table;
+        DiskManager::RemoveFile(MANIFEST_LOG_NAME);
+    }
+
+} // namespace LindormContest
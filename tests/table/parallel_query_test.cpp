@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include "db/db_options.h"
+#include "db/query_executor.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 多个调用线程同时提交子任务, 每个子任务恰好执行一次, 异常在调用线程重新抛出
+    TEST(ParallelQueryTest, QueryExecutor) {
+        QueryExecutor executor(4);
+        std::vector<std::thread> callers;
+        std::atomic<int> failures{0};
+        for(int t = 0; t < 4; t++) {
+            callers.emplace_back([&] {
+                for(int round = 0; round < 100; round++) {
+                    std::vector<std::atomic<int>> runs(1 + round % 16);
+                    executor.Run(runs.size(), [&](size_t i) { runs[i].fetch_add(1); });
+                    for(auto &run : runs) {
+                        if(run.load() != 1) {
+                            failures++;
+                        }
+                    }
+                }
+            });
+        }
+        for(auto &caller : callers) {
+            caller.join();
+        }
+        ASSERT_EQ(failures.load(), 0);
+
+        std::atomic<int> done{0};
+        ASSERT_THROW(executor.Run(8, [&](size_t i) {
+            done++;
+            if(i == 5) {
+                throw std::runtime_error("query failed");
+            }
+        }), std::runtime_error);
+        ASSERT_EQ(done.load(), 8);
+
+        QueryExecutor serial(0);
+        size_t sum = 0;
+        serial.Run(10, [&](size_t i) { sum += i; });
+        ASSERT_EQ(sum, 45);
+    }
+
+    // 时间窗口划分出多个 sstable, 比较不同查询线程数量下逐层 latest query 与跨窗口范围查询的延迟
+    TEST(ParallelQueryTest, WorkerLatency) {
+        const int phase_count = K_L0_COMPACTION_TRIGGER;
+        const int vin_count = 5000;
+        const int timestamp_count = 20;
+
+        auto options = NewDBOptions();
+        options->compaction_style_ = TimeWindowCompaction;
+        options->time_window_size_ = timestamp_count;
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        for(int phase = 0; phase < phase_count; phase++) {
+            auto table = test.GenerateTable(options);
+            if(phase > 0) {
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->ReadMetaData(manifest_file, false);
+            }
+            for(int i = 0; i < timestamp_count; i++) {
+                auto wr = test.GenerateWriteRequest(0, vin_count, phase * timestamp_count + i);
+                ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+            }
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+            delete table;
+        }
+
+        options->use_latest_index_ = false;
+        auto table = test.GenerateTable(options);
+        std::ifstream manifest_file("manifest");
+        ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+        table->ReadMetaData(manifest_file, false);
+        ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), phase_count);
+
+        std::vector<Row> expected_latest;
+        std::vector<Row> expected_range;
+        for(int workers : {1, 4, 16}) {
+            auto executor = std::make_unique<QueryExecutor>(workers);
+            options->query_executor_ = executor.get();
+            options->max_query_parallelism_ = workers;
+
+            auto qr = test.GenerateLatestQueryRequest(0, vin_count);
+            std::vector<Row> latest_results;
+            auto start_time = std::chrono::high_resolution_clock::now();
+            for(int i = 0; i < 5; i++) {
+                latest_results.clear();
+                ASSERT_EQ(table->ExecuteLatestQuery(qr, latest_results), 0) << "ExecuteLatestQuery failed";
+            }
+            auto latest_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - start_time).count() / 5;
+            test.CheckLastQuery(latest_results, qr, true);
+
+            std::vector<Row> range_results;
+            start_time = std::chrono::high_resolution_clock::now();
+            for(int key = 0; key < vin_count; key += 50) {
+                auto rq = test.GenerateTimeRangeQueryRequest(key, 0, phase_count * timestamp_count);
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+                test.CheckRangeQuery(results, rq, true);
+                range_results.insert(range_results.end(), results.begin(), results.end());
+            }
+            auto range_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - start_time).count();
+
+            LOG_INFO("query workers = %d, latest query of %d vins = %ld us, %d range queries over %d sstables = %ld us",
+                     workers, vin_count, latest_time, vin_count / 50, phase_count, range_time);
+
+            std::sort(range_results.begin(), range_results.end());
+            if(workers == 1) {
+                expected_latest = std::move(latest_results);
+                expected_range = std::move(range_results);
+            } else {
+                ASSERT_EQ(latest_results, expected_latest);
+                ASSERT_EQ(range_results, expected_range);
+            }
+            options->query_executor_ = nullptr;
+        }
+
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseSSTableFile();
+    }
+
+} // namespace LindormContest
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include "db/db_options.h"
+#include "test_util.h"
+#include "table_operator.h"
+
+namespace LindormContest {
+
+    // 全部过期的文件直接删除, 部分过期的文件在 compaction 时删除过期的行
+    TEST(RetentionTest, DropExpiredData) {
+        const int phase_count = K_L0_COMPACTION_TRIGGER + 1;
+        const int vin_count = 500;
+        const int timestamp_count = 10;
+        const int64_t newest_timestamp = phase_count * timestamp_count - 1;
+        const int64_t expire_timestamp = timestamp_count + timestamp_count / 2;
+
+        auto options = NewDBOptions();
+        options->retention_["test"] = newest_timestamp - expire_timestamp;
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        // 每个阶段生成一个 L0 sstable, 第一个 sstable 全部过期, 第二个部分过期
+        for(int phase = 0; phase < phase_count; phase++) {
+            auto table = test.GenerateTable(options);
+            if(phase > 0) {
+                std::ifstream manifest_file("manifest");
+                ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+                table->ReadMetaData(manifest_file, false);
+            }
+            for(int i = 0; i < timestamp_count; i++) {
+                auto wr = test.GenerateWriteRequest(0, vin_count, phase * timestamp_count + i);
+                ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+            }
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+            delete table;
+        }
+
+        // 重新打开时根据 sstable 的时间戳恢复过期时间
+        auto table = test.GenerateTable(options);
+        std::ifstream manifest_file("manifest");
+        ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+        table->ReadMetaData(manifest_file, false);
+        ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), phase_count);
+
+        // 过期的数据在 compaction 前已经不会被查询到
+        {
+            auto rq = test.GenerateTimeRangeQueryRequest(3, 0, expire_timestamp);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+            ASSERT_TRUE(results.empty());
+        }
+
+        table->ScheduleCompaction();
+        options->bg_task_->WaitForEmptyQueue();
+        ASSERT_EQ(table->TestGetTableMetaData().GetFileMetaData(0).size(), 0);
+
+        int count = 0;
+        for(auto &file : table->TestGetTableMetaData().GetFileMetaData(1)) {
+            ASSERT_GE(file->min_timestamp_, expire_timestamp);
+            auto iter = options->table_cache_->NewTableIterator(file);
+            for(iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                ASSERT_GE(iter->GetKey().timestamp_, expire_timestamp);
+                count++;
+            }
+        }
+        ASSERT_EQ(count, vin_count * (newest_timestamp + 1 - expire_timestamp));
+
+        for(int key = 0; key < vin_count; key += 7) {
+            auto rq = test.GenerateTimeRangeQueryRequest(key, expire_timestamp, newest_timestamp + 1);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+            test.CheckRangeQuery(results, rq, true);
+        }
+
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseSSTableFile();
+        table->EraseLogFile();
+        delete table;
+    }
+
+    // 一个 shard 中写入远超当前时间的时间戳时, 过期时间以当前时间为基准, 其它数据不会过期
+    // 所有 shard 使用表中相同的过期时间
+    TEST(RetentionTest, OutlierTimestamp) {
+        const int vin_count = 500;
+        const int timestamp_count = 10;
+        const int64_t retention = 24 * 3600 * 1000LL;
+        const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        const int64_t base_timestamp = now - 3600 * 1000LL;
+        const int64_t outlier_timestamp = now + 10 * 365 * retention;
+
+        auto options = NewDBOptions();
+        options->retention_["test"] = retention;
+        options->table_shard_count_ = 4;
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        auto table = test.GenerateTable(options);
+        for(int i = 0; i < timestamp_count; i++) {
+            auto wr = test.GenerateWriteRequest(0, vin_count, base_timestamp + i * 1000);
+            ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+        }
+        auto wr = test.GenerateWriteRequest(0, 1, outlier_timestamp);
+        ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+
+        std::ofstream manifest_file("manifest");
+        ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+        table->WriteMetaData(manifest_file);
+        manifest_file.close();
+        table->EraseLogFile();
+        delete table;
+
+        // 重新打开时从 sstable 恢复最大时间戳并触发 compaction
+        table = test.GenerateTable(options);
+        std::ifstream read_file("manifest");
+        ASSERT_EQ(read_file.is_open(), true) << "manifest file not found";
+        table->ReadMetaData(read_file);
+        options->bg_task_->WaitForEmptyQueue();
+
+        size_t file_count = 0;
+        for(uint32_t shard = 0; shard < table->GetShardCount(); shard++) {
+            file_count += table->TestGetTableMetaData(shard).GetFileMetaData(0).size();
+        }
+        ASSERT_EQ(file_count, table->GetShardCount());
+
+        for(int key = 0; key < vin_count; key += 7) {
+            auto rq = test.GenerateTimeRangeQueryRequest(key, base_timestamp, outlier_timestamp + 1);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, results), 0) << "ExecuteTimeRangeQuery failed";
+            ASSERT_EQ(results.size(), key == 0 ? timestamp_count + 1 : timestamp_count);
+            test.CheckRangeQuery(results, rq, true);
+        }
+        auto qr = test.GenerateLatestQueryRequest(0, vin_count);
+        std::vector<Row> results;
+        ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+        test.CheckLastQuery(results, qr, true);
+
+        table->Shutdown();
+        options->bg_task_->WaitForEmptyQueue();
+        table->EraseSSTableFile();
+        table->EraseLogFile();
+        delete table;
+    }
+
+} // namespace LindormContest
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include "db/db_options.h"
+#include "test_util.h"
+#include "table_operator.h"
+#include "common/logger.h"
+
+namespace LindormContest {
+
+    // 多个 shard 下写入、元数据持久化后查询的正确性
+    TEST(ShardTest, WriteAndRecover) {
+        auto options = NewDBOptions();
+        options->table_shard_count_ = 4;
+        TestTableOperator test("test", TestSchemaType::Complex);
+
+        {
+            auto table = test.GenerateTable(options);
+            ASSERT_EQ(table->GetShardCount(), 4U);
+
+            std::vector<std::thread> threads;
+            for(int t = 0; t < 4; t++) {
+                threads.emplace_back([&, t]() {
+                    for(int i = 0; i < 50; i++) {
+                        auto wr = test.GenerateWriteRequest(t * 50, 50, i);
+                        ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+                    }
+                });
+            }
+            for(auto &t : threads) {
+                t.join();
+            }
+
+            auto qr = test.GenerateLatestQueryRequest(0, 200);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            test.CheckLastQuery(results, qr, true);
+
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+
+            std::ofstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            table->WriteMetaData(manifest_file);
+            manifest_file.close();
+            table->EraseLogFile();
+        }
+
+        {
+            // shard 数量以 manifest 为准
+            options->table_shard_count_ = 1;
+            std::ifstream manifest_file("manifest");
+            ASSERT_EQ(manifest_file.is_open(), true) << "manifest file not found";
+            auto table = test.GenerateTable(options);
+            table->ReadMetaData(manifest_file);
+            ASSERT_EQ(table->GetShardCount(), 4U);
+
+            auto qr = test.GenerateLatestQueryRequest(0, 200);
+            std::vector<Row> results;
+            ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+            test.CheckLastQuery(results, qr, true);
+
+            for(int key = 0; key < 200; key += 13) {
+                auto rq = test.GenerateTimeRangeQueryRequest(key, 0, 50);
+                std::vector<Row> range_results;
+                ASSERT_EQ(table->ExecuteTimeRangeQuery(rq, range_results), 0) << "ExecuteRangeQuery failed";
+                test.CheckRangeQuery(range_results, rq, true);
+            }
+
+            table->Shutdown();
+            options->bg_task_->WaitForEmptyQueue();
+            table->EraseSSTableFile();
+        }
+    }
+
+    // 不同写线程数与 shard 数量下的写入吞吐量
+    // 关闭 WAL 的 fdatasync, 只比较 shard 锁竞争的开销
+    TEST(ShardTest, WriteScaling) {
+        const int rows_per_thread = 1000;
+
+        for(uint32_t shard_count : {1U, 4U, 16U}) {
+            for(int thread_count : {1, 4, 16, 64}) {
+                auto options = NewDBOptions();
+                options->table_shard_count_ = shard_count;
+                options->sync_wal_ = false;
+                TestTableOperator test("test", TestSchemaType::Basic);
+                auto table = test.GenerateTable(options);
+
+                // 提前生成写请求, 避免 TestTableOperator 的锁影响测试结果
+                const int write_count = rows_per_thread / 20;
+                std::vector<std::vector<WriteRequest>> requests(thread_count);
+                for(int t = 0; t < thread_count; t++) {
+                    for(int i = 0; i < write_count; i++) {
+                        // 每个请求的 vin 分散在多个 shard 上
+                        requests[t].push_back(test.GenerateWriteRequest(t * 20, 20, i));
+                    }
+                }
+
+                auto start_time = std::chrono::high_resolution_clock::now();
+                std::vector<std::thread> threads;
+                for(int t = 0; t < thread_count; t++) {
+                    threads.emplace_back([&, t]() {
+                        for(auto &wr : requests[t]) {
+                            ASSERT_EQ(table->Upsert(wr), 0) << "Upsert failed";
+                        }
+                    });
+                }
+                for(auto &t : threads) {
+                    t.join();
+                }
+                auto end_time = std::chrono::high_resolution_clock::now();
+                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+                LOG_INFO("shards = %u, threads = %d, syncs = %lu, throughput = %.0f rows/s",
+                         shard_count, thread_count, table->TestGetLogSyncCount(),
+                         static_cast<double>(thread_count) * rows_per_thread * 1e6 / static_cast<double>(duration));
+
+                auto qr = test.GenerateLatestQueryRequest(0, thread_count * 20);
+                std::vector<Row> results;
+                ASSERT_EQ(table->ExecuteLatestQuery(qr, results), 0) << "ExecuteLatestQuery failed";
+                test.CheckLastQuery(results, qr, true);
+
+                table->Shutdown();
+                table->EraseLogFile();
+                options->bg_task_->WaitForEmptyQueue();
+                table->EraseSSTableFile();
+            }
+        }
+    }
+
+} // namespace LindormContest